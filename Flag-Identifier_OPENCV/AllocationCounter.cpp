@@ -0,0 +1,131 @@
+/*********************************************************************
+ * @file       AllocationCounter.cpp
+ * @brief      AllocationCounter counts heap allocations made while it is
+ *              started, to check that a warm query doesn't allocate.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "AllocationCounter.h"
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace cv;
+
+// Allocations are only counted while counting is true, so outside of a
+// benchmark operator new costs one relaxed load
+static std::atomic<bool> counting(false);
+static std::atomic<int64_t> allocations(0);
+
+#if CV_VERSION_MAJOR >= 4
+typedef AccessFlag MatAccessFlag;
+#else
+typedef int MatAccessFlag;
+#endif
+
+/**
+ * @class CountingMatAllocator counts each new Mat buffer and leaves the
+ *        work to OpenCV's standard allocator, which also frees it
+ */
+class CountingMatAllocator : public MatAllocator {
+  public:
+
+  /**
+   * @brief Counts and allocates a Mat buffer
+   */
+  UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, MatAccessFlag flags,
+                     UMatUsageFlags usage_flags) const {
+
+    // Mats over memory that already exists don't allocate
+    if (data == nullptr) {
+      allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+  }
+
+  /**
+   * @brief Allocates the buffer of existing Mat data
+   */
+  bool allocate(UMatData* data, MatAccessFlag access_flags, UMatUsageFlags usage_flags) const {
+    return Mat::getStdAllocator()->allocate(data, access_flags, usage_flags);
+  }
+
+  /**
+   * @brief Frees a Mat buffer
+   */
+  void deallocate(UMatData* data) const {
+    Mat::getStdAllocator()->deallocate(data);
+  }
+};
+
+static CountingMatAllocator counting_allocator;
+static MatAllocator* previous_allocator = nullptr;
+
+/**
+ * @brief Starts counting from 0
+ */
+void AllocationCounter::start() {
+  previous_allocator = Mat::getDefaultAllocator();
+  Mat::setDefaultAllocator(&counting_allocator);
+  allocations.store(0);
+  counting.store(true);
+}
+
+/**
+ * @brief Stops counting and restores the default MatAllocator
+ *
+ * @return number of allocations since start
+ */
+int64_t AllocationCounter::stop() {
+  counting.store(false);
+  Mat::setDefaultAllocator(previous_allocator);
+  return allocations.load();
+}
+
+/**
+ * @brief Default constructor is private and doesn't allow calling
+ */
+AllocationCounter::AllocationCounter() {
+  // Do nothing
+}
+
+// Replacements of the global operator new and delete, allocating with
+// malloc the same as the standard library
+void* operator new(std::size_t size) {
+  if (counting.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,46 @@
+/*********************************************************************
+ * @file       AllocationCounter.h
+ * @brief      AllocationCounter counts heap allocations made while it is
+ *              started, to check that a warm query doesn't allocate.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @class AllocationCounter counts every operator new of the program and
+ *        every Mat buffer, through a counting MatAllocator that is the
+ *        default while counting. Allocations inside OpenCV that don't go
+ *        through either, such as its AutoBuffer, are not seen. Only one
+ *        count runs at a time, and it counts every thread.
+ */
+class AllocationCounter {
+  public:
+
+  /**
+   * @brief Starts counting from 0
+   */
+  static void start();
+
+  /**
+   * @brief Stops counting and restores the default MatAllocator
+   *
+   * @return number of allocations since start
+   */
+  static int64_t stop();
+
+  private:
+
+  /**
+   * @brief Default constructor is private and doesn't allow calling
+   */
+  AllocationCounter();
+};
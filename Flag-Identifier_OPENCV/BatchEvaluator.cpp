@@ -0,0 +1,434 @@
+/*********************************************************************
+ * @file       BatchEvaluator.cpp
+ * @brief      BatchEvaluator runs findFlag over a directory or manifest of
+ *              test images without any windows and reports the accuracy
+ *              and latency of every step.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "BatchEvaluator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "JsonFormat.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Quotes a CSV field if it holds a comma or quote
+ *
+ * @param text field to quote
+ * @return field safe to write to a CSV line
+ */
+static std::string quoteCsv(const std::string& text) {
+  if (text.find_first_of(",\"\n") == std::string::npos) {
+    return text;
+  }
+  std::string result = "\"";
+  for (char c : text) {
+    if (c == '"') {
+      result += '"';
+    }
+    result += c;
+  }
+  return result + "\"";
+}
+
+/**
+ * @brief Joins the flag names of a result with ';'
+ *
+ * @param result result to join
+ * @param index flag metadata the result ids point into
+ * @return flag names separated by ';'
+ */
+static std::string joinFlags(const FlagResult& result, const FlagIndex& index) {
+  std::string joined;
+  for (int flag : result.flags) {
+    if (!joined.empty()) {
+      joined += ';';
+    }
+    joined += index.getName(flag);
+  }
+  return joined;
+}
+
+/**
+ * @brief Sums the time of every step that ran for a result
+ *
+ * @param result result to sum
+ * @return milliseconds spent in findFlag
+ */
+static double totalMs(const FlagResult& result) {
+  double total = 0.0;
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    if (result.stage_ms[stage] >= 0.0) {
+      total += result.stage_ms[stage];
+    }
+  }
+  return total;
+}
+
+/**
+ * @brief Constructor for an evaluator with no test images
+ *
+ * @param finder finder to run each image through
+ * @param index flag metadata used to recognize labels
+ */
+BatchEvaluator::BatchEvaluator(const FlagFinder& finder, const FlagIndex& index)
+  : finder_(finder), index_(index), run_ms_(0.0), num_threads_(0) {}
+
+/**
+ * @brief Adds test images from a directory or a manifest file. A manifest
+ *        has one "path,label" line per image, relative paths are relative
+ *        to the manifest. Images in a directory are labeled with their
+ *        file name when it is the name of a flag in the index.
+ *
+ * @param source directory or manifest file
+ * @return true if the source could be read
+ */
+bool BatchEvaluator::loadInputs(const std::string& source) {
+  std::error_code error;
+
+  // Directory of images, sorted so every run has the same order
+  if (fs::is_directory(source, error)) {
+    std::vector<std::string> paths;
+    for (const fs::directory_entry& entry : fs::directory_iterator(source, error)) {
+      std::string extension = entry.path().extension().string();
+      std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+      if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg" || extension == ".png")) {
+        paths.push_back(entry.path().string());
+      }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const std::string& path : paths) {
+      BatchItem item;
+      item.path = path;
+      std::string stem = fs::path(path).stem().string();
+      if (index_.getId(stem) >= 0) {
+        item.label = stem;
+      }
+      items_.push_back(item);
+    }
+    return !error;
+  }
+
+  // Manifest of "path,label" lines
+  std::ifstream manifest(source);
+  if (!manifest) {
+    return false;
+  }
+  fs::path base = fs::path(source).parent_path();
+
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    BatchItem item;
+    size_t comma = line.find(',');
+    item.path = line.substr(0, comma);
+    if (comma != std::string::npos) {
+      item.label = line.substr(comma + 1);
+    }
+    if (fs::path(item.path).is_relative()) {
+      item.path = (base / item.path).string();
+    }
+    items_.push_back(item);
+  }
+  return true;
+}
+
+/**
+ * @brief Runs findFlag on every test image
+ *
+ * @param num_threads number of worker threads, 0 for one per core
+ */
+void BatchEvaluator::run(int num_threads) {
+  std::vector<std::string> paths;
+  for (const BatchItem& item : items_) {
+    paths.push_back(item.path);
+  }
+
+  // Start the workers before the clock so only searching is timed
+  BatchQueryEngine engine(finder_, num_threads);
+  num_threads_ = engine.getThreadCount();
+
+  std::vector<FlagResult> results;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  engine.run(paths, results);
+  run_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  for (size_t i = 0; i < items_.size(); ++i) {
+    items_.at(i).result = results.at(i);
+  }
+}
+
+/**
+ * @brief Writes one line per test image with its prediction and timings
+ *
+ * @param path CSV file to write
+ * @return true if the file was written
+ */
+bool BatchEvaluator::writeCsv(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+
+  out << "image,label,prediction,candidates,correct,deciding_stage";
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    out << "," << quoteCsv(std::string(getStageName((FlagStage)stage)) + " ms");
+  }
+  out << ",total ms" << "\n";
+
+  out << std::fixed << std::setprecision(4);
+  for (const BatchItem& item : items_) {
+    const FlagResult& result = item.result;
+    out << quoteCsv(item.path) << "," << quoteCsv(item.label) << ","
+        << quoteCsv(joinFlags(result, index_)) << "," << result.flags.size() << ","
+        << (item.label.empty() ? "" : (isCorrect(item) ? "1" : "0")) << ","
+        << quoteCsv(result.decoded ? getStageName(result.deciding_stage) : "Unreadable");
+    for (int stage = 0; stage < kNumStages; ++stage) {
+      out << ",";
+      if (result.stage_ms[stage] >= 0.0) {
+        out << result.stage_ms[stage];
+      }
+    }
+    out << "," << totalMs(result) << "\n";
+  }
+  return (bool)out;
+}
+
+/**
+ * @brief Writes the summary, step latencies and every prediction
+ *
+ * @param path JSON file to write
+ * @return true if the file was written
+ */
+bool BatchEvaluator::writeJson(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+
+  int labeled = 0;
+  int correct = 0;
+  for (const BatchItem& item : items_) {
+    if (!item.label.empty()) {
+      ++labeled;
+      correct += isCorrect(item) ? 1 : 0;
+    }
+  }
+  double seconds = run_ms_ / 1000.0;
+
+  out << std::fixed << std::setprecision(4);
+  out << "{\n  \"summary\": {\n"
+      << "    \"images\": " << items_.size() << ",\n"
+      << "    \"labeled\": " << labeled << ",\n"
+      << "    \"correct\": " << correct << ",\n"
+      << "    \"accuracy\": " << (labeled > 0 ? (double)correct / labeled : 0.0) << ",\n"
+      << "    \"threads\": " << num_threads_ << ",\n"
+      << "    \"wall_ms\": " << run_ms_ << ",\n"
+      << "    \"images_per_second\": " << (seconds > 0.0 ? items_.size() / seconds : 0.0) << "\n"
+      << "  },\n";
+
+  // Latency percentiles of every step and of the whole call
+  out << "  \"stages\": {\n";
+  for (int stage = 0; stage <= kNumStages; ++stage) {
+    std::string name = stage < kNumStages ? getStageName((FlagStage)stage) : "Total";
+    out << "    \"" << escapeJson(name) << "\": { \"count\": " << getStageCount(stage)
+        << ", \"p50_ms\": " << getPercentile(stage, 50.0)
+        << ", \"p95_ms\": " << getPercentile(stage, 95.0)
+        << ", \"p99_ms\": " << getPercentile(stage, 99.0) << " }"
+        << (stage < kNumStages ? "," : "") << "\n";
+  }
+  out << "  },\n";
+
+  // Prediction of every image
+  out << "  \"images\": [\n";
+  for (size_t i = 0; i < items_.size(); ++i) {
+    const BatchItem& item = items_.at(i);
+    out << "    { \"image\": \"" << escapeJson(item.path) << "\", \"label\": \"" << escapeJson(item.label)
+        << "\", \"prediction\": [";
+    bool first = true;
+    for (int flag : item.result.flags) {
+      out << (first ? "" : ", ") << "\"" << escapeJson(index_.getName(flag)) << "\"";
+      first = false;
+    }
+    out << "]";
+
+    // Feature distance of each prediction after a nearest neighbor search
+    if (!item.result.neighbors.empty()) {
+      out << ", \"distances\": [";
+      for (size_t n = 0; n < item.result.neighbors.size(); ++n) {
+        out << (n > 0 ? ", " : "") << item.result.neighbors.at(n).distance;
+      }
+      out << "]";
+    }
+    out << ", \"deciding_stage\": \""
+        << escapeJson(item.result.decoded ? getStageName(item.result.deciding_stage) : "Unreadable")
+        << "\", \"total_ms\": " << totalMs(item.result) << " }"
+        << (i + 1 < items_.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+  return (bool)out;
+}
+
+/**
+ * @brief Prints the accuracy, throughput and step latencies
+ *
+ * @param out stream to print to
+ */
+void BatchEvaluator::printSummary(std::ostream& out) const {
+  int labeled = 0;
+  int correct = 0;
+  int unreadable = 0;
+  int no_match = 0;
+  int ambiguous = 0;
+  for (const BatchItem& item : items_) {
+    if (!item.result.decoded) {
+      ++unreadable;
+    } else if (item.result.flags.empty()) {
+      ++no_match;
+    } else if (item.result.flags.size() > 1) {
+      ++ambiguous;
+    }
+    if (!item.label.empty()) {
+      ++labeled;
+      correct += isCorrect(item) ? 1 : 0;
+    }
+  }
+  double seconds = run_ms_ / 1000.0;
+
+  out << "Images: " << items_.size() << " (" << unreadable << " unreadable, "
+      << no_match << " no match, " << ambiguous << " more than one flag)" << std::endl;
+  if (labeled > 0) {
+    out << "Accuracy: " << correct << " / " << labeled << " labeled images ("
+        << std::fixed << std::setprecision(1) << 100.0 * correct / labeled << "%)" << std::endl;
+  }
+  out << "Throughput: " << std::fixed << std::setprecision(2)
+      << (seconds > 0.0 ? items_.size() / seconds : 0.0) << " images/s over "
+      << run_ms_ << " ms on " << num_threads_ << " threads" << std::endl;
+
+  out << std::left << std::setw(38) << "Step" << std::right << std::setw(8) << "count"
+      << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "p99 ms" << std::endl;
+  for (int stage = 0; stage <= kNumStages; ++stage) {
+    std::string name = stage < kNumStages ? getStageName((FlagStage)stage) : "Total";
+    out << std::left << std::setw(38) << name << std::right << std::setw(8) << getStageCount(stage)
+        << std::setprecision(3) << std::setw(10) << getPercentile(stage, 50.0)
+        << std::setw(10) << getPercentile(stage, 95.0) << std::setw(10) << getPercentile(stage, 99.0) << std::endl;
+  }
+}
+
+/**
+ * @brief Getter for the test images and their results
+ *
+ * @return test images in the order they were loaded
+ */
+const std::vector<BatchItem>& BatchEvaluator::getItems() const {
+  return items_;
+}
+
+/**
+ * @brief Returns the given percentile of a step's latency over every image
+ *        the step ran for
+ *
+ * @param stage step to measure, kNumStages for the whole findFlag call
+ * @param percentile percentile from 0 to 100
+ * @return latency in milliseconds, 0 if the step never ran
+ */
+double BatchEvaluator::getPercentile(int stage, double percentile) const {
+  std::vector<double> latencies;
+  for (const BatchItem& item : items_) {
+    if (stage == kNumStages) {
+      latencies.push_back(totalMs(item.result));
+    } else if (item.result.stage_ms[stage] >= 0.0) {
+      latencies.push_back(item.result.stage_ms[stage]);
+    }
+  }
+  if (latencies.empty()) {
+    return 0.0;
+  }
+
+  // Nearest rank percentile
+  std::sort(latencies.begin(), latencies.end());
+  int rank = (int)std::ceil(percentile / 100.0 * latencies.size());
+  rank = std::max(1, std::min(rank, (int)latencies.size()));
+  return latencies.at(rank - 1);
+}
+
+/**
+ * @brief Returns the number of images a step ran for
+ *
+ * @param stage step to count, kNumStages for the whole findFlag call
+ * @return number of images
+ */
+int BatchEvaluator::getStageCount(int stage) const {
+  if (stage == kNumStages) {
+    return (int)items_.size();
+  }
+
+  int count = 0;
+  for (const BatchItem& item : items_) {
+    if (item.result.stage_ms[stage] >= 0.0) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Checks if the result for an item is exactly its label. A label
+ *        naming a group is matched by any variant of the group. After a
+ *        nearest neighbor search or ranking the closest flag is the
+ *        prediction.
+ *
+ * @param item test image to check
+ * @return true if every flag found, or the closest one, is the label
+ */
+bool BatchEvaluator::isCorrect(const BatchItem& item) const {
+  const FlagResult& result = item.result;
+  if (result.flags.empty()) {
+    return false;
+  }
+  if (!result.neighbors.empty()) {
+    return matchesLabel(result.flags.front(), item.label);
+  }
+
+  // Names are unique, so without groups only a single flag can match
+  for (int flag : result.flags) {
+    if (!matchesLabel(flag, item.label)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checks if a flag is the one a label names
+ *
+ * @param flag position of the flag in the index
+ * @param label name of a flag or of a group of variants
+ * @return true if the flag has the name or is in the group
+ */
+bool BatchEvaluator::matchesLabel(int flag, const std::string& label) const {
+  return label == index_.getName(flag) || label == index_.getGroup(flag);
+}
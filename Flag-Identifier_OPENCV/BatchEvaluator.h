@@ -0,0 +1,154 @@
+/*********************************************************************
+ * @file       BatchEvaluator.h
+ * @brief      BatchEvaluator runs findFlag over a directory or manifest of
+ *              test images without any windows and reports the accuracy
+ *              and latency of every step.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BatchQueryEngine.h"
+#include "FlagFinder.h"
+#include "FlagIndex.h"
+
+/**
+ * @brief BatchItem is one test image of a batch and what was found for it
+ */
+struct BatchItem {
+
+  // Image file to test
+  std::string path;
+
+  // Name of the flag in the image, empty if not known
+  std::string label;
+
+  // Result of findFlag for the image
+  FlagResult result;
+};
+
+/**
+ * @class BatchEvaluator runs a list of labeled test images through findFlag
+ *        and writes per image predictions and a latency summary as CSV and
+ *        JSON.
+ */
+class BatchEvaluator {
+  public:
+
+  /**
+   * @brief Constructor for an evaluator with no test images
+   *
+   * @param finder finder to run each image through
+   * @param index flag metadata used to recognize labels
+   */
+  BatchEvaluator(const FlagFinder& finder, const FlagIndex& index);
+
+  /**
+   * @brief Adds test images from a directory or a manifest file. A manifest
+   *        has one "path,label" line per image, relative paths are relative
+   *        to the manifest. Images in a directory are labeled with their
+   *        file name when it is the name of a flag in the index.
+   *
+   * @param source directory or manifest file
+   * @return true if the source could be read
+   */
+  bool loadInputs(const std::string& source);
+
+  /**
+   * @brief Runs findFlag on every test image
+   *
+   * @param num_threads number of worker threads, 0 for one per core
+   */
+  void run(int num_threads);
+
+  /**
+   * @brief Writes one line per test image with its prediction and timings
+   *
+   * @param path CSV file to write
+   * @return true if the file was written
+   */
+  bool writeCsv(const std::string& path) const;
+
+  /**
+   * @brief Writes the summary, step latencies and every prediction
+   *
+   * @param path JSON file to write
+   * @return true if the file was written
+   */
+  bool writeJson(const std::string& path) const;
+
+  /**
+   * @brief Prints the accuracy, throughput and step latencies
+   *
+   * @param out stream to print to
+   */
+  void printSummary(std::ostream& out) const;
+
+  /**
+   * @brief Getter for the test images and their results
+   *
+   * @return test images in the order they were loaded
+   */
+  const std::vector<BatchItem>& getItems() const;
+
+  /**
+   * @brief Checks if the result for an item is exactly its label. A label
+   *        naming a group is matched by any variant of the group. After a
+   *        nearest neighbor search or ranking the closest flag is the
+   *        prediction.
+   *
+   * @param item test image to check
+   * @return true if every flag found, or the closest one, is the label
+   */
+  bool isCorrect(const BatchItem& item) const;
+
+  /**
+   * @brief Checks if a flag is the one a label names
+   *
+   * @param flag position of the flag in the index
+   * @param label name of a flag or of a group of variants
+   * @return true if the flag has the name or is in the group
+   */
+  bool matchesLabel(int flag, const std::string& label) const;
+
+  private:
+
+  /**
+   * @brief Returns the given percentile of a step's latency over every image
+   *        the step ran for
+   *
+   * @param stage step to measure, kNumStages for the whole findFlag call
+   * @param percentile percentile from 0 to 100
+   * @return latency in milliseconds, 0 if the step never ran
+   */
+  double getPercentile(int stage, double percentile) const;
+
+  /**
+   * @brief Returns the number of images a step ran for
+   *
+   * @param stage step to count, kNumStages for the whole findFlag call
+   * @return number of images
+   */
+  int getStageCount(int stage) const;
+
+  // Finder that runs the filters and metadata it searches
+  const FlagFinder& finder_;
+  const FlagIndex& index_;
+
+  // Test images in the order they were loaded
+  std::vector<BatchItem> items_;
+
+  // Wall clock milliseconds and worker threads of the last run
+  double run_ms_;
+  int num_threads_;
+};
@@ -0,0 +1,128 @@
+/*********************************************************************
+ * @file       BatchQueryEngine.cpp
+ * @brief      BatchQueryEngine runs findFlag for many test images at once
+ *              on a pool of worker threads sharing one read-only index.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "BatchQueryEngine.h"
+
+/**
+ * @brief Constructor starts the worker threads
+ *
+ * @param finder finder shared by every worker
+ * @param num_threads number of workers, 0 for one per core
+ */
+BatchQueryEngine::BatchQueryEngine(const FlagFinder& finder, int num_threads)
+  : finder_(&finder), pool_(WorkStealingPool::chooseThreadCount(num_threads)) {
+  scratch_.resize(pool_.getThreadCount());
+}
+
+/**
+ * @brief Constructor starts the worker threads without a finder, which
+ *        has to be set before the first run
+ *
+ * @param num_threads number of workers, 0 for one per core
+ */
+BatchQueryEngine::BatchQueryEngine(int num_threads)
+  : finder_(nullptr), pool_(WorkStealingPool::chooseThreadCount(num_threads)) {
+  scratch_.resize(pool_.getThreadCount());
+}
+
+/**
+ * @brief Setter for the finder the next runs search with. Must not be
+ *        called while a run is in progress.
+ *
+ * @param finder finder shared by every worker
+ */
+void BatchQueryEngine::setFinder(const FlagFinder& finder) {
+  finder_ = &finder;
+}
+
+/**
+ * @brief Reads and searches every image file
+ *
+ * @param filenames images to test
+ * @param results one result per image, in the same order as filenames
+ */
+void BatchQueryEngine::run(const std::vector<std::string>& filenames, std::vector<FlagResult>& results) {
+  results.assign(filenames.size(), FlagResult());
+  int opencv_threads = limitOpenCVThreads();
+
+  // Each image writes only its own result, workers only their own scratch
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    pool_.submit([this, &filenames, &results, i](int worker) {
+      finder_->findFlag(filenames.at(i), results.at(i), scratch_.at(worker));
+    });
+  }
+  pool_.wait();
+  setNumThreads(opencv_threads);
+}
+
+/**
+ * @brief Searches every decoded image
+ *
+ * @param images images to test
+ * @param results one result per image, in the same order as images
+ */
+void BatchQueryEngine::run(const std::vector<Mat>& images, std::vector<FlagResult>& results) {
+  results.assign(images.size(), FlagResult());
+  int opencv_threads = limitOpenCVThreads();
+
+  for (size_t i = 0; i < images.size(); ++i) {
+    pool_.submit([this, &images, &results, i](int worker) {
+      finder_->findFlag(images.at(i), results.at(i), scratch_.at(worker));
+    });
+  }
+  pool_.wait();
+  setNumThreads(opencv_threads);
+}
+
+/**
+ * @brief Decodes and searches every encoded image. Images are decoded on
+ *        the workers, not the calling thread.
+ *
+ * @param buffers bytes of each image file
+ * @param results one result per image, in the same order as buffers
+ */
+void BatchQueryEngine::run(const std::vector<std::vector<uchar>>& buffers, std::vector<FlagResult>& results) {
+  results.assign(buffers.size(), FlagResult());
+  int opencv_threads = limitOpenCVThreads();
+
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    pool_.submit([this, &buffers, &results, i](int worker) {
+      finder_->findFlag(buffers.at(i), results.at(i), scratch_.at(worker));
+    });
+  }
+  pool_.wait();
+  setNumThreads(opencv_threads);
+}
+
+/**
+ * @brief Stops OpenCV from starting its own threads inside each call while
+ *        the workers already use every core
+ *
+ * @return number of OpenCV threads to restore after the run
+ */
+int BatchQueryEngine::limitOpenCVThreads() const {
+  int opencv_threads = getNumThreads();
+  if (pool_.getThreadCount() > 1) {
+    setNumThreads(1);
+  }
+  return opencv_threads;
+}
+
+/**
+ * @brief Getter for the number of workers
+ *
+ * @return number of worker threads
+ */
+int BatchQueryEngine::getThreadCount() const {
+  return pool_.getThreadCount();
+}
@@ -0,0 +1,106 @@
+/*********************************************************************
+ * @file       BatchQueryEngine.h
+ * @brief      BatchQueryEngine runs findFlag for many test images at once
+ *              on a pool of worker threads sharing one read-only index.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "FlagFinder.h"
+#include "WorkStealingPool.h"
+
+using namespace cv;
+
+/**
+ * @class BatchQueryEngine spreads findFlag calls over a WorkStealingPool. The
+ *        finder and its index are only read, every worker has its own
+ *        FlagScratch, and results are written to the position of their input
+ *        so the output is the same for any number of threads.
+ */
+class BatchQueryEngine {
+  public:
+
+  /**
+   * @brief Constructor starts the worker threads
+   *
+   * @param finder finder shared by every worker
+   * @param num_threads number of workers, 0 for one per core
+   */
+  BatchQueryEngine(const FlagFinder& finder, int num_threads);
+
+  /**
+   * @brief Constructor starts the worker threads without a finder, which
+   *        has to be set before the first run
+   *
+   * @param num_threads number of workers, 0 for one per core
+   */
+  explicit BatchQueryEngine(int num_threads);
+
+  /**
+   * @brief Setter for the finder the next runs search with. Must not be
+   *        called while a run is in progress.
+   *
+   * @param finder finder shared by every worker
+   */
+  void setFinder(const FlagFinder& finder);
+
+  /**
+   * @brief Reads and searches every image file
+   *
+   * @param filenames images to test
+   * @param results one result per image, in the same order as filenames
+   */
+  void run(const std::vector<std::string>& filenames, std::vector<FlagResult>& results);
+
+  /**
+   * @brief Searches every decoded image
+   *
+   * @param images images to test
+   * @param results one result per image, in the same order as images
+   */
+  void run(const std::vector<Mat>& images, std::vector<FlagResult>& results);
+
+  /**
+   * @brief Decodes and searches every encoded image. Images are decoded on
+   *        the workers, not the calling thread.
+   *
+   * @param buffers bytes of each image file
+   * @param results one result per image, in the same order as buffers
+   */
+  void run(const std::vector<std::vector<uchar>>& buffers, std::vector<FlagResult>& results);
+
+  /**
+   * @brief Getter for the number of workers
+   *
+   * @return number of worker threads
+   */
+  int getThreadCount() const;
+
+  private:
+
+  /**
+   * @brief Stops OpenCV from starting its own threads inside each call while
+   *        the workers already use every core
+   *
+   * @return number of OpenCV threads to restore after the run
+   */
+  int limitOpenCVThreads() const;
+
+  // Finder of the next run, not owned
+  const FlagFinder* finder_;
+  WorkStealingPool pool_;
+
+  // Buffers of each worker, indexed by worker number
+  std::vector<FlagScratch> scratch_;
+};
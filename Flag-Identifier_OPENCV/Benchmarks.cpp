@@ -0,0 +1,605 @@
+/*********************************************************************
+ * @file       Benchmarks.cpp
+ * @brief      Benchmarks times the building blocks of the flag filters so
+ *              changes to them can be measured.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "Benchmarks.h"
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AllocationCounter.h"
+#include "BatchEvaluator.h"
+#include "BucketIndex.h"
+#include "CandidateSet.h"
+#include "ColorQuantizer.h"
+#include "CommonColorFinder.h"
+#include "EdgeRatioFinder.h"
+#include "FeatureArena.h"
+#include "FlagFinder.h"
+#include "ImageDecoder.h"
+#include "ReferenceList.h"
+
+using namespace cv;
+
+// Slowdown a step needs on top of the threshold to count as a regression in
+// compareBaseline, so steps of a few microseconds don't fail on timer noise
+static const double kRegressionFloorMs = 0.002;
+
+/**
+ * @brief Runs a function until at least min_ms milliseconds and 3 runs have
+ *        passed
+ *
+ * @param function function to time
+ * @param min_ms minimum milliseconds to keep running for
+ * @return average milliseconds per run
+ */
+static double timeMs(const std::function<void()>& function, double min_ms) {
+  typedef std::chrono::steady_clock Clock;
+
+  // One run first so caches and lazy allocations don't count
+  function();
+
+  int runs = 0;
+  double elapsed = 0.0;
+  Clock::time_point start = Clock::now();
+  while (runs < 3 || elapsed < min_ms) {
+    function();
+    ++runs;
+    elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+  return elapsed / runs;
+}
+
+/**
+ * @brief Creates an image of three horizontal stripes with a block in the
+ *        upper left, which has the long same color runs of a real flag
+ *
+ * @param rows rows of the image
+ * @param cols columns of the image
+ * @return BGR flag-like image
+ */
+static Mat makeStripedImage(int rows, int cols) {
+  Mat image(rows, cols, CV_8UC3);
+  image(Range(0, rows / 3), Range::all()) = Scalar(40, 30, 200);
+  image(Range(rows / 3, 2 * rows / 3), Range::all()) = Scalar(250, 250, 250);
+  image(Range(2 * rows / 3, rows), Range::all()) = Scalar(120, 40, 20);
+  image(Range(0, rows / 2), Range(0, cols / 3)) = Scalar(20, 160, 60);
+  return image;
+}
+
+/**
+ * @brief Times CommonColorFinder::populateHistogram against the per pixel
+ *        reference version on 360x240 and 3840x2160 images, both random noise
+ *        and flag-like stripes, in the color scheme in use, and checks they
+ *        count the same histogram
+ *
+ * @param out stream to print the timings to
+ * @return true if every histogram matched the reference
+ */
+bool benchmarkHistogram(std::ostream& out) {
+  const int sizes[][2] = { { 240, 360 }, { 2160, 3840 } };
+  const double min_ms = 250.0;
+  bool matched = true;
+
+  out << std::left << std::setw(24) << "Image" << std::right << std::setw(16) << "reference ms"
+      << std::setw(12) << "fast ms" << std::setw(10) << "speedup" << std::setw(8) << "same" << std::endl;
+
+  ColorScheme scheme = ColorQuantizer::getScheme();
+  for (const int* size : sizes) {
+    for (int pattern = 0; pattern < 2; ++pattern) {
+      Mat image;
+      if (pattern == 0) {
+        image.create(size[0], size[1], CV_8UC3);
+        randu(image, Scalar::all(0), Scalar::all(256));
+      } else {
+        image = makeStripedImage(size[0], size[1]);
+      }
+
+      Mat reference = CommonColorFinder::populateHistogramReference(image);
+      Mat fast = CommonColorFinder::populateHistogram(image);
+      bool same = norm(reference, fast, NORM_L1) == 0.0;
+      matched = matched && same;
+
+      double reference_ms = timeMs([&image] { CommonColorFinder::populateHistogramReference(image); }, min_ms);
+      double fast_ms = timeMs([&image] { CommonColorFinder::populateHistogram(image); }, min_ms);
+
+      std::string name = std::to_string(size[1]) + "x" + std::to_string(size[0]) + (pattern == 0 ? " noise " : " stripes ") +
+        ColorQuantizer::getSchemeName(scheme);
+      out << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+          << std::setw(16) << reference_ms << std::setw(12) << fast_ms
+          << std::setprecision(1) << std::setw(9) << reference_ms / fast_ms << "x"
+          << std::setw(8) << (same ? "yes" : "NO") << std::endl;
+    }
+  }
+  return matched;
+}
+
+/**
+ * @brief Times EdgeRatioFinder::getEdgeRatio against the OpenCV cvtColor,
+ *        GaussianBlur and Canny chain on 360x240 and 3840x2160 images, both
+ *        random noise and flag-like stripes, whole and as an upper left
+ *        quadrant view, and checks they count exactly the same edges
+ *
+ * @param out stream to print the timings to
+ * @return true if every edge count matched the chain
+ */
+bool benchmarkEdges(std::ostream& out) {
+  const int sizes[][2] = { { 240, 360 }, { 2160, 3840 } };
+  const double min_ms = 250.0;
+  bool matched = true;
+  FeatureArena arena;
+
+  out << std::left << std::setw(24) << "Image" << std::right << std::setw(16) << "reference ms"
+      << std::setw(12) << "fused ms" << std::setw(10) << "speedup" << std::setw(14) << "edges off" << std::endl;
+
+  for (const int* size : sizes) {
+    for (int pattern = 0; pattern < 4; ++pattern) {
+      Mat image;
+      if (pattern % 2 == 0) {
+        image.create(size[0], size[1], CV_8UC3);
+        randu(image, Scalar::all(0), Scalar::all(256));
+      } else {
+        image = makeStripedImage(size[0], size[1]);
+      }
+      if (pattern >= 2) {
+        image = getRegion(image, kRegionUpperLeft);
+      }
+
+      // Both divide the edge count by the same pixel count, so the ratios
+      // are equal exactly when the counts are. The fused kernel counts the
+      // same pixels, so any difference at all is a bug.
+      float reference = EdgeRatioFinder::getEdgeRatioReference(image);
+      float fused = EdgeRatioFinder::getEdgeRatio(image, arena);
+      long edges_off = std::lround((double)std::abs(reference - fused) * (double)image.total());
+      matched = matched && reference == fused;
+
+      double reference_ms = timeMs([&image] { EdgeRatioFinder::getEdgeRatioReference(image); }, min_ms);
+      double fused_ms = timeMs([&image, &arena] { EdgeRatioFinder::getEdgeRatio(image, arena); }, min_ms);
+
+      std::string name = std::to_string(image.cols) + "x" + std::to_string(image.rows) +
+        (pattern % 2 == 0 ? " noise" : " stripes") + (pattern >= 2 ? " view" : "");
+      out << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+          << std::setw(16) << reference_ms << std::setw(12) << fused_ms
+          << std::setprecision(1) << std::setw(9) << reference_ms / fused_ms << "x"
+          << std::setw(14) << edges_off << std::endl;
+    }
+  }
+  return matched;
+}
+
+/**
+ * @brief Runs a directory or manifest of test images through findFlag with
+ *        full size decoding and with reduced jpg decoding, prints the summary
+ *        of both and counts the images whose prediction changed
+ *
+ * @param index flag metadata to search
+ * @param source directory or manifest of test images, see
+ *        BatchEvaluator::loadInputs
+ * @param num_threads number of worker threads, 0 for one per core
+ * @param out stream to print the comparison to
+ * @return true if reduced decoding got at least as many labeled images right
+ */
+bool benchmarkDecode(const FlagIndex& index, const std::string& source, int num_threads, std::ostream& out) {
+  FlagFinder full_finder(index);
+  full_finder.setReducedDecode(false);
+  FlagFinder reduced_finder(index);
+  reduced_finder.setReducedDecode(true);
+
+  BatchEvaluator full(full_finder, index);
+  BatchEvaluator reduced(reduced_finder, index);
+  if (!full.loadInputs(source) || !reduced.loadInputs(source)) {
+    out << "Could not read test images from \"" << source << "\"" << std::endl;
+    return false;
+  }
+
+  full.run(num_threads);
+  reduced.run(num_threads);
+  out << "Full size decode" << std::endl;
+  full.printSummary(out);
+  out << std::endl << "Reduced decode" << std::endl;
+  reduced.printSummary(out);
+
+  // Both evaluators loaded the same images in the same order
+  const std::vector<BatchItem>& full_items = full.getItems();
+  const std::vector<BatchItem>& reduced_items = reduced.getItems();
+  int changed = 0;
+  int full_correct = 0;
+  int reduced_correct = 0;
+  for (size_t i = 0; i < full_items.size(); ++i) {
+    const BatchItem& full_item = full_items.at(i);
+    const BatchItem& reduced_item = reduced_items.at(i);
+    if (full_item.result.flags != reduced_item.result.flags) {
+      ++changed;
+      out << "Changed: " << full_item.path << std::endl;
+    }
+    if (!full_item.label.empty()) {
+      full_correct += full.isCorrect(full_item) ? 1 : 0;
+      reduced_correct += reduced.isCorrect(reduced_item) ? 1 : 0;
+    }
+  }
+
+  out << std::endl << "Predictions changed: " << changed << " of " << full_items.size() << std::endl;
+  out << "Correct: " << full_correct << " full size, " << reduced_correct << " reduced" << std::endl;
+  bool passed = reduced_correct >= full_correct;
+  out << (passed ? "No accuracy regression" : "ACCURACY REGRESSION") << std::endl;
+  return passed;
+}
+
+/**
+ * @brief Counts the heap allocations of findFlag on one encoded image once
+ *        its buffers are warm, with the bucket filters, the nearest neighbor
+ *        search and ranking. The image kernels the query ran (decode, resize
+ *        and edge ratio) are counted again on their own, since OpenCV keeps
+ *        temporaries the flag code can't reuse.
+ *
+ * @param index flag metadata to search
+ * @param path image file to search for
+ * @param out stream to print the counts to
+ * @return true if the flag code allocated nothing beyond the kernels
+ */
+bool benchmarkAllocations(const FlagIndex& index, const std::string& path, std::ostream& out) {
+  std::vector<uchar> encoded;
+  if (!ImageDecoder::readFile(path, encoded) || encoded.empty()) {
+    out << "Could not read \"" << path << "\"" << std::endl;
+    return false;
+  }
+
+  const int warm_up_runs = 3;
+  const int runs = 100;
+  const int nearest_k = 5;
+  const char* mode_names[] = { "Bucket filters", "Nearest neighbor search", "Ranking" };
+  bool passed = true;
+
+  out << std::left << std::setw(26) << "Search" << std::right << std::setw(14) << "per query"
+      << std::setw(14) << "in kernels" << std::setw(14) << "in flag code" << std::endl;
+  for (int mode = 0; mode < 3; ++mode) {
+    FlagFinder finder(index);
+    finder.setNearestNeighbors(mode == 1 ? nearest_k : 0);
+    finder.setRanking(mode == 2 ? nearest_k : 0);
+    FlagScratch scratch;
+    FlagResult result;
+
+    // Buffers grow to the size of this image on the first runs
+    for (int i = 0; i < warm_up_runs; ++i) {
+      finder.findFlag(encoded, result, scratch);
+    }
+    AllocationCounter::start();
+    for (int i = 0; i < runs; ++i) {
+      finder.findFlag(encoded, result, scratch);
+    }
+    int64_t query_allocations = AllocationCounter::stop();
+
+    // The kernels the last query ran, on buffers that are just as warm
+    bool resized = result.stage_ms[kStageResize] >= 0.0;
+    std::vector<FlagRegion> edge_regions;
+    if (mode == 1 || result.stage_ms[kStageScoreEdges] >= 0.0) {
+      for (int r = kRegionWhole; r <= kRegionLowerRight; ++r) {
+        edge_regions.push_back((FlagRegion)r);
+      }
+    } else if (mode == 0) {
+      if (result.edge_ratio >= 0.0f) {
+        edge_regions.push_back(kRegionWhole);
+      }
+      if (result.quadrant_edge_ratio >= 0.0f) {
+        edge_regions.push_back(kRegionUpperLeft);
+      }
+    }
+    Mat image;
+    Mat working_image;
+    FeatureArena arena;
+    std::function<void()> kernels = [&] {
+      ImageDecoder::decode(encoded, true, image);
+      if (resized) {
+        EdgeRatioFinder::resizeToWorkingSize(image, working_image);
+      }
+      for (FlagRegion region : edge_regions) {
+        EdgeRatioFinder::getEdgeRatio(getRegion(working_image, region), arena);
+      }
+    };
+    for (int i = 0; i < warm_up_runs; ++i) {
+      kernels();
+    }
+    AllocationCounter::start();
+    for (int i = 0; i < runs; ++i) {
+      kernels();
+    }
+    int64_t kernel_allocations = AllocationCounter::stop();
+
+    int64_t flag_allocations = query_allocations - kernel_allocations;
+    out << std::left << std::setw(26) << mode_names[mode]
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(14) << (double)query_allocations / runs
+        << std::setw(14) << (double)kernel_allocations / runs
+        << std::setw(14) << (double)std::max<int64_t>(flag_allocations, 0) / runs << std::endl;
+    passed = passed && flag_allocations <= 0;
+  }
+  return passed;
+}
+
+/**
+ * @brief Times each step of findFlag on its own over every image of the
+ *        sources: decoding, the color histogram, the most common and
+ *        dominant color buckets, resizing, the edge ratio, the bucket index
+ *        lookup of findClosestFlag, filterRatios, building a bucket index
+ *        and building the flag index. Then times findFlag end to end over
+ *        each source.
+ *
+ * @param index flag metadata to search
+ * @param reference_source directory or manifest of the reference flags the
+ *        index build is timed on
+ * @param sources directories or manifests of test images, see
+ *        BatchEvaluator::loadInputs
+ * @param timings set to the time of every step, in the order printed
+ * @param out stream to print the timings to
+ * @return false if a source or the reference flags could not be read
+ */
+bool benchmarkStages(const FlagIndex& index, const std::string& reference_source,
+                     const std::vector<std::string>& sources, std::vector<BenchmarkTiming>& timings,
+                     std::ostream& out) {
+  const double min_ms = 250.0;
+  FlagFinder finder(index);
+  timings.clear();
+
+  // Every image of every source, read once and decoded the way findFlag
+  // decodes them
+  std::vector<std::vector<uchar>> encoded;
+  std::vector<size_t> source_starts;
+  for (const std::string& source : sources) {
+    BatchEvaluator loader(finder, index);
+    if (!loader.loadInputs(source)) {
+      out << "Could not read test images from \"" << source << "\"" << std::endl;
+      return false;
+    }
+    source_starts.push_back(encoded.size());
+    for (const BatchItem& item : loader.getItems()) {
+      std::vector<uchar> bytes;
+      if (ImageDecoder::readFile(item.path, bytes) && !bytes.empty()) {
+        encoded.push_back(bytes);
+      }
+    }
+  }
+  source_starts.push_back(encoded.size());
+
+  std::vector<Mat> images(encoded.size());
+  std::vector<Mat> working_images(encoded.size());
+  std::vector<Mat> histograms(encoded.size());
+  std::vector<ColorBucket> image_buckets(encoded.size());
+  std::vector<ColorBucket> quadrant_buckets(encoded.size());
+  for (size_t i = 0; i < encoded.size(); ++i) {
+    ImageDecoder::decode(encoded[i], true, images[i]);
+    if (images[i].empty()) {
+      out << "Could not decode a test image of the sources" << std::endl;
+      return false;
+    }
+    EdgeRatioFinder::resizeToWorkingSize(images[i], working_images[i]);
+    image_buckets[i] = CommonColorFinder::getCommonColorBucket(images[i], histograms[i]);
+    quadrant_buckets[i] = CommonColorFinder::getCommonColorBucket(getRegion(working_images[i], kRegionUpperLeft));
+  }
+  if (images.empty()) {
+    out << "No test images in the sources" << std::endl;
+    return false;
+  }
+  const double num_images = (double)images.size();
+
+  CandidateSet all_flags;
+  all_flags.reset(index.getSize());
+  for (int id = 0; id < index.getSize(); ++id) {
+    all_flags.insert(id);
+  }
+
+  // Buffers are reused between runs like they are between queries
+  Mat image;
+  Mat working_image;
+  Mat histogram;
+  FeatureArena arena;
+  CandidateSet candidates;
+  BucketIndex bucket_index;
+  ColorBucket colors[kMaxDominantColors];
+  finder.buildBucketIndex(all_flags, bucket_index, kRegionUpperLeft);
+
+  out << "Timing each step over " << images.size() << " images" << std::endl;
+  timings.push_back({ "decode", timeMs([&] {
+    for (const std::vector<uchar>& bytes : encoded) {
+      ImageDecoder::decode(bytes, true, image);
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "populate_histogram", timeMs([&] {
+    for (const Mat& test_image : images) {
+      CommonColorFinder::populateHistogram(test_image, histogram);
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "common_color_bucket", timeMs([&] {
+    for (const Mat& test_image : images) {
+      CommonColorFinder::getCommonColorBucket(test_image, histogram);
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "dominant_buckets", timeMs([&] {
+    for (size_t i = 0; i < images.size(); ++i) {
+      CommonColorFinder::findDominantBuckets(histograms[i], images[i].rows * images[i].cols, colors);
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "resize", timeMs([&] {
+    for (const Mat& test_image : images) {
+      EdgeRatioFinder::resizeToWorkingSize(test_image, working_image);
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "edge_ratio", timeMs([&] {
+    for (const Mat& test_image : working_images) {
+      EdgeRatioFinder::getEdgeRatio(test_image, arena);
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "find_closest_flag", timeMs([&] {
+    for (const ColorBucket& bucket : quadrant_buckets) {
+      finder.findClosestFlag(bucket_index, bucket, candidates);
+    }
+  }, min_ms) / num_images });
+
+  // Each image starts from every flag, as if the MCC filter kept them all
+  const float* ratios = index.getCommonColorRatios(kRegionWhole);
+  timings.push_back({ "filter_ratios", timeMs([&] {
+    for (const ColorBucket& bucket : image_buckets) {
+      candidates = all_flags;
+      finder.filterRatios(candidates, ratios, bucket.getCommonColorRatio());
+    }
+  }, min_ms) / num_images });
+  timings.push_back({ "build_bucket_index", timeMs([&] {
+    finder.buildBucketIndex(all_flags, bucket_index, kRegionWhole);
+  }, min_ms) });
+
+  // The index build decodes every reference flag, timed per flag on one
+  // thread so it doesn't depend on the number of cores
+  std::vector<ReferenceEntry> references;
+  std::ostringstream build_log;
+  if (!ReferenceList::load(reference_source, references, out) || references.empty()) {
+    return false;
+  }
+  timings.push_back({ "index_build", timeMs([&] {
+    FlagIndex built;
+    built.build(references, 1, build_log);
+  }, 0.0) / references.size() });
+
+  // End to end on one thread, with the buffers of a warm worker
+  FlagScratch scratch;
+  FlagResult result;
+  for (size_t s = 0; s < sources.size(); ++s) {
+    size_t start = source_starts[s];
+    size_t end = source_starts[s + 1];
+    if (start == end) {
+      continue;
+    }
+    timings.push_back({ "find_flag:" + sources[s], timeMs([&] {
+      for (size_t i = start; i < end; ++i) {
+        finder.findFlag(encoded[i], result, scratch);
+      }
+    }, min_ms) / (end - start) });
+  }
+
+  out << std::left << std::setw(32) << "Benchmark" << std::right << std::setw(14) << "ms" << std::endl;
+  for (const BenchmarkTiming& timing : timings) {
+    out << std::left << std::setw(32) << timing.name << std::right << std::fixed << std::setprecision(4)
+        << std::setw(14) << timing.ms << std::endl;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes timings to a baseline file, one "benchmark,ms" line each
+ *
+ * @param path CSV file to write
+ * @param timings timings to keep
+ * @return true if the file was written
+ */
+bool writeBaseline(const std::string& path, const std::vector<BenchmarkTiming>& timings) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+  file << "benchmark,ms\n";
+  file << std::setprecision(9);
+  for (const BenchmarkTiming& timing : timings) {
+    file << timing.name << "," << timing.ms << "\n";
+  }
+  return (bool)file;
+}
+
+/**
+ * @brief Reads timings written by writeBaseline
+ *
+ * @param path CSV file to read
+ * @param timings set to the timings in the file
+ * @return true if the file could be read and every line had a time
+ */
+bool readBaseline(const std::string& path, std::vector<BenchmarkTiming>& timings) {
+  std::ifstream file(path);
+  std::string line;
+  if (!std::getline(file, line)) {
+    return false;
+  }
+
+  timings.clear();
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+    size_t comma = line.rfind(',');
+    if (comma == std::string::npos) {
+      return false;
+    }
+    BenchmarkTiming timing;
+    timing.name = line.substr(0, comma);
+    char* end = nullptr;
+    std::string ms = line.substr(comma + 1);
+    timing.ms = std::strtod(ms.c_str(), &end);
+    if (end == ms.c_str()) {
+      return false;
+    }
+    timings.push_back(timing);
+  }
+  return true;
+}
+
+/**
+ * @brief Compares timings against a baseline and prints the change of each
+ *        step. A step regressed if it is more than threshold_percent slower
+ *        and more than kRegressionFloorMs slower, so steps that take a few
+ *        microseconds don't fail on timer noise.
+ *
+ * @param baseline timings to compare against
+ * @param timings timings just measured
+ * @param threshold_percent slowdown in percent a step is allowed
+ * @param out stream to print the comparison to
+ * @return true if no step in both lists regressed
+ */
+bool compareBaseline(const std::vector<BenchmarkTiming>& baseline, const std::vector<BenchmarkTiming>& timings,
+                     double threshold_percent, std::ostream& out) {
+  bool passed = true;
+  out << std::left << std::setw(32) << "Benchmark" << std::right << std::setw(14) << "baseline ms"
+      << std::setw(14) << "current ms" << std::setw(10) << "change" << std::endl;
+  for (const BenchmarkTiming& timing : timings) {
+    std::vector<BenchmarkTiming>::const_iterator before =
+      std::find_if(baseline.begin(), baseline.end(),
+                   [&timing](const BenchmarkTiming& other) { return other.name == timing.name; });
+    out << std::left << std::setw(32) << timing.name << std::right << std::fixed << std::setprecision(4);
+    if (before == baseline.end()) {
+      out << std::setw(14) << "-" << std::setw(14) << timing.ms << "  not in baseline" << std::endl;
+      continue;
+    }
+
+    double change = before->ms > 0.0 ? (timing.ms / before->ms - 1.0) * 100.0 : 0.0;
+    bool regressed = change > threshold_percent && timing.ms - before->ms > kRegressionFloorMs;
+    passed = passed && !regressed;
+    out << std::setw(14) << before->ms << std::setw(14) << timing.ms << std::setprecision(1)
+        << std::setw(9) << std::showpos << change << std::noshowpos << "%" << (regressed ? "  REGRESSION" : "")
+        << std::endl;
+  }
+  for (const BenchmarkTiming& timing : baseline) {
+    if (std::none_of(timings.begin(), timings.end(),
+                     [&timing](const BenchmarkTiming& other) { return other.name == timing.name; })) {
+      out << std::left << std::setw(32) << timing.name << "  not measured" << std::endl;
+    }
+  }
+  out << (passed ? "No regression" : "PERFORMANCE REGRESSION") << " beyond " << std::setprecision(1)
+      << threshold_percent << "%" << std::endl;
+  return passed;
+}
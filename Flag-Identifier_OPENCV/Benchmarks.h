@@ -0,0 +1,137 @@
+/*********************************************************************
+ * @file       Benchmarks.h
+ * @brief      Benchmarks times the building blocks of the flag filters so
+ *              changes to them can be measured.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FlagIndex.h"
+
+/**
+ * @brief BenchmarkTiming is the time of one step measured by bench stages
+ */
+struct BenchmarkTiming {
+
+  // Name of the step, and of the images for end to end timings
+  std::string name;
+
+  // Average milliseconds per image, or per call for steps that don't run
+  // once per image
+  double ms;
+};
+
+/**
+ * @brief Times CommonColorFinder::populateHistogram against the per pixel
+ *        reference version on 360x240 and 3840x2160 images, both random noise
+ *        and flag-like stripes, in the color scheme in use, and checks they
+ *        count the same histogram
+ *
+ * @param out stream to print the timings to
+ * @return true if every histogram matched the reference
+ */
+bool benchmarkHistogram(std::ostream& out);
+
+/**
+ * @brief Times EdgeRatioFinder::getEdgeRatio against the OpenCV cvtColor,
+ *        GaussianBlur and Canny chain on 360x240 and 3840x2160 images, both
+ *        random noise and flag-like stripes, whole and as an upper left
+ *        quadrant view, and checks they count exactly the same edges
+ *
+ * @param out stream to print the timings to
+ * @return true if every edge count matched the chain
+ */
+bool benchmarkEdges(std::ostream& out);
+
+/**
+ * @brief Runs a directory or manifest of test images through findFlag with
+ *        full size decoding and with reduced jpg decoding, prints the summary
+ *        of both and counts the images whose prediction changed
+ *
+ * @param index flag metadata to search
+ * @param source directory or manifest of test images, see
+ *        BatchEvaluator::loadInputs
+ * @param num_threads number of worker threads, 0 for one per core
+ * @param out stream to print the comparison to
+ * @return true if reduced decoding got at least as many labeled images right
+ */
+bool benchmarkDecode(const FlagIndex& index, const std::string& source, int num_threads, std::ostream& out);
+
+/**
+ * @brief Counts the heap allocations of findFlag on one encoded image once
+ *        its buffers are warm, with the bucket filters, the nearest neighbor
+ *        search and ranking. The image kernels the query ran (decode, resize
+ *        and edge ratio) are counted again on their own, since OpenCV keeps
+ *        temporaries the flag code can't reuse.
+ *
+ * @param index flag metadata to search
+ * @param path image file to search for
+ * @param out stream to print the counts to
+ * @return true if the flag code allocated nothing beyond the kernels
+ */
+bool benchmarkAllocations(const FlagIndex& index, const std::string& path, std::ostream& out);
+
+/**
+ * @brief Times each step of findFlag on its own over every image of the
+ *        sources: decoding, the color histogram, the most common and
+ *        dominant color buckets, resizing, the edge ratio, the bucket index
+ *        lookup of findClosestFlag, filterRatios, building a bucket index
+ *        and building the flag index. Then times findFlag end to end over
+ *        each source.
+ *
+ * @param index flag metadata to search
+ * @param reference_source directory or manifest of the reference flags the
+ *        index build is timed on
+ * @param sources directories or manifests of test images, see
+ *        BatchEvaluator::loadInputs
+ * @param timings set to the time of every step, in the order printed
+ * @param out stream to print the timings to
+ * @return false if a source or the reference flags could not be read
+ */
+bool benchmarkStages(const FlagIndex& index, const std::string& reference_source,
+                     const std::vector<std::string>& sources, std::vector<BenchmarkTiming>& timings,
+                     std::ostream& out);
+
+/**
+ * @brief Writes timings to a baseline file, one "benchmark,ms" line each
+ *
+ * @param path CSV file to write
+ * @param timings timings to keep
+ * @return true if the file was written
+ */
+bool writeBaseline(const std::string& path, const std::vector<BenchmarkTiming>& timings);
+
+/**
+ * @brief Reads timings written by writeBaseline
+ *
+ * @param path CSV file to read
+ * @param timings set to the timings in the file
+ * @return true if the file could be read and every line had a time
+ */
+bool readBaseline(const std::string& path, std::vector<BenchmarkTiming>& timings);
+
+/**
+ * @brief Compares timings against a baseline and prints the change of each
+ *        step. A step regressed if it is more than threshold_percent slower
+ *        and more than kRegressionFloorMs slower, so steps that take a few
+ *        microseconds don't fail on timer noise.
+ *
+ * @param baseline timings to compare against
+ * @param timings timings just measured
+ * @param threshold_percent slowdown in percent a step is allowed
+ * @param out stream to print the comparison to
+ * @return true if no step in both lists regressed
+ */
+bool compareBaseline(const std::vector<BenchmarkTiming>& baseline, const std::vector<BenchmarkTiming>& timings,
+                     double threshold_percent, std::ostream& out);
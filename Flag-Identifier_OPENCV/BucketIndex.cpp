@@ -0,0 +1,155 @@
+/*********************************************************************
+ * @file       BucketIndex.cpp
+ * @brief      BucketIndex files flag ids by the 8x8x8 color bucket of their
+ *              most common color in one flat array.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "BucketIndex.h"
+
+#include <algorithm>
+
+/**
+ * @brief Constructor creates an index with every cell empty
+ */
+BucketIndex::BucketIndex() {
+  std::fill(offsets_, offsets_ + kNumCells + 1, 0);
+}
+
+/**
+ * @brief Files every flag id in the cell of its color bucket. Ids in a cell
+ *        keep the order they were given in.
+ *
+ * @param ids flag ids to file
+ * @param buckets color bucket of each flag id, same order as ids
+ */
+void BucketIndex::build(const std::vector<int>& ids, const std::vector<ColorBucket>& buckets) {
+
+  // Count the ids in each cell, offsets_[c + 1] holds the count of cell c
+  std::fill(offsets_, offsets_ + kNumCells + 1, 0);
+  for (const ColorBucket& bucket : buckets) {
+    ++offsets_[getCell(bucket.getRedBucket(), bucket.getGreenBucket(), bucket.getBlueBucket()) + 1];
+  }
+
+  // Running total turns the counts into the start of each cell
+  for (int cell = 0; cell < kNumCells; ++cell) {
+    offsets_[cell + 1] += offsets_[cell];
+  }
+
+  // Place each id at the next free spot of its cell
+  std::vector<int> next(offsets_, offsets_ + kNumCells);
+  ids_.assign(ids.size(), 0);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    const ColorBucket& bucket = buckets.at(i);
+    ids_[next[getCell(bucket.getRedBucket(), bucket.getGreenBucket(), bucket.getBlueBucket())]++] = ids.at(i);
+  }
+}
+
+/**
+ * @brief Appends the ids in the cell of a bucket and every adjacent cell,
+ *        visited red, then blue, then green
+ *
+ * @param bucket color bucket to search around
+ * @param ids list to append the flag ids to
+ */
+void BucketIndex::findNeighbors(const ColorBucket& bucket, std::vector<int>& ids) const {
+  int cells[kMaxNeighbors];
+  int num_cells = getNeighborCells(bucket, cells);
+  for (int i = 0; i < num_cells; ++i) {
+    ids.insert(ids.end(), cellBegin(cells[i]), cellEnd(cells[i]));
+  }
+}
+
+/**
+ * @brief Adds the ids in the cell of a bucket and every adjacent cell to a
+ *        candidate set
+ *
+ * @param bucket color bucket to search around
+ * @param candidates set to add the flag ids to
+ */
+void BucketIndex::findNeighbors(const ColorBucket& bucket, CandidateSet& candidates) const {
+  int cells[kMaxNeighbors];
+  int num_cells = getNeighborCells(bucket, cells);
+  for (int i = 0; i < num_cells; ++i) {
+    for (const int* id = cellBegin(cells[i]); id != cellEnd(cells[i]); ++id) {
+      candidates.insert(*id);
+    }
+  }
+}
+
+/**
+ * @brief Returns the cell of a color bucket
+ *
+ * @param red red bucket 0-7
+ * @param green green bucket 0-7
+ * @param blue blue bucket 0-7
+ * @return cell 0-511
+ */
+int BucketIndex::getCell(int red, int green, int blue) {
+  return (red << 6) | (green << 3) | blue;
+}
+
+/**
+ * @brief Getter for the first id in a cell
+ *
+ * @param cell cell 0-511
+ * @return pointer to the first id of the cell
+ */
+const int* BucketIndex::cellBegin(int cell) const {
+  return ids_.data() + offsets_[cell];
+}
+
+/**
+ * @brief Getter for the end of the ids in a cell
+ *
+ * @param cell cell 0-511
+ * @return pointer past the last id of the cell
+ */
+const int* BucketIndex::cellEnd(int cell) const {
+  return ids_.data() + offsets_[cell + 1];
+}
+
+/**
+ * @brief Returns the memory the index holds
+ *
+ * @return bytes allocated, counting the capacity of its buffers
+ */
+size_t BucketIndex::getMemoryBytes() const {
+  return sizeof(offsets_) + ids_.capacity() * sizeof(int);
+}
+
+/**
+ * @brief Lists the cell of a bucket and every adjacent cell, visited red,
+ *        then blue, then green
+ *
+ * @param bucket color bucket to search around
+ * @param cells array of at least kMaxNeighbors cells to fill
+ * @return number of cells filled
+ */
+int BucketIndex::getNeighborCells(const ColorBucket& bucket, int* cells) {
+  const int max_bucket = kBucketsPerColor - 1;
+
+  // Adjacent buckets clamped to the histogram instead of checked one by one
+  int red_low = std::max(bucket.getRedBucket() - 1, 0);
+  int red_high = std::min(bucket.getRedBucket() + 1, max_bucket);
+  int blue_low = std::max(bucket.getBlueBucket() - 1, 0);
+  int blue_high = std::min(bucket.getBlueBucket() + 1, max_bucket);
+  int green_low = std::max(bucket.getGreenBucket() - 1, 0);
+  int green_high = std::min(bucket.getGreenBucket() + 1, max_bucket);
+
+  int num_cells = 0;
+  for (int r = red_low; r <= red_high; ++r) {
+    for (int b = blue_low; b <= blue_high; ++b) {
+      for (int g = green_low; g <= green_high; ++g) {
+        cells[num_cells++] = getCell(r, g, b);
+      }
+    }
+  }
+  return num_cells;
+}
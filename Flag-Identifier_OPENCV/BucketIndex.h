@@ -0,0 +1,118 @@
+/*********************************************************************
+ * @file       BucketIndex.h
+ * @brief      BucketIndex files flag ids by the 8x8x8 color bucket of their
+ *              most common color in one flat array.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "CandidateSet.h"
+#include "ColorBucket.h"
+
+/**
+ * @class BucketIndex holds one cell for each of the 512 color buckets. Each
+ *        cell is a range of one contiguous array of flag ids, found through a
+ *        dense offset table, so looking up a bucket never allocates or
+ *        branches on missing buckets.
+ */
+class BucketIndex {
+  public:
+
+  // Number of buckets in each color dimension and in total
+  static const int kBucketsPerColor = 8;
+  static const int kNumCells = kBucketsPerColor * kBucketsPerColor * kBucketsPerColor;
+
+  // Most cells findNeighbors visits, a bucket and its 26 neighbors
+  static const int kMaxNeighbors = 27;
+
+  /**
+   * @brief Constructor creates an index with every cell empty
+   */
+  BucketIndex();
+
+  /**
+   * @brief Files every flag id in the cell of its color bucket. Ids in a cell
+   *        keep the order they were given in.
+   *
+   * @param ids flag ids to file
+   * @param buckets color bucket of each flag id, same order as ids
+   */
+  void build(const std::vector<int>& ids, const std::vector<ColorBucket>& buckets);
+
+  /**
+   * @brief Appends the ids in the cell of a bucket and every adjacent cell,
+   *        visited red, then blue, then green
+   *
+   * @param bucket color bucket to search around
+   * @param ids list to append the flag ids to
+   */
+  void findNeighbors(const ColorBucket& bucket, std::vector<int>& ids) const;
+
+  /**
+   * @brief Adds the ids in the cell of a bucket and every adjacent cell to a
+   *        candidate set
+   *
+   * @param bucket color bucket to search around
+   * @param candidates set to add the flag ids to
+   */
+  void findNeighbors(const ColorBucket& bucket, CandidateSet& candidates) const;
+
+  /**
+   * @brief Returns the cell of a color bucket
+   *
+   * @param red red bucket 0-7
+   * @param green green bucket 0-7
+   * @param blue blue bucket 0-7
+   * @return cell 0-511
+   */
+  static int getCell(int red, int green, int blue);
+
+  /**
+   * @brief Getter for the first id in a cell
+   *
+   * @param cell cell 0-511
+   * @return pointer to the first id of the cell
+   */
+  const int* cellBegin(int cell) const;
+
+  /**
+   * @brief Getter for the end of the ids in a cell
+   *
+   * @param cell cell 0-511
+   * @return pointer past the last id of the cell
+   */
+  const int* cellEnd(int cell) const;
+
+  /**
+   * @brief Returns the memory the index holds
+   *
+   * @return bytes allocated, counting the capacity of its buffers
+   */
+  size_t getMemoryBytes() const;
+
+  /**
+   * @brief Lists the cell of a bucket and every adjacent cell, visited red,
+   *        then blue, then green
+   *
+   * @param bucket color bucket to search around
+   * @param cells array of at least kMaxNeighbors cells to fill
+   * @return number of cells filled
+   */
+  static int getNeighborCells(const ColorBucket& bucket, int* cells);
+
+  private:
+
+  // Ids of cell c are ids_[offsets_[c]] up to ids_[offsets_[c + 1]]
+  int offsets_[kNumCells + 1];
+  std::vector<int> ids_;
+};
@@ -0,0 +1,180 @@
+/*********************************************************************
+ * @file       CandidateSet.cpp
+ * @brief      CandidateSet is a bitset of the flag ids that are still
+ *              possible matches while the filters of findFlag run.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "CandidateSet.h"
+
+#include <bitset>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Returns the position of the lowest set bit of a word
+ *
+ * @param word word with at least one bit set
+ * @return position 0-63 of the lowest set bit
+ */
+static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long position;
+  _BitScanForward64(&position, word);
+  return (int)position;
+#elif defined(__GNUC__)
+  return __builtin_ctzll(word);
+#else
+  int position = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++position;
+  }
+  return position;
+#endif
+}
+
+/**
+ * @brief Constructor creates an empty set of no flags
+ */
+CandidateSet::CandidateSet() : num_flags_(0), count_(0) {}
+
+/**
+ * @brief Sizes the set for an index and removes every id. Memory is only
+ *        allocated when the set grows.
+ *
+ * @param num_flags number of flags in the index
+ */
+void CandidateSet::reset(int num_flags) {
+  num_flags_ = num_flags;
+  count_ = 0;
+  words_.assign((num_flags + 63) / 64, 0);
+}
+
+/**
+ * @brief Adds an id to the set
+ *
+ * @param id flag id less than the reset size
+ */
+void CandidateSet::insert(int id) {
+  uint64_t bit = (uint64_t)1 << (id & 63);
+  uint64_t& word = words_[id >> 6];
+  count_ += (word & bit) ? 0 : 1;
+  word |= bit;
+}
+
+/**
+ * @brief Removes an id from the set
+ *
+ * @param id flag id less than the reset size
+ */
+void CandidateSet::erase(int id) {
+  uint64_t bit = (uint64_t)1 << (id & 63);
+  uint64_t& word = words_[id >> 6];
+  count_ -= (word & bit) ? 1 : 0;
+  word &= ~bit;
+}
+
+/**
+ * @brief Checks if an id is in the set
+ *
+ * @param id flag id less than the reset size
+ * @return true if the id is in the set
+ */
+bool CandidateSet::contains(int id) const {
+  return (words_[id >> 6] >> (id & 63)) & 1;
+}
+
+/**
+ * @brief Removes every id that isn't also in another set
+ *
+ * @param other set of the same size
+ */
+void CandidateSet::intersect(const CandidateSet& other) {
+  count_ = 0;
+  for (size_t i = 0; i < words_.size(); ++i) {
+    words_[i] &= other.words_[i];
+    count_ += (int)std::bitset<64>(words_[i]).count();
+  }
+}
+
+/**
+ * @brief Getter for the number of ids in the set
+ *
+ * @return number of ids
+ */
+int CandidateSet::size() const {
+  return count_;
+}
+
+/**
+ * @brief Checks if the set has no ids
+ *
+ * @return true if no ids are in the set
+ */
+bool CandidateSet::empty() const {
+  return count_ == 0;
+}
+
+/**
+ * @brief Getter for the smallest id in the set
+ *
+ * @return smallest id or -1 if the set is empty
+ */
+int CandidateSet::first() const {
+  return next(-1);
+}
+
+/**
+ * @brief Getter for the next id in the set. The current id may be erased
+ *        before calling next.
+ *
+ * @param id id to search after
+ * @return smallest id greater than id or -1 if there is none
+ */
+int CandidateSet::next(int id) const {
+  int start = id + 1;
+  if (start >= num_flags_) {
+    return -1;
+  }
+
+  // Bits below start are masked off in the first word
+  size_t i = (size_t)(start >> 6);
+  uint64_t word = words_[i] & (~(uint64_t)0 << (start & 63));
+  while (word == 0) {
+    if (++i == words_.size()) {
+      return -1;
+    }
+    word = words_[i];
+  }
+  return (int)(i << 6) + lowestBit(word);
+}
+
+/**
+ * @brief Copies the ids in the set in increasing order
+ *
+ * @param ids list to fill, cleared first
+ */
+void CandidateSet::getIds(std::vector<int>& ids) const {
+  ids.clear();
+  for (int id = first(); id >= 0; id = next(id)) {
+    ids.push_back(id);
+  }
+}
+
+/**
+ * @brief Returns the memory the set holds
+ *
+ * @return bytes allocated, counting the capacity of its buffers
+ */
+size_t CandidateSet::getMemoryBytes() const {
+  return words_.capacity() * sizeof(uint64_t);
+}
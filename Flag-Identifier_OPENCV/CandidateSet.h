@@ -0,0 +1,120 @@
+/*********************************************************************
+ * @file       CandidateSet.h
+ * @brief      CandidateSet is a bitset of the flag ids that are still
+ *              possible matches while the filters of findFlag run.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class CandidateSet holds one bit for every flag in the index. Ids are
+ *        visited in increasing order, so filters never compare names and
+ *        removing a flag never moves memory.
+ */
+class CandidateSet {
+  public:
+
+  /**
+   * @brief Constructor creates an empty set of no flags
+   */
+  CandidateSet();
+
+  /**
+   * @brief Sizes the set for an index and removes every id. Memory is only
+   *        allocated when the set grows.
+   *
+   * @param num_flags number of flags in the index
+   */
+  void reset(int num_flags);
+
+  /**
+   * @brief Adds an id to the set
+   *
+   * @param id flag id less than the reset size
+   */
+  void insert(int id);
+
+  /**
+   * @brief Removes an id from the set
+   *
+   * @param id flag id less than the reset size
+   */
+  void erase(int id);
+
+  /**
+   * @brief Checks if an id is in the set
+   *
+   * @param id flag id less than the reset size
+   * @return true if the id is in the set
+   */
+  bool contains(int id) const;
+
+  /**
+   * @brief Removes every id that isn't also in another set
+   *
+   * @param other set of the same size
+   */
+  void intersect(const CandidateSet& other);
+
+  /**
+   * @brief Getter for the number of ids in the set
+   *
+   * @return number of ids
+   */
+  int size() const;
+
+  /**
+   * @brief Checks if the set has no ids
+   *
+   * @return true if no ids are in the set
+   */
+  bool empty() const;
+
+  /**
+   * @brief Getter for the smallest id in the set
+   *
+   * @return smallest id or -1 if the set is empty
+   */
+  int first() const;
+
+  /**
+   * @brief Getter for the next id in the set. The current id may be erased
+   *        before calling next.
+   *
+   * @param id id to search after
+   * @return smallest id greater than id or -1 if there is none
+   */
+  int next(int id) const;
+
+  /**
+   * @brief Copies the ids in the set in increasing order
+   *
+   * @param ids list to fill, cleared first
+   */
+  void getIds(std::vector<int>& ids) const;
+
+  /**
+   * @brief Returns the memory the set holds
+   *
+   * @return bytes allocated, counting the capacity of its buffers
+   */
+  size_t getMemoryBytes() const;
+
+  private:
+
+  // Bit id % 64 of words_[id / 64] is set when id is in the set
+  std::vector<uint64_t> words_;
+  int num_flags_;
+  int count_;
+};
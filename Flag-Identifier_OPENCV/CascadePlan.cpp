@@ -0,0 +1,270 @@
+/*********************************************************************
+ * @file       CascadePlan.cpp
+ * @brief      CascadePlan holds the order of the filters findFlag runs
+ *              after the MCC filter, planned from how long each filter takes
+ *              and how many flags it removes on a labeled set of images.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "CascadePlan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+const int CascadePlan::kVersion = 1;
+
+// First word of every plan file
+static const char* kPlanHeader = "cascade-plan";
+
+// Names of the planned filters in the plan file, by position in
+// kPlannedStages
+static const char* kPlanKeys[kNumPlannedStages] = { "ratio", "canny", "quadrant" };
+
+/**
+ * @brief Constructor creates the fixed order: MCC ratio, Canny and upper
+ *        left quadrant
+ */
+CascadePlan::CascadePlan() : stages_(kPlannedStages, kPlannedStages + kNumPlannedStages), num_flags_(0) {}
+
+/**
+ * @brief Getter for the filters to run after the MCC filter
+ *
+ * @return filters in the order they run, skipped ones left out
+ */
+const std::vector<FlagStage>& CascadePlan::getStages() const {
+  return stages_;
+}
+
+/**
+ * @brief Getter for the number of flags the plan was measured with
+ *
+ * @return number of flags in the index when planned, 0 for the fixed order
+ */
+int CascadePlan::getNumFlags() const {
+  return num_flags_;
+}
+
+/**
+ * @brief Plans the order from labeled samples and prints how each filter
+ *        and the plan did against the fixed order
+ *
+ * @param samples one sample per labeled test image
+ * @param num_flags number of flags in the index the samples were taken on
+ * @param report stream to print the filter statistics to
+ * @return false if there were no samples, the plan is left as it was
+ */
+bool CascadePlan::build(const std::vector<CascadeSample>& samples, int num_flags, std::ostream& report) {
+  if (samples.empty()) {
+    return false;
+  }
+
+  // Average of each filter run alone on the flags the MCC filter left
+  double resize_ms = 0.0;
+  double mean_ms[kNumPlannedStages] = {};
+  double removed[kNumPlannedStages] = {};
+  int dropped_label[kNumPlannedStages] = {};
+  for (const CascadeSample& sample : samples) {
+    resize_ms += sample.resize_ms;
+    for (int i = 0; i < kNumPlannedStages; ++i) {
+      mean_ms[i] += sample.stage_ms[i];
+      bool dropped = false;
+      for (size_t j = 0; j < sample.flags.size(); ++j) {
+        if (!sample.passed[i][j]) {
+          removed[i] += 1.0;
+          dropped = dropped || sample.correct[j];
+        }
+      }
+      dropped_label[i] += dropped ? 1 : 0;
+    }
+  }
+  resize_ms /= samples.size();
+
+  // The Canny and quadrant filters both pay for the resize if they run
+  // before the other
+  double cost_per_removed[kNumPlannedStages];
+  for (int i = 0; i < kNumPlannedStages; ++i) {
+    mean_ms[i] /= samples.size();
+    removed[i] /= samples.size();
+    double cost = mean_ms[i] + (kPlannedStages[i] == kStageMccRatio ? 0.0 : resize_ms);
+    cost_per_removed[i] = removed[i] > 0.0 ? cost / removed[i] : HUGE_VAL;
+  }
+
+  // Cheapest per flag removed first
+  std::vector<int> order;
+  for (int i = 0; i < kNumPlannedStages; ++i) {
+    order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&cost_per_removed](int a, int b) { return cost_per_removed[a] < cost_per_removed[b]; });
+
+  // Skip each filter, last first, that the plan finds as many images
+  // without
+  double plan_ms;
+  int plan_right = simulate(samples, order, plan_ms);
+  for (int i = (int)order.size() - 1; i >= 0; --i) {
+    std::vector<int> without = order;
+    without.erase(without.begin() + i);
+    double without_ms;
+    int without_right = simulate(samples, without, without_ms);
+    if (without_right >= plan_right) {
+      order = without;
+      plan_right = without_right;
+      plan_ms = without_ms;
+    }
+  }
+
+  std::vector<int> fixed_order;
+  for (int i = 0; i < kNumPlannedStages; ++i) {
+    fixed_order.push_back(i);
+  }
+  double fixed_ms;
+  int fixed_right = simulate(samples, fixed_order, fixed_ms);
+
+  report << std::fixed << std::setprecision(4);
+  report << "Filters run alone on the flags left by the MCC filter, averaged over " << samples.size()
+         << " images (resize " << resize_ms << " ms):\n";
+  for (int i = 0; i < kNumPlannedStages; ++i) {
+    report << "  " << std::left << std::setw(36) << getStageName(kPlannedStages[i]) << std::right << mean_ms[i]
+           << " ms, removed " << std::setprecision(2) << removed[i] << " flags, dropped the label for "
+           << dropped_label[i] << " images, " << std::setprecision(4);
+    if (removed[i] > 0.0) {
+      report << cost_per_removed[i] << " ms per flag removed\n";
+    } else {
+      report << "removed nothing\n";
+    }
+  }
+
+  stages_.clear();
+  for (int i : order) {
+    stages_.push_back(kPlannedStages[i]);
+  }
+  num_flags_ = num_flags;
+
+  report << "Fixed order: " << fixed_right << " of " << samples.size() << " images right, " << fixed_ms / samples.size()
+         << " ms of filters per image\n";
+  report << "Plan:";
+  for (FlagStage stage : stages_) {
+    report << " " << getStageName(stage) << (stage == stages_.back() ? "" : ",");
+  }
+  if (stages_.empty()) {
+    report << " MCC filter only";
+  }
+  report << "\n";
+  report << "Planned order: " << plan_right << " of " << samples.size() << " images right, " << plan_ms / samples.size()
+         << " ms of filters per image" << std::endl;
+  report.unsetf(std::ios::floatfield);
+  report << std::setprecision(6);
+  return true;
+}
+
+/**
+ * @brief Writes the plan to a file
+ *
+ * @param path plan file to write
+ * @return true if the file was written
+ */
+bool CascadePlan::save(const std::string& path) const {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  out << kPlanHeader << " " << kVersion << "\n";
+  out << "flags " << num_flags_ << "\n";
+  for (FlagStage stage : stages_) {
+    int position = (int)(std::find(kPlannedStages, kPlannedStages + kNumPlannedStages, stage) - kPlannedStages);
+    out << kPlanKeys[position] << "\n";
+  }
+  return (bool)out;
+}
+
+/**
+ * @brief Reads a plan written by save
+ *
+ * @param path plan file to read
+ * @return true if the file exists, has the current version and names
+ *         each filter at most once, the plan is left as it was if not
+ */
+bool CascadePlan::load(const std::string& path) {
+  std::ifstream in(path);
+  std::string header;
+  int version = 0;
+  std::string flags_word;
+  int num_flags = 0;
+  if (!(in >> header >> version >> flags_word >> num_flags) || header != kPlanHeader || version != kVersion ||
+      flags_word != "flags") {
+    return false;
+  }
+
+  std::vector<FlagStage> stages;
+  std::string key;
+  while (in >> key) {
+    const char** found = std::find_if(kPlanKeys, kPlanKeys + kNumPlannedStages,
+                                      [&key](const char* plan_key) { return key == plan_key; });
+    if (found == kPlanKeys + kNumPlannedStages) {
+      return false;
+    }
+    FlagStage stage = kPlannedStages[found - kPlanKeys];
+    if (std::find(stages.begin(), stages.end(), stage) != stages.end()) {
+      return false;
+    }
+    stages.push_back(stage);
+  }
+
+  stages_ = stages;
+  num_flags_ = num_flags;
+  return true;
+}
+
+/**
+ * @brief Runs the filters of a plan over every sample
+ *
+ * @param samples one sample per labeled test image
+ * @param stages positions in kPlannedStages, in the order they run
+ * @param total_ms set to the milliseconds the filters would take in all
+ * @return number of samples left with only their label
+ */
+int CascadePlan::simulate(const std::vector<CascadeSample>& samples, const std::vector<int>& stages,
+                          double& total_ms) {
+  int right = 0;
+  total_ms = 0.0;
+  std::vector<char> remaining;
+  for (const CascadeSample& sample : samples) {
+    remaining.assign(sample.flags.size(), 1);
+    int count = (int)sample.flags.size();
+    bool resized = false;
+
+    // Like findFlag, the filters stop once one flag or none is left
+    for (int stage : stages) {
+      if (count <= 1) {
+        break;
+      }
+      if (!resized && kPlannedStages[stage] != kStageMccRatio) {
+        total_ms += sample.resize_ms;
+        resized = true;
+      }
+      total_ms += sample.stage_ms[stage];
+      for (size_t j = 0; j < sample.flags.size(); ++j) {
+        if (remaining[j] && !sample.passed[stage][j]) {
+          remaining[j] = 0;
+          --count;
+        }
+      }
+    }
+
+    // Variants of the label all count as right, like BatchEvaluator
+    bool correct = count > 0;
+    for (size_t j = 0; j < sample.flags.size(); ++j) {
+      correct = correct && (!remaining[j] || sample.correct[j]);
+    }
+    right += correct ? 1 : 0;
+  }
+  return right;
+}
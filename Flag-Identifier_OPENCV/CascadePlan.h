@@ -0,0 +1,130 @@
+/*********************************************************************
+ * @file       CascadePlan.h
+ * @brief      CascadePlan holds the order of the filters findFlag runs
+ *              after the MCC filter, planned from how long each filter takes
+ *              and how many flags it removes on a labeled set of images.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FlagStage.h"
+
+// Filters a plan can order, in the order findFlag runs them without one
+const int kNumPlannedStages = 3;
+const FlagStage kPlannedStages[kNumPlannedStages] = { kStageMccRatio, kStageCanny, kStageQuadrant };
+
+/**
+ * @brief CascadeSample is what each planned filter did to one labeled test
+ *        image when run alone on the flags left by the MCC filter
+ */
+struct CascadeSample {
+
+  // Ids of the flags left by the MCC filter
+  std::vector<int> flags;
+
+  // Whether each flag in flags is the label of the image
+  std::vector<char> correct;
+
+  // Whether each flag in flags passed each planned filter, by position in
+  // kPlannedStages
+  std::vector<char> passed[kNumPlannedStages];
+
+  // Milliseconds each planned filter took, by position in kPlannedStages
+  double stage_ms[kNumPlannedStages];
+
+  // Milliseconds of the resize the Canny and quadrant filters share
+  double resize_ms;
+};
+
+/**
+ * @class CascadePlan orders the filters after the MCC filter, which always
+ *        runs first since it is the one that finds flags in the bucket
+ *        index. Filters are ordered by the milliseconds they take per flag
+ *        they remove, so the cheap and selective ones leave less for the
+ *        rest, and a filter is skipped when the labeled images are found as
+ *        well without it. Without a plan the filters run in their fixed
+ *        order. A plan is a short text file kept next to the index file.
+ */
+class CascadePlan {
+  public:
+
+  // Version of the plan file format
+  static const int kVersion;
+
+  /**
+   * @brief Constructor creates the fixed order: MCC ratio, Canny and upper
+   *        left quadrant
+   */
+  CascadePlan();
+
+  /**
+   * @brief Getter for the filters to run after the MCC filter
+   *
+   * @return filters in the order they run, skipped ones left out
+   */
+  const std::vector<FlagStage>& getStages() const;
+
+  /**
+   * @brief Getter for the number of flags the plan was measured with
+   *
+   * @return number of flags in the index when planned, 0 for the fixed order
+   */
+  int getNumFlags() const;
+
+  /**
+   * @brief Plans the order from labeled samples and prints how each filter
+   *        and the plan did against the fixed order
+   *
+   * @param samples one sample per labeled test image
+   * @param num_flags number of flags in the index the samples were taken on
+   * @param report stream to print the filter statistics to
+   * @return false if there were no samples, the plan is left as it was
+   */
+  bool build(const std::vector<CascadeSample>& samples, int num_flags, std::ostream& report);
+
+  /**
+   * @brief Writes the plan to a file
+   *
+   * @param path plan file to write
+   * @return true if the file was written
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * @brief Reads a plan written by save
+   *
+   * @param path plan file to read
+   * @return true if the file exists, has the current version and names
+   *         each filter at most once, the plan is left as it was if not
+   */
+  bool load(const std::string& path);
+
+  private:
+
+  /**
+   * @brief Runs the filters of a plan over every sample
+   *
+   * @param samples one sample per labeled test image
+   * @param stages positions in kPlannedStages, in the order they run
+   * @param total_ms set to the milliseconds the filters would take in all
+   * @return number of samples left with only their label
+   */
+  static int simulate(const std::vector<CascadeSample>& samples, const std::vector<int>& stages, double& total_ms);
+
+  // Filters in the order they run
+  std::vector<FlagStage> stages_;
+
+  // Flags in the index the plan was measured with
+  int num_flags_;
+};
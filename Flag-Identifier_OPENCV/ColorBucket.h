@@ -13,6 +13,10 @@
  *********************************************************************/
 #pragma once
 
+// Most colors kept for one flag or test image by
+// CommonColorFinder::findDominantBuckets
+const int kMaxDominantColors = 4;
+
 
  /**
   * @class ColorBucket holds histogram bucket information for a given image for
@@ -0,0 +1,201 @@
+/*********************************************************************
+ * @file       ColorQuantizer.cpp
+ * @brief      ColorQuantizer maps a BGR pixel to one of the 8x8x8 color
+ *              buckets of a histogram through a lookup table, in BGR or in
+ *              a perceptual color space.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "ColorQuantizer.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+/**
+ * @brief BgrTable is the table of the BGR scheme, the top 3 bits of each
+ *        channel
+ */
+struct BgrTable {
+  ushort bins[32 * 32 * 32];
+};
+
+/**
+ * @brief Fills the BGR table, run by the compiler so the table is there
+ *        before any code runs
+ *
+ * @return table indexed like ColorQuantizer::getTable
+ */
+static constexpr BgrTable makeBgrTable() {
+  BgrTable table = {};
+  for (int i = 0; i < 32 * 32 * 32; ++i) {
+    int blue = i >> 10;
+    int green = (i >> 5) & 31;
+    int red = i & 31;
+    table.bins[i] = (ushort)(((red >> 2) << 6) | ((green >> 2) << 3) | (blue >> 2));
+  }
+  return table;
+}
+
+static constexpr BgrTable kBgrTable = makeBgrTable();
+
+ushort ColorQuantizer::tables_[kNumColorSchemes][32 * 32 * 32];
+Vec3b ColorQuantizer::colors_[kNumColorSchemes][8 * 8 * 8];
+std::once_flag ColorQuantizer::built_[kNumColorSchemes];
+ColorScheme ColorQuantizer::scheme_ = kColorBgr;
+const ushort* ColorQuantizer::table_ = kBgrTable.bins;
+
+/**
+ * @brief Default constructor is private and doesn't allow calling
+ */
+ColorQuantizer::ColorQuantizer() {
+  // Do nothing
+}
+
+/**
+ * @brief Makes a scheme the one every histogram is counted in, building
+ *        its table the first time. Called once by main, before any search
+ *        or thread starts, since the table is read without locking.
+ *
+ * @param scheme scheme to use
+ */
+void ColorQuantizer::select(ColorScheme scheme) {
+  if (scheme == kColorBgr) {
+    table_ = kBgrTable.bins;
+  } else {
+    std::call_once(built_[scheme], &ColorQuantizer::build, scheme);
+    table_ = tables_[scheme];
+  }
+  scheme_ = scheme;
+}
+
+/**
+ * @brief Getter for the scheme in use
+ *
+ * @return scheme every histogram is counted in, kColorBgr until one is
+ *         selected
+ */
+ColorScheme ColorQuantizer::getScheme() {
+  return scheme_;
+}
+
+/**
+ * @brief Returns the printable name of a scheme
+ *
+ * @param scheme scheme to name
+ * @return "bgr", "lab" or "hsv"
+ */
+const char* ColorQuantizer::getSchemeName(ColorScheme scheme) {
+  switch (scheme) {
+    case kColorBgr:
+      return "bgr";
+    case kColorLab:
+      return "lab";
+    case kColorHsv:
+      return "hsv";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief Reads a scheme from its name
+ *
+ * @param name "bgr", "lab" or "hsv"
+ * @param scheme scheme to fill
+ * @return false if the name isn't a scheme
+ */
+bool ColorQuantizer::parseScheme(const std::string& name, ColorScheme& scheme) {
+  for (int i = 0; i < kNumColorSchemes; ++i) {
+    if (name == getSchemeName((ColorScheme)i)) {
+      scheme = (ColorScheme)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Returns the table of the scheme in use, indexed
+ *        blue >> 3 << 10 | green >> 3 << 5 | red >> 3
+ *
+ * @return 32x32x32 bucket indexes, each first bucket << 6 | second
+ *         bucket << 3 | third bucket
+ */
+const ushort* ColorQuantizer::getTable() {
+  return table_;
+}
+
+/**
+ * @brief Returns the average color of a bucket in the scheme in use
+ *
+ * @param bin bucket index
+ * @return BGR color of the table entries in the bucket, black if none
+ */
+Vec3b ColorQuantizer::getColor(int bin) {
+
+  // Middle of the 32 values of each channel the BGR bucket covers
+  if (scheme_ == kColorBgr) {
+    return Vec3b((uchar)((bin & 7) * 32 + 16), (uchar)(((bin >> 3) & 7) * 32 + 16), (uchar)((bin >> 6) * 32 + 16));
+  }
+  return colors_[scheme_][bin];
+}
+
+/**
+ * @brief Fills the table and bucket colors of a perceptual scheme
+ *
+ * @param scheme kColorLab or kColorHsv
+ */
+void ColorQuantizer::build(ColorScheme scheme) {
+  const int entries = 32 * 32 * 32;
+
+  // Center color of every entry, in table order
+  Mat centers(1, entries, CV_8UC3);
+  Vec3b* center = centers.ptr<Vec3b>();
+  for (int i = 0; i < entries; ++i) {
+    center[i] = Vec3b((uchar)((i >> 10) * 8 + 4), (uchar)(((i >> 5) & 31) * 8 + 4), (uchar)((i & 31) * 8 + 4));
+  }
+
+  // Channels of the scheme in bucket order
+  Mat converted;
+  cvtColor(centers, converted, scheme == kColorLab ? COLOR_BGR2Lab : COLOR_BGR2HSV);
+  const Vec3b* channels = converted.ptr<Vec3b>();
+
+  // Each channel's range is split into 8
+  int low[3];
+  int range[3];
+  for (int c = 0; c < 3; ++c) {
+    int smallest = 255;
+    int largest = 0;
+    for (int i = 0; i < entries; ++i) {
+      smallest = std::min(smallest, (int)channels[i][c]);
+      largest = std::max(largest, (int)channels[i][c]);
+    }
+    low[c] = smallest;
+    range[c] = largest - smallest + 1;
+  }
+
+  int sums[8 * 8 * 8][3] = {};
+  int counts[8 * 8 * 8] = {};
+  for (int i = 0; i < entries; ++i) {
+    int bin = 0;
+    for (int c = 0; c < 3; ++c) {
+      bin = (bin << 3) | ((channels[i][c] - low[c]) * 8 / range[c]);
+    }
+    tables_[scheme][i] = (ushort)bin;
+    for (int c = 0; c < 3; ++c) {
+      sums[bin][c] += center[i][c];
+    }
+    ++counts[bin];
+  }
+  for (int bin = 0; bin < 8 * 8 * 8; ++bin) {
+    int count = std::max(counts[bin], 1);
+    colors_[scheme][bin] = Vec3b((uchar)(sums[bin][0] / count), (uchar)(sums[bin][1] / count),
+      (uchar)(sums[bin][2] / count));
+  }
+}
@@ -0,0 +1,141 @@
+/*********************************************************************
+ * @file       ColorQuantizer.h
+ * @brief      ColorQuantizer maps a BGR pixel to one of the 8x8x8 color
+ *              buckets of a histogram through a lookup table, in BGR or in
+ *              a perceptual color space.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <string>
+
+using namespace cv;
+
+/**
+ * @brief Color spaces a histogram can bucket pixels in. The three bucket
+ *        numbers of a ColorBucket are the channels of the space in order,
+ *        (red, green, blue), (L, a, b) or (hue, saturation, value).
+ */
+enum ColorScheme {
+  kColorBgr = 0,
+  kColorLab,
+  kColorHsv,
+  kNumColorSchemes
+};
+
+/**
+ * @class ColorQuantizer keeps a table of the bucket of every color with 5
+ *        bits per channel, 32x32x32 entries, built once per scheme by
+ *        converting the center of each entry with cvtColor. A pixel is then
+ *        bucketed with one lookup, with no floating point conversion per
+ *        pixel. Each channel of a perceptual space is split into 8 equal
+ *        ranges between its smallest and largest value over the table, so
+ *        all 8 levels are used. The BGR scheme buckets the top 3 bits of
+ *        each channel, the same as before there were schemes.
+ *
+ *        The scheme in use is one per process. main selects it once,
+ *        from the index file or the command line, before any histogram is
+ *        counted or any thread starts. The BGR table is filled when the
+ *        program is compiled, so it is in use until another scheme is
+ *        selected.
+ */
+class ColorQuantizer {
+  public:
+
+  /**
+   * @brief Makes a scheme the one every histogram is counted in, building
+   *        its table the first time. Called once by main, before any search
+   *        or thread starts, since the table is read without locking.
+   *
+   * @param scheme scheme to use
+   */
+  static void select(ColorScheme scheme);
+
+  /**
+   * @brief Getter for the scheme in use
+   *
+   * @return scheme every histogram is counted in, kColorBgr until one is
+   *         selected
+   */
+  static ColorScheme getScheme();
+
+  /**
+   * @brief Returns the printable name of a scheme
+   *
+   * @param scheme scheme to name
+   * @return "bgr", "lab" or "hsv"
+   */
+  static const char* getSchemeName(ColorScheme scheme);
+
+  /**
+   * @brief Reads a scheme from its name
+   *
+   * @param name "bgr", "lab" or "hsv"
+   * @param scheme scheme to fill
+   * @return false if the name isn't a scheme
+   */
+  static bool parseScheme(const std::string& name, ColorScheme& scheme);
+
+  /**
+   * @brief Returns the table of the scheme in use, indexed
+   *        blue >> 3 << 10 | green >> 3 << 5 | red >> 3
+   *
+   * @return 32x32x32 bucket indexes, each first bucket << 6 | second
+   *         bucket << 3 | third bucket
+   */
+  static const ushort* getTable();
+
+  /**
+   * @brief Returns the bucket of one pixel in the scheme in use
+   *
+   * @param blue blue channel of the pixel
+   * @param green green channel of the pixel
+   * @param red red channel of the pixel
+   * @return bucket index, first bucket << 6 | second bucket << 3 | third
+   *         bucket
+   */
+  static inline int getBin(int blue, int green, int red) {
+    return table_[((blue >> 3) << 10) | ((green >> 3) << 5) | (red >> 3)];
+  }
+
+  /**
+   * @brief Returns the average color of a bucket in the scheme in use
+   *
+   * @param bin bucket index
+   * @return BGR color of the table entries in the bucket, black if none
+   */
+  static Vec3b getColor(int bin);
+
+  private:
+
+  /**
+   * @brief Fills the table and bucket colors of a perceptual scheme
+   *
+   * @param scheme kColorLab or kColorHsv
+   */
+  static void build(ColorScheme scheme);
+
+  // Table and average bucket colors of the perceptual schemes, built when
+  // first selected. The BGR slots are unused.
+  static ushort tables_[kNumColorSchemes][32 * 32 * 32];
+  static Vec3b colors_[kNumColorSchemes][8 * 8 * 8];
+  static std::once_flag built_[kNumColorSchemes];
+
+  // Scheme in use and its table
+  static ColorScheme scheme_;
+  static const ushort* table_;
+
+  /**
+   * @brief Default constructor is private and doesn't allow calling
+   */
+  ColorQuantizer();
+};
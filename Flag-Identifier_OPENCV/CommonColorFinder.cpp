@@ -13,6 +13,13 @@
  *********************************************************************/
 #include "CommonColorFinder.h"
 
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+
+#include "ColorQuantizer.h"
+
+const float CommonColorFinder::kMinDominantRatio = 0.05f;
+
 /**
  * @brief Default constructor is private and doesn't allow calling
  */
@@ -28,7 +35,21 @@ CommonColorFinder::CommonColorFinder() {
  * @return ColorBucket representing red,blue,green bucket with most counts
  */
 ColorBucket CommonColorFinder::getCommonColorBucket(const Mat& img) {
-  ColorBucket result = findMostCommonBucket(populateHistogram(img));
+  Mat histogram;
+  return getCommonColorBucket(img, histogram);
+}
+
+/**
+ * @brief Returns the most common ColorBucket of an image, counting the
+ *        histogram into a buffer owned by the caller
+ *
+ * @param img Image or region view to generate color bucket from
+ * @param histogram buffer for the histogram, reused when already allocated
+ * @return ColorBucket representing red,blue,green bucket with most counts
+ */
+ColorBucket CommonColorFinder::getCommonColorBucket(const Mat& img, Mat& histogram) {
+  populateHistogram(img, histogram);
+  ColorBucket result = findMostCommonBucket(histogram);
 
   // Calculates ratio of most common color to total pixel count in image
   int total_pixels = img.rows * img.cols;
@@ -44,21 +65,135 @@ ColorBucket CommonColorFinder::getCommonColorBucket(const Mat& img) {
  * @return RGBHolder of most common RGB
  */
 RGBHolder CommonColorFinder::getCommonColor(const ColorBucket cb) {
-  int bucketSize = 32;
-  int common_red = cb.getRedBucket() * bucketSize + (bucketSize / 2);
-  int common_green = cb.getGreenBucket() * bucketSize + (bucketSize / 2);
-  int common_blue = cb.getBlueBucket() * bucketSize + (bucketSize / 2);
-  RGBHolder result(common_red, common_blue, common_green);
+  // Average color of the bucket in the color scheme in use, the middle of
+  // the bucket for BGR
+  int bin = (cb.getRedBucket() << 6) | (cb.getGreenBucket() << 3) | cb.getBlueBucket();
+  Vec3b color = ColorQuantizer::getColor(bin);
+  RGBHolder result(color[2], color[1], color[0]);
   return result;
 }
 
 /**
- * @brief Creates a histogram for a given image with 4x4x4 dimensions
+ * @brief Creates a histogram for a given image with 8x8x8 dimensions
+ *
+ * @param img Input BGR image to test
+ * @return 8x8x8 histogram of img, indexed (red, green, blue) or by the
+ *         channels of the ColorQuantizer scheme in use
+ */
+Mat CommonColorFinder::populateHistogram(const Mat& img) {
+  Mat histogram;
+  populateHistogram(img, histogram);
+  return histogram;
+}
+
+/**
+ * @brief Creates a histogram for a given image with 8x8x8 dimensions in a
+ *        buffer owned by the caller
+ *
+ * @param img Input BGR image to test
+ * @param histogram 8x8x8 histogram of img, indexed (red, green, blue) or
+ *        by the channels of the ColorQuantizer scheme in use,
+ *        reused when already allocated
+ */
+void CommonColorFinder::populateHistogram(const Mat& img, Mat& histogram) {
+  // Create 3D histogram of integers, every count is written below
+  int dims[] = { 8, 8, 8 };
+  histogram.create(3, dims, CV_32S);
+
+  // Flags are mostly long runs of one color, so neighboring pixels are
+  // counted into separate sub-histograms to keep each increment from waiting
+  // on the one before it
+  const int num_sub_histograms = 4;
+  int sub_histograms[num_sub_histograms][8 * 8 * 8] = {};
+
+  // A continuous image is walked as one long row
+  int rows = img.rows;
+  int cols = img.cols;
+  if (img.isContinuous()) {
+    cols *= rows;
+    rows = 1;
+  }
+
+  // Perceptual schemes look every pixel up in the table of the scheme, BGR
+  // buckets are the top 3 bits of each channel and need no table
+  const ushort* table = ColorQuantizer::getScheme() == kColorBgr ? nullptr : ColorQuantizer::getTable();
+
+#if CV_SIMD
+  const int lanes = CV_SIMD_WIDTH;
+  const v_uint16 top_bits = vx_setall_u16(0xE0);
+  const v_uint16 table_bits = vx_setall_u16(0xF8);
+  ushort indices[CV_SIMD_WIDTH];
+#endif
+
+  for (int row = 0; row < rows; ++row) {
+    const uchar* pixel = img.ptr<uchar>(row);
+    int col = 0;
+
+#if CV_SIMD
+    // Bucket index of a pixel is red bucket << 6 | green bucket << 3 | blue
+    // bucket, with each bucket the top 3 bits of the channel (size 32).
+    // With a table, the index is the table entry of the top 5 bits instead.
+    for (; col <= cols - lanes; col += lanes) {
+      v_uint8 blue, green, red;
+      v_load_deinterleave(pixel + col * 3, blue, green, red);
+
+      v_uint16 blue_low, blue_high, green_low, green_high, red_low, red_high;
+      v_expand(blue, blue_low, blue_high);
+      v_expand(green, green_low, green_high);
+      v_expand(red, red_low, red_high);
+
+      if (table == nullptr) {
+        v_uint16 index_low = v_shl<1>(red_low & top_bits) | v_shr<2>(green_low & top_bits) | v_shr<5>(blue_low);
+        v_uint16 index_high = v_shl<1>(red_high & top_bits) | v_shr<2>(green_high & top_bits) | v_shr<5>(blue_high);
+        v_store(indices, index_low);
+        v_store(indices + lanes / 2, index_high);
+      } else {
+        v_uint16 entry_low = v_shl<7>(blue_low & table_bits) | v_shl<2>(green_low & table_bits) | v_shr<3>(red_low);
+        v_uint16 entry_high = v_shl<7>(blue_high & table_bits) | v_shl<2>(green_high & table_bits) | v_shr<3>(red_high);
+        v_store(indices, entry_low);
+        v_store(indices + lanes / 2, entry_high);
+        for (int i = 0; i < lanes; ++i) {
+          indices[i] = table[indices[i]];
+        }
+      }
+
+      for (int i = 0; i < lanes; i += num_sub_histograms) {
+        ++sub_histograms[0][indices[i]];
+        ++sub_histograms[1][indices[i + 1]];
+        ++sub_histograms[2][indices[i + 2]];
+        ++sub_histograms[3][indices[i + 3]];
+      }
+    }
+#endif
+
+    // Remaining pixels of the row
+    for (; col < cols; ++col) {
+      const uchar* bgr = pixel + col * 3;
+      int index = ColorQuantizer::getBin(bgr[0], bgr[1], bgr[2]);
+      ++sub_histograms[col % num_sub_histograms][index];
+    }
+  }
+
+#if CV_SIMD
+  vx_cleanup();
+#endif
+
+  // Merge the sub-histograms, the Mat is laid out (red, green, blue)
+  int* counts = histogram.ptr<int>();
+  for (int i = 0; i < 8 * 8 * 8; ++i) {
+    counts[i] = sub_histograms[0][i] + sub_histograms[1][i] + sub_histograms[2][i] + sub_histograms[3][i];
+  }
+}
+
+/**
+ * @brief Creates a histogram the same way as populateHistogram, one pixel
+ *        at a time through Mat::at. Kept to check and benchmark
+ *        populateHistogram against.
  *
  * @param img Input image to test
- * @return
+ * @return 8x8x8 histogram of img
  */
-Mat CommonColorFinder::populateHistogram(const Mat& img){
+Mat CommonColorFinder::populateHistogramReference(const Mat& img) {
   // Create histogram picture
   // Create an array of the histogram dimensions
   // Size is a constant - the # of buckets in each dimension
@@ -87,12 +222,20 @@ Mat CommonColorFinder::populateHistogram(const Mat& img){
        * 192 - 223
        * 224 - 255
        */
-      int blue_bucket = img.at<Vec3b>(row, col)[0] / bucket_size;
-      int green_bucket = img.at<Vec3b>(row, col)[1] / bucket_size;
-      int red_bucket = img.at<Vec3b>(row, col)[2] / bucket_size;
+      // Other color schemes bucket the pixel through their table
+      const Vec3b& pixel = img.at<Vec3b>(row, col);
+      int first_bucket = pixel[2] / bucket_size;
+      int second_bucket = pixel[1] / bucket_size;
+      int third_bucket = pixel[0] / bucket_size;
+      if (ColorQuantizer::getScheme() != kColorBgr) {
+        int bin = ColorQuantizer::getBin(pixel[0], pixel[1], pixel[2]);
+        first_bucket = bin >> 6;
+        second_bucket = (bin >> 3) & 7;
+        third_bucket = bin & 7;
+      }
 
       // Increment the count at the calculated buckets for histogram
-      ++histogram.at<int>(red_bucket, green_bucket, blue_bucket);
+      ++histogram.at<int>(first_bucket, second_bucket, third_bucket);
     }
   }
   return histogram;
@@ -130,4 +273,55 @@ ColorBucket CommonColorFinder::findMostCommonBucket(const Mat& img) {
   }
   
   return max;
-}
\ No newline at end of file
+}
+/**
+ * @brief Finds the most common buckets of a histogram in one pass, most
+ *        common first. The first bucket is the one findMostCommonBucket
+ *        returns. Every other bucket must hold at least kMinDominantRatio
+ *        of the pixels.
+ *
+ * @param histogram 8x8x8 histogram from populateHistogram
+ * @param total_pixels number of pixels counted in the histogram
+ * @param buckets array of kMaxDominantColors buckets to fill, each with
+ *        its count and ratio of the total pixels
+ * @return number of buckets filled
+ */
+int CommonColorFinder::findDominantBuckets(const Mat& histogram, int total_pixels, ColorBucket* buckets) {
+  const int* counts = histogram.ptr<int>();
+  int num_buckets = 0;
+
+  // Visited red, then blue, then green like findMostCommonBucket, and only
+  // moved past a strictly smaller count, so ties keep the same bucket first
+  for (int r = 0; r < 8; ++r) {
+    for (int b = 0; b < 8; ++b) {
+      for (int g = 0; g < 8; ++g) {
+        int count = counts[(r << 6) | (g << 3) | b];
+        if (count == 0 || (num_buckets == kMaxDominantColors && count <= buckets[num_buckets - 1].getCount())) {
+          continue;
+        }
+
+        // Insert into the sorted list, dropping the last bucket if it's full
+        int position = std::min(num_buckets, kMaxDominantColors - 1);
+        while (position > 0 && buckets[position - 1].getCount() < count) {
+          buckets[position] = buckets[position - 1];
+          --position;
+        }
+        buckets[position].setRedBucket(r);
+        buckets[position].setGreenBucket(g);
+        buckets[position].setBlueBucket(b);
+        buckets[position].setCount(count);
+        num_buckets = std::min(num_buckets + 1, kMaxDominantColors);
+      }
+    }
+  }
+
+  // Ratios of the total, stopping at the first color that's too rare
+  for (int i = 0; i < num_buckets; ++i) {
+    float ratio = total_pixels > 0 ? (float)buckets[i].getCount() / float(total_pixels) : 0.0f;
+    if (i > 0 && ratio < kMinDominantRatio) {
+      return i;
+    }
+    buckets[i].setCommonColorRatio(ratio);
+  }
+  return num_buckets;
+}
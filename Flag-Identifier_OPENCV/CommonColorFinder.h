@@ -53,13 +53,63 @@ class CommonColorFinder {
   static ColorBucket getCommonColorBucket(const Mat& img);
 
   /**
-   * @brief Creates a histogram for a given image with 4x4x4 dimensions
+   * @brief Returns the most common ColorBucket of an image, counting the
+   *        histogram into a buffer owned by the caller
    *
-   * @param img Input image to test
-   * @return
+   * @param img Image or region view to generate color bucket from
+   * @param histogram buffer for the histogram, reused when already allocated
+   * @return ColorBucket representing red,blue,green bucket with most counts
+   */
+  static ColorBucket getCommonColorBucket(const Mat& img, Mat& histogram);
+
+  /**
+   * @brief Creates a histogram for a given image with 8x8x8 dimensions
+   *
+   * @param img Input BGR image to test
+   * @return 8x8x8 histogram of img, indexed (red, green, blue) or by the
+   *         channels of the ColorQuantizer scheme in use
    */
   static Mat populateHistogram(const Mat& img);
 
+  /**
+   * @brief Creates a histogram for a given image with 8x8x8 dimensions in a
+   *        buffer owned by the caller
+   *
+   * @param img Input BGR image to test
+   * @param histogram 8x8x8 histogram of img, indexed (red, green, blue) or
+   *        by the channels of the ColorQuantizer scheme in use,
+   *        reused when already allocated
+   */
+  static void populateHistogram(const Mat& img, Mat& histogram);
+
+  /**
+   * @brief Finds the most common buckets of a histogram in one pass, most
+   *        common first. The first bucket is the one findMostCommonBucket
+   *        returns. Every other bucket must hold at least kMinDominantRatio
+   *        of the pixels.
+   *
+   * @param histogram 8x8x8 histogram from populateHistogram
+   * @param total_pixels number of pixels counted in the histogram
+   * @param buckets array of kMaxDominantColors buckets to fill, each with
+   *        its count and ratio of the total pixels
+   * @return number of buckets filled
+   */
+  static int findDominantBuckets(const Mat& histogram, int total_pixels, ColorBucket* buckets);
+
+  // Smallest share of the pixels a color other than the most common needs
+  // to count as dominant
+  static const float kMinDominantRatio;
+
+  /**
+   * @brief Creates a histogram the same way as populateHistogram, one pixel
+   *        at a time through Mat::at. Kept to check and benchmark
+   *        populateHistogram against.
+   *
+   * @param img Input image to test
+   * @return 8x8x8 histogram of img
+   */
+  static Mat populateHistogramReference(const Mat& img);
+
   private:
 
   /**
@@ -0,0 +1,148 @@
+/*********************************************************************
+ * @file       ConsoleSink.cpp
+ * @brief      ConsoleSink prints how each filter of findFlag narrowed down
+ *              the flags, the way the program always printed its steps.
+ *
+ * @author Joseph Lan
+ * @author Andy Tran
+ * @author Kevin Xu
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "ConsoleSink.h"
+
+/**
+ * @brief Constructor for a sink writing to a stream
+ *
+ * @param index flag metadata the results point into
+ * @param out stream to write to on flush
+ */
+ConsoleSink::ConsoleSink(const FlagIndex& index, std::ostream& out) : index_(index), out_(out) {}
+
+/**
+ * @brief Destructor writes out anything still buffered
+ */
+ConsoleSink::~ConsoleSink() {
+  flush();
+}
+
+/**
+ * @brief Prints the steps of one result into the buffer
+ *
+ * @param source name of the test image
+ * @param image decoded test image, not used
+ * @param result result of findFlag for the image
+ */
+void ConsoleSink::write(const std::string& source, const Mat& /* image */, const FlagResult& result) {
+  buffer_ << "Testing: " << source << " in program.\n";
+  if (!result.decoded) {
+    buffer_ << "No matches found for \"" << source << "\"\n";
+    return;
+  }
+
+  const ColorBucket& image_bucket = result.image_bucket;
+  buffer_ << "Test flag RBG bucket information: " << image_bucket.getRedBucket() <<
+    ", " << image_bucket.getBlueBucket() << ", " << image_bucket.getGreenBucket() << "\n\n";
+
+  // Flags each filter started with, the remaining flags of the step before
+  const std::vector<int>* previous = nullptr;
+  for (FlagStage stage : result.filter_order) {
+    std::string operation = getStageName(stage);
+    if (previous != nullptr) {
+      buffer_ << "\n"; // Line break
+    }
+    buffer_ << "--" << operation << "--\n";
+
+    if (stage == kStageMcc) {
+      buffer_ << "Dominant colors matched: " << result.color_matches << " of " << result.num_dominant_colors << "\n";
+    } else if (stage == kStageMccRatio) {
+      for (const ColorShare& share : result.color_shares) {
+        buffer_ << index_.getName(share.flag) << " image_ratio: " << share.image_share << " index_ratio: "
+                << share.flag_share << "\n";
+      }
+    } else if (stage == kStageCanny && previous != nullptr) {
+      printRatios("Test ratio", result.edge_ratio, *previous,
+                  index_.getEdgeRatios(kRegionWhole, kEdgeScaleNative), "ratio");
+    } else if (stage == kStageQuadrant) {
+      const ColorBucket& ul_bucket = result.quadrant_bucket;
+      buffer_ << "Upper left RBG bucket information: " << ul_bucket.getRedBucket() <<
+        ", " << ul_bucket.getBlueBucket() << ", " << ul_bucket.getGreenBucket() << "\n";
+      buffer_ << "Upper left image_ratio: " << ul_bucket.getCommonColorRatio() << "\n";
+      if (result.quadrant_edge_ratio >= 0.0f) {
+        buffer_ << "Upper left edge ratio: " << result.quadrant_edge_ratio << "\n";
+      }
+    } else if (stage == kStageNearest) {
+      for (const Neighbor& neighbor : result.neighbors) {
+        buffer_ << "distance: " << neighbor.distance << " " << index_.getName(neighbor.id) << "\n";
+      }
+    } else if (stage == result.deciding_stage && !result.confidences.empty()) {
+      for (size_t i = 0; i < result.neighbors.size(); ++i) {
+        buffer_ << "distance: " << result.neighbors[i].distance << " confidence: " << result.confidences[i] << " "
+                << index_.getName(result.neighbors[i].id) << "\n";
+      }
+    }
+
+    // Print out remaining options
+    if (result.stage_flags[stage].empty() && result.candidates_out[stage] > 0) {
+      buffer_ << "Size of possible flags after " << operation << ": " << result.candidates_out[stage] << "\n";
+    } else {
+      printOptions(result.stage_flags[stage], operation);
+    }
+    previous = &result.stage_flags[stage];
+  }
+  buffer_ << "Result found after " << getStageName(result.deciding_stage) << ".\n";
+
+  // No matches found
+  if (result.flags.empty()) {
+    buffer_ << "No matches found for \"" << source << "\"\n";
+  }
+  for (int flag : result.flags) {
+    buffer_ << "The flag in the image is from: " << index_.getName(flag) << "\n";
+  }
+}
+
+/**
+ * @brief Writes the buffer to the stream and empties it
+ */
+void ConsoleSink::flush() {
+  out_ << buffer_.str();
+  out_.flush();
+  buffer_.str("");
+}
+
+/**
+ * @brief Prints the test ratio of a filter and the stored ratio of every
+ *        flag the filter looked at
+ *
+ * @param label name of the test ratio
+ * @param test_ratio ratio measured on the test image
+ * @param flags flags the filter looked at
+ * @param ratios stored ratio of every flag by id
+ * @param flag_label name printed before each stored ratio
+ */
+void ConsoleSink::printRatios(const std::string& label, float test_ratio, const std::vector<int>& flags,
+                              const float* ratios, const std::string& flag_label) {
+  buffer_ << label << ": " << test_ratio << "\n";
+  buffer_ << "min: " << test_ratio - FlagFinder::kAcceptableError << "\n";
+  buffer_ << "max: " << test_ratio + FlagFinder::kAcceptableError << "\n";
+  for (int flag : flags) {
+    buffer_ << flag_label << ": " << ratios[flag] << "\n";
+  }
+}
+
+/**
+ * @brief Prints out the flags remaining after a step
+ *
+ * @param options flags remaining
+ * @param operation name of the filter that was run
+ */
+void ConsoleSink::printOptions(const std::vector<int>& options, const std::string& operation) {
+  buffer_ << "Possible flags after " << operation << ": \n";
+  for (size_t i = 0; i < options.size(); ++i) {
+    buffer_ << "[" << i << "]: " << index_.getName(options[i]) << "\n";
+  }
+}
@@ -0,0 +1,87 @@
+/*********************************************************************
+ * @file       ConsoleSink.h
+ * @brief      ConsoleSink prints how each filter of findFlag narrowed down
+ *              the flags, the way the program always printed its steps.
+ *
+ * @author Joseph Lan
+ * @author Andy Tran
+ * @author Kevin Xu
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "FlagIndex.h"
+#include "ResultSink.h"
+
+/**
+ * @class ConsoleSink writes the steps of each result to a text buffer that
+ *        is copied to the stream on flush. The finder must trace for the
+ *        remaining flags of each step to be listed.
+ */
+class ConsoleSink : public ResultSink {
+  public:
+
+  /**
+   * @brief Constructor for a sink writing to a stream
+   *
+   * @param index flag metadata the results point into
+   * @param out stream to write to on flush
+   */
+  ConsoleSink(const FlagIndex& index, std::ostream& out);
+
+  /**
+   * @brief Destructor writes out anything still buffered
+   */
+  ~ConsoleSink();
+
+  /**
+   * @brief Prints the steps of one result into the buffer
+   *
+   * @param source name of the test image
+   * @param image decoded test image, not used
+   * @param result result of findFlag for the image
+   */
+  void write(const std::string& source, const Mat& image, const FlagResult& result);
+
+  /**
+   * @brief Writes the buffer to the stream and empties it
+   */
+  void flush();
+
+  private:
+
+  /**
+   * @brief Prints the test ratio of a filter and the stored ratio of every
+   *        flag the filter looked at
+   *
+   * @param label name of the test ratio
+   * @param test_ratio ratio measured on the test image
+   * @param flags flags the filter looked at
+   * @param ratios stored ratio of every flag by id
+   * @param flag_label name printed before each stored ratio
+   */
+  void printRatios(const std::string& label, float test_ratio, const std::vector<int>& flags,
+                   const float* ratios, const std::string& flag_label);
+
+  /**
+   * @brief Prints out the flags remaining after a step
+   *
+   * @param options flags remaining
+   * @param operation name of the filter that was run
+   */
+  void printOptions(const std::vector<int>& options, const std::string& operation);
+
+  const FlagIndex& index_;
+  std::ostream& out_;
+  std::ostringstream buffer_;
+};
@@ -0,0 +1,473 @@
+/*********************************************************************
+ * @file       EdgeRatioFinder.cpp
+ * @brief      EdgeRatioFinder uses opencv canny edge detection to find how
+ *              much of a given Mat image is made up of edges.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "EdgeRatioFinder.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Number of rows test images are resized to before the edge filter
+const int EdgeRatioFinder::kWorkingRows = 240;
+
+// Canny thresholds of the edge filter
+static const int kLowThreshold = 20;
+static const int kHighThreshold = 60;
+
+// Weights of the 7 wide gaussian with a deviation of 2 in 8 bit fixed point,
+// rounded the same way as the bit exact kernel GaussianBlur uses for 8 bit
+// images so the blurred rows match it pixel for pixel
+static const int kGaussianRadius = 3;
+static const uint32_t kGaussianWeights[] = { 18, 34, 48, 56, 48, 34, 18 };
+
+// Horizontally smoothed rows kept for the vertical pass, enough for the 7
+// rows around any row even where they are reflected at the border
+static const int kSmoothedRows = 8;
+
+// tan(22.5 degrees) in 15 bit fixed point, the same as Canny
+static const int kTan22 = 13573;
+
+/**
+ * @brief Returns the position of the lowest set bit of a word
+ *
+ * @param word word with at least one bit set
+ * @return position 0-63 of the lowest set bit
+ */
+static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  unsigned long position;
+  _BitScanForward64(&position, word);
+  return (int)position;
+#elif defined(__GNUC__)
+  return __builtin_ctzll(word);
+#else
+  int position = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++position;
+  }
+  return position;
+#endif
+}
+
+/**
+ * @brief Returns the number of set bits in a word
+ *
+ * @param word word to count
+ * @return number of set bits
+ */
+static int countBits(uint64_t word) {
+#if defined(_MSC_VER) && defined(_WIN64)
+  return (int)__popcnt64(word);
+#elif defined(__GNUC__)
+  return __builtin_popcountll(word);
+#else
+  int count = 0;
+  while (word != 0) {
+    word &= word - 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
+/**
+ * @brief Reflects a position outside a row or column back into it without
+ *        repeating the edge pixel, the default border of GaussianBlur
+ *
+ * @param position position to reflect
+ * @param length number of pixels in the row or column
+ * @return position inside 0 to length - 1
+ */
+static int reflectBorder(int position, int length) {
+  if (length == 1) {
+    return 0;
+  }
+  while (position < 0 || position >= length) {
+    if (position < 0) {
+      position = -position;
+    } else {
+      position = 2 * length - position - 2;
+    }
+  }
+  return position;
+}
+
+/**
+ * @brief Default constructor is private and doesn't allow calling
+ */
+EdgeRatioFinder::EdgeRatioFinder() {
+  // Do nothing
+}
+
+/**
+ * @brief Resizes an image to kWorkingRows rows, keeping its aspect ratio
+ *
+ * @param img Image to resize
+ * @return resized copy of img
+ */
+Mat EdgeRatioFinder::resizeToWorkingSize(const Mat& img) {
+  Mat resized;
+  resizeToWorkingSize(img, resized);
+  return resized;
+}
+
+/**
+ * @brief Resizes an image to kWorkingRows rows into an existing Mat, which
+ *        keeps its memory when it already has the resized dimensions
+ *
+ * @param img Image to resize
+ * @param resized Mat to resize into
+ */
+void EdgeRatioFinder::resizeToWorkingSize(const Mat& img, Mat& resized) {
+  float change = (float)img.rows / kWorkingRows;
+  float width = (float)img.cols / change;
+  Size resizing((int)width, kWorkingRows);
+  resize(img, resized, resizing, INTER_LINEAR);
+}
+
+/**
+ * @brief Returns the ratio of canny edge pixels to all pixels in an image
+ *
+ * @param img BGR image to test, it is not changed
+ * @return edge pixel count divided by total pixel count
+ */
+float EdgeRatioFinder::getEdgeRatio(const Mat& img) {
+  FeatureArena arena;
+  return getEdgeRatio(img, arena);
+}
+
+/**
+ * @brief Returns the ratio of canny edge pixels to all pixels in an image,
+ *        working in the buffers of an arena instead of allocating its own.
+ *        Grayscale, blur, canny and the count run together a few rows at a
+ *        time, so no full size intermediate image is written. The count is
+ *        the same as getEdgeRatioReference.
+ *
+ * @param img BGR image or region view to test, it is not changed
+ * @param arena buffers owned by the calling thread
+ * @return edge pixel count divided by total pixel count
+ */
+float EdgeRatioFinder::getEdgeRatio(const Mat& img, FeatureArena& arena) {
+  if (img.empty() || img.type() != CV_8UC3) {
+    return getEdgeRatioReference(img);
+  }
+  const int rows = img.rows;
+  const int cols = img.cols;
+  const int padded = cols + 2;
+  const int words = (cols + 63) / 64;
+
+  // Size the buffers, which only allocates when they grow
+  arena.gray_row.resize(cols + 2 * kGaussianRadius);
+  arena.smoothed_rows.resize((size_t)kSmoothedRows * cols);
+  arena.blurred_rows.resize(3 * (size_t)padded);
+  arena.dx_rows.resize(3 * (size_t)cols);
+  arena.dy_rows.resize(3 * (size_t)cols);
+  arena.magnitude_rows.resize(4 * (size_t)padded);
+  arena.strong_edges.assign((size_t)rows * words, 0);
+  arena.weak_edges.assign((size_t)rows * words, 0);
+
+  // Image row held by each smoothed row, -1 when empty
+  int smoothed_source[kSmoothedRows];
+  for (int k = 0; k < kSmoothedRows; ++k) {
+    smoothed_source[k] = -1;
+  }
+
+  // Magnitudes outside the image are 0, kept in the fourth magnitude row
+  int* zero_magnitudes = &arena.magnitude_rows[3 * (size_t)padded];
+  std::fill(zero_magnitudes, zero_magnitudes + padded, 0);
+
+  // Each pass blurs row i, finds the gradient of row i - 1 and keeps the
+  // canny edges of row i - 2, the rows each step needs around it
+  for (int i = 0; i < rows + 2; ++i) {
+    if (i < rows) {
+      blurRow(img, i, arena, smoothed_source);
+    }
+    if (i >= 1 && i - 1 < rows) {
+      gradientRow(i - 1, rows, cols, arena);
+    }
+    if (i >= 2) {
+      suppressRow(i - 2, rows, cols, arena);
+    }
+  }
+
+  // Grow strong edges into the weak edges touching them. Only strong edges
+  // with a weak edge in the 3x3 around them start a search, found for 64
+  // pixels at once by spreading the weak bits of the rows around them.
+  const uint64_t* strong = arena.strong_edges.data();
+  const uint64_t* weak = arena.weak_edges.data();
+  for (int r = 0; r < rows; ++r) {
+    const uint64_t* weak_above = weak + (size_t)std::max(r - 1, 0) * words;
+    const uint64_t* weak_middle = weak + (size_t)r * words;
+    const uint64_t* weak_below = weak + (size_t)std::min(r + 1, rows - 1) * words;
+    for (int w = 0; w < words; ++w) {
+      uint64_t around = weak_above[w] | weak_middle[w] | weak_below[w];
+      uint64_t around_left = w > 0 ? weak_above[w - 1] | weak_middle[w - 1] | weak_below[w - 1] : 0;
+      uint64_t around_right = w + 1 < words ? weak_above[w + 1] | weak_middle[w + 1] | weak_below[w + 1] : 0;
+      around |= (around << 1) | (around >> 1) | (around_left >> 63) | (around_right << 63);
+
+      uint64_t word = strong[(size_t)r * words + w] & around;
+      while (word != 0) {
+        int c = w * 64 + lowestBit(word);
+        word &= word - 1;
+        growEdge(r, c, rows, cols, arena);
+      }
+    }
+  }
+
+  // Count edges
+  int edged_count = 0;
+  for (uint64_t word : arena.strong_edges) {
+    edged_count += countBits(word);
+  }
+  int edged_pix = rows * cols;
+  return (float)edged_count / (float)edged_pix;
+}
+
+/**
+ * @brief Returns the ratio of canny edge pixels to all pixels in an image
+ *        through the OpenCV cvtColor, GaussianBlur and Canny chain. Kept to
+ *        check and benchmark getEdgeRatio against.
+ *
+ * @param img BGR image to test, it is not changed
+ * @return edge pixel count divided by total pixel count
+ */
+float EdgeRatioFinder::getEdgeRatioReference(const Mat& img) {
+
+  // Define variables for edge counting
+  const int gaussian_kernel = 7;
+  const double gaussian_deviation = 2.0;
+  const int thresh1 = 20;
+  const int thresh2 = 60;
+
+  // Convert image into canny edge image
+  Mat gray, blurred, edges;
+  cvtColor(img, gray, COLOR_BGR2GRAY);
+  GaussianBlur(gray, blurred, Size(gaussian_kernel, gaussian_kernel), gaussian_deviation, gaussian_deviation);
+  Canny(blurred, edges, thresh1, thresh2);
+
+  // Count edges
+  int edged_count = countEdgePixels(edges);
+  int edged_pix = edges.rows * edges.cols;
+  return (float)edged_count / (float)edged_pix;
+}
+
+/**
+ * @brief Blurs one row of an image into the blurred rows of an arena. The
+ *        grayscale rows around it are smoothed horizontally first, unless
+ *        they are still kept from an earlier row.
+ *
+ * @param img BGR image being measured
+ * @param row row to blur
+ * @param arena buffers owned by the calling thread
+ * @param smoothed_source image row held by each smoothed row, -1 when empty
+ */
+void EdgeRatioFinder::blurRow(const Mat& img, int row, FeatureArena& arena, int* smoothed_source) {
+  const int rows = img.rows;
+  const int cols = img.cols;
+  const uint16_t* smoothed[2 * kGaussianRadius + 1];
+  const uint32_t w0 = kGaussianWeights[0];
+  const uint32_t w1 = kGaussianWeights[1];
+  const uint32_t w2 = kGaussianWeights[2];
+  const uint32_t w3 = kGaussianWeights[3];
+
+  for (int t = 0; t < 2 * kGaussianRadius + 1; ++t) {
+    int source = reflectBorder(row + t - kGaussianRadius, rows);
+    int slot = source % kSmoothedRows;
+    uint16_t* out = &arena.smoothed_rows[(size_t)slot * cols];
+    smoothed[t] = out;
+    if (smoothed_source[slot] == source) {
+      continue;
+    }
+    smoothed_source[slot] = source;
+
+    // Grayscale the same way as cvtColor, in 15 bit fixed point, leaving
+    // room for the reflected columns on each side
+    const uchar* bgr = img.ptr<uchar>(source);
+    uchar* gray = arena.gray_row.data() + kGaussianRadius;
+    for (int c = 0; c < cols; ++c) {
+      gray[c] = (uchar)((bgr[0] * 3735 + bgr[1] * 19235 + bgr[2] * 9798 + (1 << 14)) >> 15);
+      bgr += 3;
+    }
+    for (int k = 1; k <= kGaussianRadius; ++k) {
+      gray[-k] = gray[reflectBorder(-k, cols)];
+      gray[cols - 1 + k] = gray[reflectBorder(cols - 1 + k, cols)];
+    }
+
+    // Smooth horizontally. The kernel is symmetric, so each pair of pixels
+    // the same distance from the center shares one weight.
+    for (int c = 0; c < cols; ++c) {
+      out[c] = (uint16_t)(w0 * (gray[c - 3] + gray[c + 3]) + w1 * (gray[c - 2] + gray[c + 2]) +
+                          w2 * (gray[c - 1] + gray[c + 1]) + w3 * gray[c]);
+    }
+  }
+
+  // Smooth vertically and round back to 8 bits, repeating the side pixels
+  // into the padding the gradient reads
+  uchar* blurred = &arena.blurred_rows[(size_t)(row % 3) * (cols + 2)] + 1;
+  for (int c = 0; c < cols; ++c) {
+    uint32_t sum = w0 * (smoothed[0][c] + smoothed[6][c]) + w1 * (smoothed[1][c] + smoothed[5][c]) +
+                   w2 * (smoothed[2][c] + smoothed[4][c]) + w3 * smoothed[3][c];
+    blurred[c] = (uchar)((sum + (1 << 15)) >> 16);
+  }
+  blurred[-1] = blurred[0];
+  blurred[cols] = blurred[cols - 1];
+}
+
+/**
+ * @brief Finds the 3x3 sobel gradient and its L1 magnitude for one blurred
+ *        row, repeating the top and bottom rows at the border like Canny
+ *
+ * @param row row to find the gradient of
+ * @param rows number of rows in the image
+ * @param cols number of columns in the image
+ * @param arena buffers owned by the calling thread
+ */
+void EdgeRatioFinder::gradientRow(int row, int rows, int cols, FeatureArena& arena) {
+  const int padded = cols + 2;
+  const uchar* above = &arena.blurred_rows[(size_t)(std::max(row - 1, 0) % 3) * padded] + 1;
+  const uchar* middle = &arena.blurred_rows[(size_t)(row % 3) * padded] + 1;
+  const uchar* below = &arena.blurred_rows[(size_t)(std::min(row + 1, rows - 1) % 3) * padded] + 1;
+  int16_t* dx = &arena.dx_rows[(size_t)(row % 3) * cols];
+  int16_t* dy = &arena.dy_rows[(size_t)(row % 3) * cols];
+  int* magnitude = &arena.magnitude_rows[(size_t)(row % 3) * padded] + 1;
+
+  // Gradient and magnitude are separate loops so each is simple enough for
+  // the compiler to vectorize
+  for (int c = 0; c < cols; ++c) {
+    dx[c] = (int16_t)((above[c + 1] - above[c - 1]) + 2 * (middle[c + 1] - middle[c - 1]) + (below[c + 1] - below[c - 1]));
+    dy[c] = (int16_t)((below[c - 1] + 2 * below[c] + below[c + 1]) - (above[c - 1] + 2 * above[c] + above[c + 1]));
+  }
+  for (int c = 0; c < cols; ++c) {
+    magnitude[c] = std::abs(dx[c]) + std::abs(dy[c]);
+  }
+  magnitude[-1] = 0;
+  magnitude[cols] = 0;
+}
+
+/**
+ * @brief Keeps the pixels of one row that are the largest magnitude along
+ *        their gradient, marking them strong or weak edges by the canny
+ *        thresholds
+ *
+ * @param row row to mark edges in
+ * @param rows number of rows in the image
+ * @param cols number of columns in the image
+ * @param arena buffers owned by the calling thread
+ */
+void EdgeRatioFinder::suppressRow(int row, int rows, int cols, FeatureArena& arena) {
+  const int padded = cols + 2;
+  const int words = (cols + 63) / 64;
+  const int* zero_magnitudes = &arena.magnitude_rows[3 * (size_t)padded] + 1;
+  const int* above = row > 0 ? &arena.magnitude_rows[(size_t)((row - 1) % 3) * padded] + 1 : zero_magnitudes;
+  const int* middle = &arena.magnitude_rows[(size_t)(row % 3) * padded] + 1;
+  const int* below = row + 1 < rows ? &arena.magnitude_rows[(size_t)((row + 1) % 3) * padded] + 1 : zero_magnitudes;
+  const int16_t* dx = &arena.dx_rows[(size_t)(row % 3) * cols];
+  const int16_t* dy = &arena.dy_rows[(size_t)(row % 3) * cols];
+  uint64_t* strong = &arena.strong_edges[(size_t)row * words];
+  uint64_t* weak = &arena.weak_edges[(size_t)row * words];
+
+  // Build each word of bits at once. The neighbors are chosen with selects
+  // instead of branches, since edges are too scattered to predict.
+  for (int w = 0; w < words; ++w) {
+    uint64_t strong_word = 0;
+    uint64_t weak_word = 0;
+    int end = std::min(64, cols - w * 64);
+
+    // Most of a flag is flat color, so skip words with no magnitude
+    // above the low threshold before looking at directions
+    int largest = 0;
+    for (int b = 0; b < end; ++b) {
+      largest = std::max(largest, middle[w * 64 + b]);
+    }
+    if (largest <= kLowThreshold) {
+      strong[w] = 0;
+      weak[w] = 0;
+      continue;
+    }
+
+    for (int b = 0; b < end; ++b) {
+      int c = w * 64 + b;
+      int m = middle[c];
+
+      // Compare against the two neighbors closest to the gradient direction.
+      // Diagonal neighbors both have to be smaller, so 1 is added to the
+      // second one to share the test of the other directions.
+      int x = std::abs(dx[c]);
+      int y = std::abs(dy[c]) << 15;
+      int tg22x = x * kTan22;
+      int s = (dx[c] ^ dy[c]) < 0 ? -1 : 1;
+      bool is_horizontal = y < tg22x;
+      bool is_vertical = y > tg22x + (x << 16);
+      int first = is_horizontal ? middle[c - 1] : (is_vertical ? above[c] : above[c - s]);
+      int second = is_horizontal ? middle[c + 1] : (is_vertical ? below[c] : below[c + s] + 1);
+      uint64_t is_edge = (uint64_t)(m > kLowThreshold && m > first && m >= second);
+      uint64_t is_strong = (uint64_t)(m > kHighThreshold);
+      strong_word |= (is_edge & is_strong) << b;
+      weak_word |= (is_edge & (is_strong ^ 1)) << b;
+    }
+    strong[w] = strong_word;
+    weak[w] = weak_word;
+  }
+}
+
+/**
+ * @brief Turns every weak edge connected to a strong edge into a strong edge
+ *
+ * @param row row of the strong edge
+ * @param col column of the strong edge
+ * @param rows number of rows in the image
+ * @param cols number of columns in the image
+ * @param arena buffers owned by the calling thread
+ */
+void EdgeRatioFinder::growEdge(int row, int col, int rows, int cols, FeatureArena& arena) {
+  const int words = (cols + 63) / 64;
+  uint64_t* strong = arena.strong_edges.data();
+  uint64_t* weak = arena.weak_edges.data();
+  std::vector<int>& stack = arena.edge_stack;
+
+  stack.push_back(row * cols + col);
+  while (!stack.empty()) {
+    int r = stack.back() / cols;
+    int c = stack.back() % cols;
+    stack.pop_back();
+
+    // Check the 8 neighbors
+    for (int nr = std::max(r - 1, 0); nr <= std::min(r + 1, rows - 1); ++nr) {
+      for (int nc = std::max(c - 1, 0); nc <= std::min(c + 1, cols - 1); ++nc) {
+        size_t word = (size_t)nr * words + (nc >> 6);
+        uint64_t bit = (uint64_t)1 << (nc & 63);
+        if ((weak[word] & bit) != 0) {
+          weak[word] &= ~bit;
+          strong[word] |= bit;
+          stack.push_back(nr * cols + nc);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Returns number of edge pixels in an image through canny edge
+ *        detection
+ *
+ * @param img is the edge image to count
+ * @return count of edge pixels
+ */
+int EdgeRatioFinder::countEdgePixels(const Mat& img) {
+  // Every non zero pixel is an edge, counted with OpenCV's vectorized count
+  return countNonZero(img);
+}
@@ -0,0 +1,153 @@
+/*********************************************************************
+ * @file       EdgeRatioFinder.h
+ * @brief      EdgeRatioFinder uses opencv canny edge detection to find how
+ *              much of a given Mat image is made up of edges.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "FeatureArena.h"
+
+using namespace cv;
+
+/**
+ * @brief Image sizes that edge ratios are stored for. Native is the image as
+ *        it was read and working is resized to the rows the filters use.
+ */
+enum EdgeScale {
+  kEdgeScaleNative = 0,
+  kEdgeScaleWorking,
+  kNumEdgeScales
+};
+
+/**
+ * @class EdgeRatioFinder is a helper class that runs the canny edge detection
+ *          used by the edge filters and returns edge pixel counts and ratios.
+ */
+class EdgeRatioFinder {
+
+  public:
+
+  // Number of rows test images are resized to before the edge filter
+  static const int kWorkingRows;
+
+  /**
+   * @brief Resizes an image to kWorkingRows rows, keeping its aspect ratio
+   *
+   * @param img Image to resize
+   * @return resized copy of img
+   */
+  static Mat resizeToWorkingSize(const Mat& img);
+
+  /**
+   * @brief Resizes an image to kWorkingRows rows into an existing Mat, which
+   *        keeps its memory when it already has the resized dimensions
+   *
+   * @param img Image to resize
+   * @param resized Mat to resize into
+   */
+  static void resizeToWorkingSize(const Mat& img, Mat& resized);
+
+  /**
+   * @brief Returns the ratio of canny edge pixels to all pixels in an image
+   *
+   * @param img BGR image to test, it is not changed
+   * @return edge pixel count divided by total pixel count
+   */
+  static float getEdgeRatio(const Mat& img);
+
+  /**
+   * @brief Returns the ratio of canny edge pixels to all pixels in an image,
+   *        working in the buffers of an arena instead of allocating its own.
+   *        Grayscale, blur, canny and the count run together a few rows at a
+   *        time, so no full size intermediate image is written. The count is
+   *        the same as getEdgeRatioReference.
+   *
+   * @param img BGR image or region view to test, it is not changed
+   * @param arena buffers owned by the calling thread
+   * @return edge pixel count divided by total pixel count
+   */
+  static float getEdgeRatio(const Mat& img, FeatureArena& arena);
+
+  /**
+   * @brief Returns the ratio of canny edge pixels to all pixels in an image
+   *        through the OpenCV cvtColor, GaussianBlur and Canny chain. Kept to
+   *        check and benchmark getEdgeRatio against.
+   *
+   * @param img BGR image to test, it is not changed
+   * @return edge pixel count divided by total pixel count
+   */
+  static float getEdgeRatioReference(const Mat& img);
+
+  /**
+   * @brief Returns number of edge pixels in an image through canny edge
+   *        detection
+   *
+   * @param img is the edge image to count
+   * @return count of edge pixels
+   */
+  static int countEdgePixels(const Mat& img);
+
+  private:
+
+  /**
+   * @brief Default constructor is private and doesn't allow calling
+   */
+  EdgeRatioFinder();
+
+  /**
+   * @brief Blurs one row of an image into the blurred rows of an arena. The
+   *        grayscale rows around it are smoothed horizontally first, unless
+   *        they are still kept from an earlier row.
+   *
+   * @param img BGR image being measured
+   * @param row row to blur
+   * @param arena buffers owned by the calling thread
+   * @param smoothed_source image row held by each smoothed row, -1 when empty
+   */
+  static void blurRow(const Mat& img, int row, FeatureArena& arena, int* smoothed_source);
+
+  /**
+   * @brief Finds the 3x3 sobel gradient and its L1 magnitude for one blurred
+   *        row, repeating the top and bottom rows at the border like Canny
+   *
+   * @param row row to find the gradient of
+   * @param rows number of rows in the image
+   * @param cols number of columns in the image
+   * @param arena buffers owned by the calling thread
+   */
+  static void gradientRow(int row, int rows, int cols, FeatureArena& arena);
+
+  /**
+   * @brief Keeps the pixels of one row that are the largest magnitude along
+   *        their gradient, marking them strong or weak edges by the canny
+   *        thresholds
+   *
+   * @param row row to mark edges in
+   * @param rows number of rows in the image
+   * @param cols number of columns in the image
+   * @param arena buffers owned by the calling thread
+   */
+  static void suppressRow(int row, int rows, int cols, FeatureArena& arena);
+
+  /**
+   * @brief Turns every weak edge connected to a strong edge into a strong edge
+   *
+   * @param row row of the strong edge
+   * @param col column of the strong edge
+   * @param rows number of rows in the image
+   * @param cols number of columns in the image
+   * @param arena buffers owned by the calling thread
+   */
+  static void growEdge(int row, int col, int rows, int cols, FeatureArena& arena);
+};
@@ -0,0 +1,48 @@
+/*********************************************************************
+ * @file       FeatureArena.h
+ * @brief      FeatureArena holds the buffers the color and edge features of
+ *              a test image are measured in, so they are only allocated once
+ *              per thread.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+using namespace cv;
+
+/**
+ * @brief FeatureArena is owned by one thread. Each buffer keeps its memory
+ *        between images and is only reallocated when it has to grow, so
+ *        measuring regions of the same size never allocates. Regions are
+ *        passed in as views from getRegion and are never copied.
+ */
+struct FeatureArena {
+
+  // 8x8x8 color histogram
+  Mat histogram;
+
+  // Rows of the edge kernel in flight, see EdgeRatioFinder::getEdgeRatio.
+  // Only a few rows of each step are kept, so they stay in cache.
+  std::vector<uchar> gray_row;
+  std::vector<uint16_t> smoothed_rows;
+  std::vector<uchar> blurred_rows;
+  std::vector<int16_t> dx_rows;
+  std::vector<int16_t> dy_rows;
+  std::vector<int> magnitude_rows;
+
+  // One bit per pixel for strong and weak canny edges, and the strong edges
+  // still to grow into their weak neighbors
+  std::vector<uint64_t> strong_edges;
+  std::vector<uint64_t> weak_edges;
+  std::vector<int> edge_stack;
+};
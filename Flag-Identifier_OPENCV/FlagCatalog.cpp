@@ -0,0 +1,156 @@
+/*********************************************************************
+ * @file       FlagCatalog.cpp
+ * @brief      FlagCatalog publishes snapshots of the flag index and the
+ *              finder built from it, so a changed index file can be
+ *              loaded while queries keep running.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagCatalog.h"
+
+#include <atomic>
+
+#include "ColorQuantizer.h"
+
+/**
+ * @brief Constructor creates a catalog of no flags
+ *
+ * @param setup called on the index and finder of every snapshot, may be
+ *        empty
+ */
+FlagCatalog::FlagCatalog(const FinderSetup& setup) : setup_(setup), path_mtime_(0), path_size_(0) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  swapIn(std::make_shared<IndexSnapshot>());
+}
+
+/**
+ * @brief Getter for the current snapshot
+ *
+ * @return snapshot to search and report results with
+ */
+std::shared_ptr<const IndexSnapshot> FlagCatalog::acquire() const {
+  return std::atomic_load(&current_);
+}
+
+/**
+ * @brief Publishes a copy of an index
+ *
+ * @param index records to publish
+ */
+void FlagCatalog::publish(const FlagIndex& index) {
+  std::shared_ptr<IndexSnapshot> next = std::make_shared<IndexSnapshot>();
+  next->index.copyFrom(index);
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  swapIn(next);
+}
+
+/**
+ * @brief Loads an index file and publishes it. The file is remembered so
+ *        reloadIfChanged can pick up later saves.
+ *
+ * @param path index file written by FlagIndex::save
+ * @param log stream to print to if the file can't be used
+ * @return true if the file exists and has the current version and
+ *         the color scheme in use
+ */
+bool FlagCatalog::load(const std::string& path, std::ostream& log) {
+  int64_t mtime = 0;
+  uint64_t size = 0;
+  if (!FlagIndex::stampSource(path, mtime, size)) {
+    return false;
+  }
+
+  // The records are copied out of the mapping, which is closed again at
+  // the end of this function so later saves can replace the file
+  FlagIndex mapped;
+  if (!mapped.load(path, log)) {
+    return false;
+  }
+
+  // Queries count their histograms in the scheme of the process, which
+  // can't change while they run, so a file saved in another scheme is
+  // skipped until it is saved again
+  if (mapped.getColorScheme() != ColorQuantizer::getScheme()) {
+    log << "Index file \"" << path << "\" counts colors in "
+        << ColorQuantizer::getSchemeName(mapped.getColorScheme()) << " and the flags in use count them in "
+        << ColorQuantizer::getSchemeName(ColorQuantizer::getScheme()) << "." << std::endl;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    path_ = path;
+    path_mtime_ = mtime;
+    path_size_ = size;
+    return false;
+  }
+  std::shared_ptr<IndexSnapshot> next = std::make_shared<IndexSnapshot>();
+  next->index.copyFrom(mapped);
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  swapIn(next);
+  path_ = path;
+  path_mtime_ = mtime;
+  path_size_ = size;
+  return true;
+}
+
+/**
+ * @brief Remembers an index file for reloadIfChanged without loading it,
+ *        for when the current snapshot was published from the same file
+ *
+ * @param path index file written by FlagIndex::save
+ */
+void FlagCatalog::watchFile(const std::string& path) {
+  int64_t mtime = 0;
+  uint64_t size = 0;
+  FlagIndex::stampSource(path, mtime, size);
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  path_ = path;
+  path_mtime_ = mtime;
+  path_size_ = size;
+}
+
+/**
+ * @brief Loads the file of the last load or watchFile again if it was
+ *        saved since
+ *
+ * @param log stream to print to if the file can't be used
+ * @return true if a new snapshot was published
+ */
+bool FlagCatalog::reloadIfChanged(std::ostream& log) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    if (path_.empty() || !FlagIndex::stampSource(path_, mtime, size) ||
+        (mtime == path_mtime_ && size == path_size_)) {
+      return false;
+    }
+    path = path_;
+  }
+  return load(path, log);
+}
+
+/**
+ * @brief Builds the finder of a snapshot and swaps it in, holding the
+ *        write lock
+ *
+ * @param next snapshot with its index filled
+ */
+void FlagCatalog::swapIn(const std::shared_ptr<IndexSnapshot>& next) {
+  next->finder.reset(new FlagFinder(next->index));
+  if (setup_) {
+    setup_(next->index, *next->finder);
+  }
+
+  // Queries that already acquired the old snapshot keep it alive until
+  // they finish
+  std::shared_ptr<const IndexSnapshot> published = next;
+  std::atomic_store(&current_, published);
+}
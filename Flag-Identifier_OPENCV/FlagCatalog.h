@@ -0,0 +1,134 @@
+/*********************************************************************
+ * @file       FlagCatalog.h
+ * @brief      FlagCatalog publishes snapshots of the flag index and the
+ *              finder built from it, so a changed index file can be
+ *              loaded while queries keep running.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "FlagFinder.h"
+#include "FlagIndex.h"
+
+/**
+ * @brief IndexSnapshot is one version of the flag index and the finder built
+ *        from it. A snapshot is never changed once it is published, so a
+ *        query holding one sees the same flags from start to end and the
+ *        ids in its results stay valid for as long as it is held.
+ */
+struct IndexSnapshot {
+
+  // Flag records, copied into memory so no file stays open
+  FlagIndex index;
+
+  // Finder built from index
+  std::unique_ptr<FlagFinder> finder;
+};
+
+/**
+ * @class FlagCatalog holds the current snapshot. Readers take it with
+ *        acquire and search it without any lock. Each publish or load
+ *        copies the records into a new snapshot, builds its finder and
+ *        swaps it in. The old snapshot is freed when the last query holding
+ *        it lets go, so no reader ever waits on a writer and no reference
+ *        image is decoded again.
+ */
+class FlagCatalog {
+  public:
+
+  // Applies the settings every finder should have, such as metrics or
+  // nearest neighbor search, called with the index and finder of each new
+  // snapshot before publishing
+  typedef std::function<void(const FlagIndex&, FlagFinder&)> FinderSetup;
+
+  /**
+   * @brief Constructor creates a catalog of no flags
+   *
+   * @param setup called on the index and finder of every snapshot, may be
+   *        empty
+   */
+  explicit FlagCatalog(const FinderSetup& setup);
+
+  /**
+   * @brief Getter for the current snapshot
+   *
+   * @return snapshot to search and report results with
+   */
+  std::shared_ptr<const IndexSnapshot> acquire() const;
+
+  /**
+   * @brief Publishes a copy of an index
+   *
+   * @param index records to publish
+   */
+  void publish(const FlagIndex& index);
+
+  /**
+   * @brief Loads an index file and publishes it. The file is remembered so
+   *        reloadIfChanged can pick up later saves.
+   *
+   * @param path index file written by FlagIndex::save
+   * @param log stream to print to if the file can't be used
+   * @return true if the file exists and has the current version and
+   *         the color scheme in use
+   */
+  bool load(const std::string& path, std::ostream& log);
+
+  /**
+   * @brief Remembers an index file for reloadIfChanged without loading it,
+   *        for when the current snapshot was published from the same file
+   *
+   * @param path index file written by FlagIndex::save
+   */
+  void watchFile(const std::string& path);
+
+  /**
+   * @brief Loads the file of the last load or watchFile again if it was
+   *        saved since
+   *
+   * @param log stream to print to if the file can't be used
+   * @return true if a new snapshot was published
+   */
+  bool reloadIfChanged(std::ostream& log);
+
+  private:
+
+  // Copying would share the current snapshot between writers
+  FlagCatalog(const FlagCatalog&);
+  FlagCatalog& operator=(const FlagCatalog&);
+
+  /**
+   * @brief Builds the finder of a snapshot and swaps it in, holding the
+   *        write lock
+   *
+   * @param next snapshot with its index filled
+   */
+  void swapIn(const std::shared_ptr<IndexSnapshot>& next);
+
+  FinderSetup setup_;
+
+  // Current snapshot, swapped with atomic_store under write_mutex_ and
+  // read with atomic_load by readers
+  std::shared_ptr<const IndexSnapshot> current_;
+
+  // Serializes writers, readers never take it
+  std::mutex write_mutex_;
+
+  // Index file of the last load or watchFile and its stamp at that time
+  std::string path_;
+  int64_t path_mtime_;
+  uint64_t path_size_;
+};
@@ -0,0 +1,106 @@
+/*********************************************************************
+ * @file       FlagFeatures.cpp
+ * @brief      FlagFeatures turns a flag into one fixed length feature vector
+ *              so flags can be compared by euclidean distance.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagFeatures.h"
+
+#include <cmath>
+
+#include "CommonColorFinder.h"
+#include "EdgeRatioFinder.h"
+
+// Layout of a feature vector
+static const int kHistogramBins = 8 * 8 * 8;
+static const int kEdgeOffset = kHistogramBins;
+static const int kNumEdgeRegions = 5;
+static const int kColorOffset = kEdgeOffset + kNumEdgeRegions;
+static const int kNumQuadrants = 4;
+static const int kAspectOffset = kColorOffset + kNumQuadrants * 3;
+
+// Weights that keep each part from drowning out the others. The histogram
+// part has length 1, edge ratios are rarely above 0.25 and buckets go up to 7.
+static const float kEdgeWeight = 4.0f;
+static const float kColorWeight = 0.25f / 7.0f;
+static const float kAspectWeight = 0.5f;
+
+const int FlagFeatures::kNumDims = kAspectOffset + 1;
+
+/**
+ * @brief Builds the feature vector of a reference flag from its record
+ *
+ * @param record stored measurements of the flag
+ * @param features kNumDims values to fill
+ */
+void FlagFeatures::fromRecord(const FlagRecord& record, float* features) {
+  setHistogram(record.histogram, features);
+
+  for (int r = 0; r < kNumEdgeRegions; ++r) {
+    features[kEdgeOffset + r] = kEdgeWeight * record.regions[r].edge_ratios[kEdgeScaleWorking];
+  }
+
+  for (int q = 0; q < kNumQuadrants; ++q) {
+    const RegionRecord& quadrant = record.regions[kRegionUpperLeft + q];
+    features[kColorOffset + q * 3] = kColorWeight * quadrant.red_bucket;
+    features[kColorOffset + q * 3 + 1] = kColorWeight * quadrant.green_bucket;
+    features[kColorOffset + q * 3 + 2] = kColorWeight * quadrant.blue_bucket;
+  }
+
+  features[kAspectOffset] = kAspectWeight * std::log((float)record.cols / record.rows);
+}
+
+/**
+ * @brief Builds the feature vector of a test image
+ *
+ * @param image decoded test image
+ * @param histogram histogram of image already counted by the caller,
+ *        read before the arena is used so it can be arena.histogram
+ * @param working_image test image resized to the working size
+ * @param arena buffers owned by the calling thread
+ * @param features kNumDims values to fill
+ */
+void FlagFeatures::fromImage(const Mat& image, const Mat& histogram, const Mat& working_image, FeatureArena& arena,
+                             float* features) {
+  setHistogram(histogram.ptr<int>(), features);
+
+  for (int r = 0; r < kNumEdgeRegions; ++r) {
+    features[kEdgeOffset + r] = kEdgeWeight * EdgeRatioFinder::getEdgeRatio(getRegion(working_image, (FlagRegion)r), arena);
+  }
+
+  for (int q = 0; q < kNumQuadrants; ++q) {
+    Mat region = getRegion(image, (FlagRegion)(kRegionUpperLeft + q));
+    ColorBucket quadrant = CommonColorFinder::getCommonColorBucket(region, arena.histogram);
+    features[kColorOffset + q * 3] = kColorWeight * quadrant.getRedBucket();
+    features[kColorOffset + q * 3 + 1] = kColorWeight * quadrant.getGreenBucket();
+    features[kColorOffset + q * 3 + 2] = kColorWeight * quadrant.getBlueBucket();
+  }
+
+  features[kAspectOffset] = kAspectWeight * std::log((float)image.cols / image.rows);
+}
+
+/**
+ * @brief Fills the histogram part of a feature vector. Square roots of the
+ *        normalized counts make the euclidean distance the Hellinger
+ *        distance, which large uniform areas of one color don't dominate.
+ *
+ * @param histogram 512 bucket counts
+ * @param features kNumDims values to fill
+ */
+void FlagFeatures::setHistogram(const int* histogram, float* features) {
+  double total = 0.0;
+  for (int i = 0; i < kHistogramBins; ++i) {
+    total += histogram[i];
+  }
+  float scale = total > 0.0 ? (float)(1.0 / total) : 0.0f;
+  for (int i = 0; i < kHistogramBins; ++i) {
+    features[i] = std::sqrt(histogram[i] * scale);
+  }
+}
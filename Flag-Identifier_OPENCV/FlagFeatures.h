@@ -0,0 +1,73 @@
+/*********************************************************************
+ * @file       FlagFeatures.h
+ * @brief      FlagFeatures turns a flag into one fixed length feature vector
+ *              so flags can be compared by euclidean distance.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include "FeatureArena.h"
+#include "FlagIndex.h"
+
+using namespace cv;
+
+/**
+ * @class FlagFeatures is a helper class that builds feature vectors from the
+ *        stored record of a reference flag and from a test image. Both are
+ *        built from the same measurements so their distance is meaningful:
+ *          [0, 512): square root of the normalized 8x8x8 color histogram
+ *          [512, 517): edge ratio of the whole image and each quadrant at
+ *                      the working size
+ *          [517, 529): red, green and blue bucket of each quadrant
+ *          [529]: log of the aspect ratio
+ */
+class FlagFeatures {
+  public:
+
+  // Number of values in a feature vector
+  static const int kNumDims;
+
+  /**
+   * @brief Builds the feature vector of a reference flag from its record
+   *
+   * @param record stored measurements of the flag
+   * @param features kNumDims values to fill
+   */
+  static void fromRecord(const FlagRecord& record, float* features);
+
+  /**
+   * @brief Builds the feature vector of a test image
+   *
+   * @param image decoded test image
+   * @param histogram histogram of image already counted by the caller,
+   *        read before the arena is used so it can be arena.histogram
+   * @param working_image test image resized to the working size
+   * @param arena buffers owned by the calling thread
+   * @param features kNumDims values to fill
+   */
+  static void fromImage(const Mat& image, const Mat& histogram, const Mat& working_image, FeatureArena& arena, float* features);
+
+  private:
+
+  /**
+   * @brief Constructor is private, FlagFeatures only has static methods
+   */
+  FlagFeatures();
+
+  /**
+   * @brief Fills the histogram part of a feature vector
+   *
+   * @param histogram 512 bucket counts
+   * @param features kNumDims values to fill
+   */
+  static void setHistogram(const int* histogram, float* features);
+};
@@ -0,0 +1,795 @@
+/*********************************************************************
+ * @file       FlagFinder.cpp
+ * @brief      FlagFinder runs the sequential filters that narrow the
+ *              reference flags down to the flag in a test image.
+ *
+ * @author Joseph Lan
+ * @author Andy Tran
+ * @author Kevin Xu
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagFinder.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include "CommonColorFinder.h"
+#include "EdgeRatioFinder.h"
+#include "FlagFeatures.h"
+#include "FlagMetrics.h"
+#include "ImageDecoder.h"
+
+const float FlagFinder::kAcceptableError = 0.006f;
+
+/**
+ * @brief Constructor marks every step as not run
+ */
+FlagResult::FlagResult() {
+  reset();
+}
+
+/**
+ * @brief Marks every step as not run and empties the lists, keeping their
+ *        memory so a result can be reused for the next image
+ */
+void FlagResult::reset() {
+  flags.clear();
+  decoded = false;
+  deciding_stage = kStageDecode;
+  for (int i = 0; i < kNumStages; ++i) {
+    stage_ms[i] = -1.0;
+    candidates_in[i] = -1;
+    candidates_out[i] = -1;
+    stage_flags[i].clear();
+  }
+  image_bucket = ColorBucket();
+  quadrant_bucket = ColorBucket();
+  num_dominant_colors = 0;
+  color_matches = 0;
+  edge_ratio = -1.0f;
+  quadrant_edge_ratio = -1.0f;
+  filter_order.clear();
+  color_shares.clear();
+  neighbors.clear();
+  confidences.clear();
+}
+
+/**
+ * @brief Returns the memory the buffers hold, which is what one thread
+ *        keeps between images
+ *
+ * @return bytes allocated, counting the capacity of every buffer
+ */
+size_t FlagScratch::getMemoryBytes() const {
+  size_t bytes = encoded.capacity() + test_file.total() * test_file.elemSize() +
+    working_file.total() * working_file.elemSize();
+  bytes += candidates.getMemoryBytes() + region_candidates.getMemoryBytes();
+  bytes += (color_matches.capacity() + first_colors.capacity()) * sizeof(int) +
+    (distances.capacity() + features.capacity()) * sizeof(float);
+  bytes += arena.histogram.total() * arena.histogram.elemSize() + arena.gray_row.capacity() +
+    arena.smoothed_rows.capacity() * sizeof(uint16_t) + arena.blurred_rows.capacity() +
+    (arena.dx_rows.capacity() + arena.dy_rows.capacity()) * sizeof(int16_t) +
+    arena.magnitude_rows.capacity() * sizeof(int) +
+    (arena.strong_edges.capacity() + arena.weak_edges.capacity()) * sizeof(uint64_t) +
+    arena.edge_stack.capacity() * sizeof(int);
+  return bytes;
+}
+
+/**
+ * @brief Constructor builds the bucket index of every region and the
+ *        dominant color index for every flag in the index
+ *
+ * @param index flag metadata to search
+ */
+FlagFinder::FlagFinder(const FlagIndex& index) : index_(index), nearest_k_(0), rank_k_(0), metrics_(nullptr),
+                                                    trace_(false), reduced_decode_(true) {
+  CandidateSet all_flags;
+  all_flags.reset(index_.getSize());
+  for (int id = 0; id < index_.getSize(); ++id) {
+    all_flags.insert(id);
+  }
+  for (int r = 0; r < kNumRegions; ++r) {
+    buildBucketIndex(all_flags, bucket_indexes_[r], (FlagRegion)r);
+  }
+
+  // Every flag is posted once for each of its dominant colors
+  std::vector<int> ids;
+  std::vector<ColorBucket> buckets;
+  for (int id = 0; id < index_.getSize(); ++id) {
+    const FlagRecord& record = index_.getRecord(id);
+    ColorBucket colors[kMaxDominantColors];
+    int num_colors = CommonColorFinder::findDominantBuckets(index_.getHistogram(id), record.rows * record.cols, colors);
+    for (int i = 0; i < num_colors; ++i) {
+      ids.push_back(id);
+      buckets.push_back(colors[i]);
+    }
+  }
+  dominant_index_.build(ids, buckets);
+}
+
+/**
+ * @brief Setter for keeping the flags remaining after every step in
+ *        FlagResult::stage_flags
+ *
+ * @param trace true to fill stage_flags
+ */
+void FlagFinder::setTrace(bool trace) {
+  trace_ = trace;
+}
+
+/**
+ * @brief Setter for the metrics every search is recorded in
+ *
+ * @param metrics counters shared by every thread, null to record nothing
+ */
+void FlagFinder::setMetrics(FlagMetrics* metrics) {
+  metrics_ = metrics;
+}
+
+/**
+ * @brief Setter for answering with the k flags closest to the test image
+ *        by feature distance instead of running the bucket filters. The
+ *        feature vectors and tree are built the first time k is set.
+ *
+ * @param k number of flags to return, 0 to run the bucket filters
+ */
+void FlagFinder::setNearestNeighbors(int k) {
+  nearest_k_ = k > 0 ? k : 0;
+  if (nearest_k_ == 0 || feature_tree_.getSize() == index_.getSize()) {
+    return;
+  }
+
+  // One feature vector per flag, row i is flag i
+  int count = index_.getSize();
+  std::vector<float> features((size_t)count * FlagFeatures::kNumDims);
+  for (int id = 0; id < count; ++id) {
+    FlagFeatures::fromRecord(index_.getRecord(id), &features[(size_t)id * FlagFeatures::kNumDims]);
+  }
+  feature_tree_.build(features.data(), count, FlagFeatures::kNumDims);
+}
+
+/**
+ * @brief Setter for answering with up to k flags ranked by their combined
+ *        distance to the test image, each with a confidence, instead of
+ *        running the bucket filters. No flag is returned when even the
+ *        closest is past FlagScorer::kRejectDistance. The scorer is built
+ *        the first time k is set, and the nearest neighbor search wins if
+ *        both are set.
+ *
+ * @param k number of flags to return, 0 to run the bucket filters
+ */
+void FlagFinder::setRanking(int k) {
+  rank_k_ = k > 0 ? k : 0;
+  if (rank_k_ > 0 && scorer_.getSize() != index_.getSize()) {
+    scorer_.build(index_);
+  }
+}
+
+/**
+ * @brief Setter for decoding jpg test images straight to a reduced size
+ *        near the working size, see ImageDecoder. On by default.
+ *
+ * @param reduced false to always decode at full size
+ */
+void FlagFinder::setReducedDecode(bool reduced) {
+  reduced_decode_ = reduced;
+}
+
+/**
+ * @brief Setter for the order of the filters after the MCC filter, see
+ *        CascadePlan. The fixed order is used until one is set.
+ *
+ * @param plan order of the filters, copied
+ */
+void FlagFinder::setPlan(const CascadePlan& plan) {
+  plan_ = plan;
+}
+
+/**
+ * @brief Adds the memory of the indexes built from the flag metadata to a
+ *        report, one line per index. The metadata itself is reported by
+ *        FlagIndex::getMemoryUsage.
+ *
+ * @param usage report to add to
+ */
+void FlagFinder::getMemoryUsage(std::vector<MemoryUsage>& usage) const {
+  size_t region_bytes = 0;
+  for (int r = 0; r < kNumRegions; ++r) {
+    region_bytes += bucket_indexes_[r].getMemoryBytes();
+  }
+  usage.push_back({ "region bucket indexes", region_bytes });
+  usage.push_back({ "dominant color index", dominant_index_.getMemoryBytes() });
+  usage.push_back({ "nearest neighbor tree", feature_tree_.getMemoryBytes() });
+  usage.push_back({ "ranking features", scorer_.getMemoryBytes() });
+}
+
+/**
+ * @brief Runs the MCC filter on a decoded image, then each filter a plan
+ *        can order alone on its own copy of the flags the MCC filter left,
+ *        and records which flags each one kept and how long it took
+ *
+ * @param test_file decoded input image, not empty
+ * @param sample sample to fill, except for which flags are correct
+ * @param scratch buffers owned by the calling thread
+ */
+void FlagFinder::sampleFilters(const Mat& test_file, CascadeSample& sample, FlagScratch& scratch) const {
+  FlagResult result;
+  measureColors(test_file, result, scratch, false);
+  result.color_matches = findDominantFlags(result.dominant_colors, result.num_dominant_colors, scratch);
+  scratch.candidates.getIds(sample.flags);
+
+  // Resized once up front so no filter is charged for it
+  {
+    StageTimer timer(result, kStageResize);
+    EdgeRatioFinder::resizeToWorkingSize(test_file, scratch.working_file);
+  }
+  sample.resize_ms = result.stage_ms[kStageResize];
+
+  const CandidateSet mcc_flags = scratch.candidates;
+  for (int i = 0; i < kNumPlannedStages; ++i) {
+    scratch.candidates = mcc_flags;
+    runFilter(kPlannedStages[i], test_file, result, scratch);
+    sample.stage_ms[i] = result.stage_ms[kPlannedStages[i]];
+    sample.passed[i].resize(sample.flags.size());
+    for (size_t j = 0; j < sample.flags.size(); ++j) {
+      sample.passed[i][j] = scratch.candidates.contains(sample.flags[j]) ? 1 : 0;
+    }
+  }
+}
+
+/**
+ * @brief Reads an image file and finds the flag in it
+ *
+ * @param filename name of the input image
+ * @return result with the ids of the determined possible flags
+ */
+FlagResult FlagFinder::findFlag(const std::string& filename) const {
+  FlagResult result;
+  FlagScratch scratch;
+  findFlag(filename, result, scratch);
+  return result;
+}
+
+/**
+ * @brief Reads an image file and finds the flag in it using the given
+ *        buffers. Safe to call from several threads with separate scratch.
+ *
+ * @param filename name of the input image
+ * @param result result to fill with the ids of the determined possible
+ *        flags, reset first so it can be reused between images
+ * @param scratch buffers owned by the calling thread
+ */
+void FlagFinder::findFlag(const std::string& filename, FlagResult& result, FlagScratch& scratch) const {
+  result.reset();
+  {
+    StageTimer timer(result, kStageDecode);
+    ImageDecoder::readFile(filename, scratch.encoded);
+    ImageDecoder::decode(scratch.encoded, reduced_decode_, scratch.test_file);
+  }
+
+  // Unreadable images have no flags
+  if (scratch.test_file.empty()) {
+    recordMetrics(result);
+    return;
+  }
+
+  findDecoded(scratch.test_file, result, scratch);
+}
+
+/**
+ * @brief Decodes an encoded image and finds the flag in it using the given
+ *        buffers. Safe to call from several threads with separate scratch.
+ *
+ * @param encoded bytes of an image file, such as a jpg or png
+ * @param result result to fill with the ids of the determined possible
+ *        flags, reset first so it can be reused between images
+ * @param scratch buffers owned by the calling thread
+ */
+void FlagFinder::findFlag(const std::vector<uchar>& encoded, FlagResult& result, FlagScratch& scratch) const {
+  result.reset();
+  {
+    StageTimer timer(result, kStageDecode);
+    ImageDecoder::decode(encoded, reduced_decode_, scratch.test_file);
+  }
+
+  // Unreadable images have no flags
+  if (scratch.test_file.empty()) {
+    recordMetrics(result);
+    return;
+  }
+
+  findDecoded(scratch.test_file, result, scratch);
+}
+
+/**
+ * @brief Find flags goes through sequential algorithm steps to find a flag
+ *        given a mapping of existing flags
+ *          [1]: Calculates color information for test flag
+ *          [2]: Narrows down possible flags based on dominant colors
+ *          [3]: Narrows down possible flags based on MCC ratios
+ *          [4]: Calculates edge information for test flags and possible flags
+ *          [5]: Narrows down possible flags based on edge information
+ *          [6]: Calculates quadrant test flag and possible flag information
+ *          [7]: Narrowd down possible flags using quadrant information
+ *
+ * @param test_file decoded input image, not changed
+ * @param result result to fill with the ids of the determined possible flags
+ */
+void FlagFinder::findFlag(const Mat& test_file, FlagResult& result) const {
+  FlagScratch scratch;
+  findFlag(test_file, result, scratch);
+}
+
+/**
+ * @brief Finds the flag in a decoded image using the given buffers. Safe to
+ *        call from several threads with separate scratch.
+ *
+ * @param test_file decoded input image, not changed
+ * @param result result to fill with the ids of the determined possible
+ *        flags, reset first so it can be reused between images
+ * @param scratch buffers owned by the calling thread
+ */
+void FlagFinder::findFlag(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const {
+  result.reset();
+  findDecoded(test_file, result, scratch);
+}
+
+/**
+ * @brief Finds the flag in a decoded image, adding to a result that may
+ *        already hold the decode time
+ *
+ * @param test_file decoded input image, not changed
+ * @param result result to fill with the ids of the determined possible flags
+ * @param scratch buffers owned by the calling thread
+ */
+void FlagFinder::findDecoded(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const {
+
+  // Unreadable images have no flags
+  if (!test_file.empty()) {
+    result.decoded = true;
+    runFilters(test_file, result, scratch, false);
+  }
+  recordMetrics(result);
+}
+
+/**
+ * @brief Finds the flag in a decoded image whose color histogram was
+ *        already counted, such as a video frame checked for a scene
+ *        change. Safe to call from several threads with separate scratch.
+ *
+ * @param test_file decoded input image, not empty
+ * @param result result to fill with the ids of the determined possible
+ *        flags, already reset and holding the decode and color bucket time
+ * @param scratch buffers owned by the calling thread, arena.histogram
+ *        holding the histogram of test_file
+ */
+void FlagFinder::findCounted(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const {
+  result.decoded = true;
+  runFilters(test_file, result, scratch, true);
+  recordMetrics(result);
+}
+
+/**
+ * @brief Runs the filters of findFlag on a decoded image
+ *
+ * @param test_file decoded input image, not empty
+ * @param result result to fill with the ids of the determined possible flags
+ * @param scratch buffers owned by the calling thread
+ * @param counted true if arena.histogram already holds the histogram of
+ *        test_file
+ */
+void FlagFinder::runFilters(const Mat& test_file, FlagResult& result, FlagScratch& scratch, bool counted) const {
+
+  // Dominant colors for the input image (image we're looking for), the
+  // most common one is its ColorBucket
+  measureColors(test_file, result, scratch, counted);
+
+  // Nearest neighbor search or ranking replaces every filter
+  if (nearest_k_ > 0) {
+    searchNearest(test_file, result, scratch);
+    return;
+  }
+  if (rank_k_ > 0) {
+    rankFlags(test_file, result, scratch);
+    return;
+  }
+
+  // Step 1: findDominantFlags to narrow down colorBuckets
+  result.deciding_stage = kStageMcc;
+  CandidateSet& possible_flags = scratch.candidates;
+  {
+    StageTimer timer(result, kStageMcc);
+    result.color_matches = findDominantFlags(result.dominant_colors, result.num_dominant_colors, scratch);
+  }
+  result.candidates_in[kStageMcc] = index_.getSize();
+  result.candidates_out[kStageMcc] = possible_flags.size();
+  traceStage(possible_flags, kStageMcc, result);
+
+  // Steps 2 to 4: MCC ratio, Canny and upper left quadrant filters in the
+  // order of the plan, with an early exit once one flag or none is left
+  for (FlagStage stage : plan_.getStages()) {
+    if (possible_flags.size() <= 1) {
+      break;
+    }
+    result.deciding_stage = stage;
+    result.candidates_in[stage] = possible_flags.size();
+    runFilter(stage, test_file, result, scratch);
+    result.candidates_out[stage] = possible_flags.size();
+    traceStage(possible_flags, stage, result);
+  }
+
+  possible_flags.getIds(result.flags);
+}
+
+/**
+ * @brief Measures the color histogram and dominant colors of a test image
+ *
+ * @param test_file decoded input image, not empty
+ * @param result result to fill with the image bucket and dominant colors
+ * @param scratch buffers owned by the calling thread, arena.histogram is
+ *        set to the histogram of test_file
+ * @param counted true if arena.histogram already holds it
+ */
+void FlagFinder::measureColors(const Mat& test_file, FlagResult& result, FlagScratch& scratch, bool counted) const {
+
+  // A histogram counted by the caller is timed by the caller too
+  double counted_ms = counted ? std::max(result.stage_ms[kStageColorBucket], 0.0) : 0.0;
+  {
+    StageTimer timer(result, kStageColorBucket);
+    if (!counted) {
+      CommonColorFinder::populateHistogram(test_file, scratch.arena.histogram);
+    }
+    result.num_dominant_colors = CommonColorFinder::findDominantBuckets(scratch.arena.histogram,
+                                                                        test_file.rows * test_file.cols,
+                                                                        result.dominant_colors);
+    result.image_bucket = result.dominant_colors[0];
+  }
+  result.stage_ms[kStageColorBucket] += counted_ms;
+}
+
+/**
+ * @brief Runs one of the filters a plan can order on scratch.candidates,
+ *        resizing the test image first if the filter needs it and it
+ *        wasn't resized yet
+ *
+ * @param stage filter to run, one of kPlannedStages
+ * @param test_file decoded input image, not empty
+ * @param result result to fill with the time and ratios of the filter
+ * @param scratch buffers owned by the calling thread
+ */
+void FlagFinder::runFilter(FlagStage stage, const Mat& test_file, FlagResult& result, FlagScratch& scratch) const {
+  CandidateSet& possible_flags = scratch.candidates;
+
+  // Resize for img dims, once for both edge filters
+  if (stage != kStageMccRatio && result.stage_ms[kStageResize] < 0.0) {
+    StageTimer timer(result, kStageResize);
+    EdgeRatioFinder::resizeToWorkingSize(test_file, scratch.working_file);
+  }
+  const Mat& working_file = scratch.working_file;
+
+  StageTimer timer(result, stage);
+  if (stage == kStageMccRatio) {
+
+    // Compare how much of each flag and of the image the color they
+    // share covers
+    filterColorShares(possible_flags, result, scratch);
+  } else if (stage == kStageCanny) {
+
+    // Filter by canny edge ratio to get closer to flag, compared with the
+    // ratios stored for every flag when indexed
+    result.edge_ratio = EdgeRatioFinder::getEdgeRatio(working_file, scratch.arena);
+    filterRatios(possible_flags, index_.getEdgeRatios(kRegionWhole, kEdgeScaleNative), result.edge_ratio);
+  } else if (stage == kStageQuadrant) {
+
+    // Repeat the filters with the upper-left quadrant of the image
+    Mat ul_quadrant = getRegion(working_file, kRegionUpperLeft);
+
+    // Upper left color bucket
+    result.quadrant_bucket = CommonColorFinder::getCommonColorBucket(ul_quadrant, scratch.arena.histogram);
+
+    // Filtered search through upper left quadrant, looked up in the stored
+    // upper left buckets and kept only for the flags still remaining
+    CandidateSet& ul_flags = scratch.region_candidates;
+    findClosestFlag(bucket_indexes_[kRegionUpperLeft], result.quadrant_bucket, ul_flags);
+    possible_flags.intersect(ul_flags);
+
+    // Filter out the flags based on the correct color ratio, unless the
+    // possibility was already found
+    if (possible_flags.size() > 1) {
+      filterRatios(possible_flags, index_.getCommonColorRatios(kRegionUpperLeft),
+                   result.quadrant_bucket.getCommonColorRatio());
+    }
+
+    // Filter out possible flags based on the canny edge algorithm
+    if (possible_flags.size() > 1) {
+      result.quadrant_edge_ratio = EdgeRatioFinder::getEdgeRatio(ul_quadrant, scratch.arena);
+      filterRatios(possible_flags, index_.getEdgeRatios(kRegionUpperLeft, kEdgeScaleNative),
+                   result.quadrant_edge_ratio);
+    }
+  }
+}
+
+/**
+ * @brief Finds the flags closest to a test image by feature distance
+ *
+ * @param test_file decoded input image, not empty
+ * @param result result to fill with the ids of the closest flags
+ * @param scratch buffers owned by the calling thread, arena.histogram
+ *        holding the histogram of test_file
+ */
+void FlagFinder::searchNearest(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const {
+  {
+    StageTimer timer(result, kStageResize);
+    EdgeRatioFinder::resizeToWorkingSize(test_file, scratch.working_file);
+  }
+
+  result.deciding_stage = kStageNearest;
+  result.candidates_in[kStageNearest] = index_.getSize();
+  {
+    StageTimer timer(result, kStageNearest);
+    scratch.features.resize(FlagFeatures::kNumDims);
+    FlagFeatures::fromImage(test_file, scratch.arena.histogram, scratch.working_file, scratch.arena,
+                            scratch.features.data());
+    feature_tree_.search(scratch.features.data(), nearest_k_, result.neighbors);
+  }
+
+  // Flags are listed closest first, unlike the filters
+  result.flags.clear();
+  for (const Neighbor& neighbor : result.neighbors) {
+    result.flags.push_back(neighbor.id);
+  }
+  result.candidates_out[kStageNearest] = (int)result.flags.size();
+  result.filter_order.push_back(kStageNearest);
+  if (trace_) {
+    result.stage_flags[kStageNearest] = result.flags;
+  }
+}
+
+/**
+ * @brief Ranks the flags by combined distance to a test image, stopping
+ *        after a stage once the closest flag leads by
+ *        FlagScorer::kExitMargin
+ *
+ * @param test_file decoded input image, not empty
+ * @param result result to fill with the ids of the closest flags and
+ *        their confidences, image_bucket already set
+ * @param scratch buffers owned by the calling thread, arena.histogram
+ *        holding the histogram of test_file
+ */
+void FlagFinder::rankFlags(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const {
+  CandidateSet& candidates = scratch.candidates;
+  std::vector<float>& distances = scratch.distances;
+
+  // Color histogram and aspect ratio, both already measured
+  result.deciding_stage = kStageScoreColor;
+  result.candidates_in[kStageScoreColor] = index_.getSize();
+  {
+    StageTimer timer(result, kStageScoreColor);
+    scorer_.scoreColor(scratch.arena.histogram, (float)test_file.cols / test_file.rows, scratch.features,
+                       candidates, distances);
+  }
+  result.candidates_out[kStageScoreColor] = candidates.size();
+  traceStage(candidates, kStageScoreColor, result);
+
+  // Color bucket of each quadrant and grid cell
+  if (!scorer_.isDecided(candidates, distances)) {
+    result.deciding_stage = kStageScoreLayout;
+    result.candidates_in[kStageScoreLayout] = candidates.size();
+    {
+      StageTimer timer(result, kStageScoreLayout);
+      ColorBucket buckets[kNumRegions];
+      for (int r = kRegionWhole + 1; r < kNumRegions; ++r) {
+        buckets[r] = CommonColorFinder::getCommonColorBucket(getRegion(test_file, (FlagRegion)r),
+                                                             scratch.arena.histogram);
+      }
+      result.quadrant_bucket = buckets[kRegionUpperLeft];
+      scorer_.scoreLayout(buckets, candidates, distances);
+    }
+    result.candidates_out[kStageScoreLayout] = candidates.size();
+    traceStage(candidates, kStageScoreLayout, result);
+  }
+
+  // Edge ratios, the only stage that needs the resized image
+  if (!scorer_.isDecided(candidates, distances)) {
+    {
+      StageTimer timer(result, kStageResize);
+      EdgeRatioFinder::resizeToWorkingSize(test_file, scratch.working_file);
+    }
+    result.deciding_stage = kStageScoreEdges;
+    result.candidates_in[kStageScoreEdges] = candidates.size();
+    {
+      StageTimer timer(result, kStageScoreEdges);
+      float edge_ratios[kNumScoredEdgeRegions];
+      for (int r = 0; r < kNumScoredEdgeRegions; ++r) {
+        edge_ratios[r] = EdgeRatioFinder::getEdgeRatio(getRegion(scratch.working_file, (FlagRegion)r), scratch.arena);
+      }
+      result.edge_ratio = edge_ratios[kRegionWhole];
+      result.quadrant_edge_ratio = edge_ratios[kRegionUpperLeft];
+      scorer_.scoreEdges(edge_ratios, candidates, distances);
+    }
+    result.candidates_out[kStageScoreEdges] = candidates.size();
+    traceStage(candidates, kStageScoreEdges, result);
+  }
+
+  // Flags are listed closest first, like the nearest neighbor search
+  scorer_.rank(candidates, distances, rank_k_, result.neighbors, result.confidences);
+  result.flags.clear();
+  for (const Neighbor& neighbor : result.neighbors) {
+    result.flags.push_back(neighbor.id);
+  }
+}
+
+/**
+ * @brief Finds the flags sharing the most dominant colors with a test
+ *        image. Each color of the test image matches the flags posted
+ *        under its bucket or an adjacent bucket, and only the flags
+ *        matching the most colors are kept.
+ *
+ * @param colors dominant colors of the test image
+ * @param num_colors number of colors
+ * @param scratch buffers owned by the calling thread, candidates is set to
+ *        the flags found
+ * @return number of colors the flags found share, 0 if none matched
+ */
+int FlagFinder::findDominantFlags(const ColorBucket* colors, int num_colors, FlagScratch& scratch) const {
+  CandidateSet& candidates = scratch.candidates;
+  CandidateSet& color_flags = scratch.region_candidates;
+  std::vector<int>& matches = scratch.color_matches;
+  candidates.reset(index_.getSize());
+  matches.assign(index_.getSize(), 0);
+  scratch.first_colors.resize(index_.getSize());
+
+  // Count the colors each flag matches. A flag posted under two buckets
+  // near the same color only counts it once.
+  int best_matches = 0;
+  for (int i = 0; i < num_colors; ++i) {
+    color_flags.reset(index_.getSize());
+    dominant_index_.findNeighbors(colors[i], color_flags);
+    for (int id = color_flags.first(); id >= 0; id = color_flags.next(id)) {
+      if (matches[id] == 0) {
+        scratch.first_colors[id] = i;
+      }
+      best_matches = std::max(best_matches, ++matches[id]);
+      candidates.insert(id);
+    }
+  }
+
+  // Keep the flags matching the most colors
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    if (matches[id] < best_matches) {
+      candidates.erase(id);
+    }
+  }
+  return best_matches;
+}
+
+/**
+ * @brief   findClosestFlag method will analyze an input image and determine
+ *            similar looking flags based on the most common color present.
+ *
+ * @param   bucket_index holds the flag ids in their appropriate bucket
+ *            based on the most common color present.
+ * @param   image_bucket is the color bucket for the input image.
+ * @param   candidates is set to the similar looking flags, cleared first.
+ */
+void FlagFinder::findClosestFlag(const BucketIndex& bucket_index, const ColorBucket& image_bucket, CandidateSet& candidates) const {
+
+  //Look for flags in adjacent buckets as the input image
+  candidates.reset(index_.getSize());
+  bucket_index.findNeighbors(image_bucket, candidates);
+}
+
+/**
+ * @brief filterRatios gets closer to the target flag by removing flags
+ *        whose stored ratio isn't within kAcceptableError of the ratio
+ *        measured on the test image
+ *
+ * @pre   ratios holds every flag in the index
+ * @post  candidates is updated after applying filter
+ *
+ * @param candidates is the set of possible flags remaining
+ * @param ratios is the stored ratio of every index flag by id, either the
+ *        common color ratio or the canny edge ratio of a region
+ * @param test_ratio is the same ratio measured on the test image
+ */
+void FlagFinder::filterRatios(CandidateSet& candidates, const float* ratios, float test_ratio) const {
+  if (candidates.size() <= 1) {
+    return;
+  }
+
+  // Check if ratio is within acceptable range
+  float min_ratio = test_ratio - kAcceptableError;
+  float max_ratio = test_ratio + kAcceptableError;
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    if (ratios[id] < min_ratio || ratios[id] > max_ratio) {
+      candidates.erase(id);
+    }
+  }
+}
+
+/**
+ * @brief Removes the flags whose share of the dominant color they matched
+ *        isn't within kAcceptableError of that color's share of the test
+ *        image. The share of a flag is its largest stored bucket in the
+ *        cell or an adjacent cell of the color, the bucket it was posted
+ *        under in the dominant color index.
+ *
+ * @param candidates flags remaining after findDominantFlags
+ * @param result result with the dominant colors of the test image
+ * @param scratch buffers owned by the calling thread, first_colors set by
+ *        findDominantFlags
+ */
+void FlagFinder::filterColorShares(CandidateSet& candidates, FlagResult& result, const FlagScratch& scratch) const {
+  if (candidates.size() <= 1) {
+    return;
+  }
+
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    const ColorBucket& color = result.dominant_colors[scratch.first_colors[id]];
+    const FlagRecord& record = index_.getRecord(id);
+    int cells[BucketIndex::kMaxNeighbors];
+    int num_cells = BucketIndex::getNeighborCells(color, cells);
+    int count = 0;
+    for (int i = 0; i < num_cells; ++i) {
+      count = std::max(count, (int)record.histogram[cells[i]]);
+    }
+    int pixels = record.rows * record.cols;
+    float flag_share = pixels > 0 ? (float)count / float(pixels) : 0.0f;
+    float image_share = color.getCommonColorRatio();
+    if (trace_) {
+      result.color_shares.push_back({ id, image_share, flag_share });
+    }
+    if (std::abs(flag_share - image_share) > kAcceptableError) {
+      candidates.erase(id);
+    }
+  }
+}
+
+/**
+ * @brief Builds a bucket index of flags by the color bucket of a region
+ *
+ * @param candidates flags to add
+ * @param bucket_index index to build
+ * @param region region of the flags to use color buckets of
+ */
+void FlagFinder::buildBucketIndex(const CandidateSet& candidates, BucketIndex& bucket_index, FlagRegion region) const {
+  std::vector<int> ids;
+  std::vector<ColorBucket> buckets;
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    ids.push_back(id);
+    buckets.push_back(index_.getColorBucket(id, region));
+  }
+  bucket_index.build(ids, buckets);
+}
+
+/**
+ * @brief Notes that a step ran and keeps the flags remaining after it when
+ *        tracing
+ *
+ * @param candidates flags remaining
+ * @param stage step that just ran
+ * @param result result to keep them in
+ */
+void FlagFinder::traceStage(const CandidateSet& candidates, FlagStage stage, FlagResult& result) const {
+  result.filter_order.push_back(stage);
+  if (trace_) {
+    candidates.getIds(result.stage_flags[stage]);
+  }
+}
+
+/**
+ * @brief Adds a finished search to the metrics, if any are set
+ *
+ * @param result result of the search
+ */
+void FlagFinder::recordMetrics(const FlagResult& result) const {
+  if (metrics_ != nullptr) {
+    metrics_->record(result);
+  }
+}
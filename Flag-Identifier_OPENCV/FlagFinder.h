@@ -0,0 +1,501 @@
+/*********************************************************************
+ * @file       FlagFinder.h
+ * @brief      FlagFinder runs the sequential filters that narrow the
+ *              reference flags down to the flag in a test image.
+ *
+ * @author Joseph Lan
+ * @author Andy Tran
+ * @author Kevin Xu
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+#include "BucketIndex.h"
+#include "CandidateSet.h"
+#include "CascadePlan.h"
+#include "ColorBucket.h"
+#include "FeatureArena.h"
+#include "FlagIndex.h"
+#include "FlagRegion.h"
+#include "FlagScorer.h"
+#include "FlagStage.h"
+#include "MemoryUsage.h"
+#include "VpTree.h"
+
+using namespace cv;
+
+class FlagMetrics;
+
+/**
+ * @brief ColorShare is how much of one flag and of the test image the
+ *        dominant color they share covers, as compared by the MCC ratio
+ *        filter
+ */
+struct ColorShare {
+  int flag;
+  float image_share;
+  float flag_share;
+};
+
+/**
+ * @brief FlagResult is what findFlag found for one test image
+ */
+struct FlagResult {
+
+  // Ids of the flags remaining after the last step that ran, in increasing
+  // order, or closest first after a nearest neighbor search. Names are looked up with FlagIndex::getName when reported.
+  std::vector<int> flags;
+
+  // False if the test image could not be read
+  bool decoded;
+
+  // Step that decided the result (the last step that ran)
+  FlagStage deciding_stage;
+
+  // Milliseconds spent in each step, negative if the step didn't run
+  double stage_ms[kNumStages];
+
+  // Flags before and after each filter, negative for steps that aren't
+  // filters or didn't run
+  int candidates_in[kNumStages];
+  int candidates_out[kNumStages];
+
+  // Color bucket of the whole test image and of its upper left quadrant
+  ColorBucket image_bucket;
+  ColorBucket quadrant_bucket;
+
+  // Dominant colors of the whole test image, most common first, and how
+  // many of them the flags remaining after the MCC filter share
+  ColorBucket dominant_colors[kMaxDominantColors];
+  int num_dominant_colors;
+  int color_matches;
+
+  // Canny edge ratio of the whole test image and of its upper left
+  // quadrant, negative if the edge filters didn't need it
+  float edge_ratio;
+  float quadrant_edge_ratio;
+
+  // Filters that ran, in the order they ran, which a cascade plan can
+  // change
+  std::vector<FlagStage> filter_order;
+
+  // Flags remaining after each step that ran, only filled when the finder
+  // traces. Sinks use them to report how each filter narrowed the flags.
+  std::vector<int> stage_flags[kNumStages];
+
+  // Shares of the matched color of each flag the MCC ratio filter checked,
+  // only filled when the finder traces
+  std::vector<ColorShare> color_shares;
+
+  // Closest flags by feature distance, closest first, only filled by the
+  // nearest neighbor search and by ranking
+  std::vector<Neighbor> neighbors;
+
+  // Chance that each flag in flags is the one in the test image, only
+  // filled by ranking
+  std::vector<float> confidences;
+
+  FlagResult();
+
+  /**
+   * @brief Marks every step as not run and empties the lists, keeping their
+   *        memory so a result can be reused for the next image
+   */
+  void reset();
+};
+
+/**
+ * @brief FlagScratch holds the buffers findFlag works in. Each thread keeps
+ *        its own so buffers are reused between images instead of allocated.
+ */
+struct FlagScratch {
+
+  // Bytes of the test image file
+  std::vector<uchar> encoded;
+
+  // Decoded test image
+  Mat test_file;
+
+  // Test image resized to the working size of the edge filters
+  Mat working_file;
+
+  // Flags still possible while the filters run
+  CandidateSet candidates;
+
+  // Flags near the color bucket of one region of the test image
+  CandidateSet region_candidates;
+
+  // Number of dominant colors of the test image each flag shares, by id
+  std::vector<int> color_matches;
+
+  // Most common dominant color of the test image each flag shares, by id,
+  // only set for flags sharing one
+  std::vector<int> first_colors;
+
+  // Distance of every flag while ranking, by id
+  std::vector<float> distances;
+
+  // Feature vector of the test image for the nearest neighbor search, or
+  // its normalized histogram while ranking
+  std::vector<float> features;
+
+  // Buffers the color and edge features are measured in
+  FeatureArena arena;
+
+  /**
+   * @brief Returns the memory the buffers hold, which is what one thread
+   *        keeps between images
+   *
+   * @return bytes allocated, counting the capacity of every buffer
+   */
+  size_t getMemoryBytes() const;
+};
+
+/**
+ * @class FlagFinder holds the bucket indexes built from a FlagIndex and runs the
+ *        filters of findFlag against them. The index must outlive the finder.
+ *        findFlag never prints or opens windows; everything it found is in
+ *        the FlagResult, which a ResultSink reports.
+ */
+class FlagFinder {
+  public:
+
+  // Largest difference between a test ratio and a flag ratio that passes
+  // the ratio and edge filters
+  static const float kAcceptableError;
+
+  /**
+   * @brief Constructor builds the bucket index of every region for every
+   *        flag in the index
+   *
+   * @param index flag metadata to search
+   */
+  explicit FlagFinder(const FlagIndex& index);
+
+  /**
+   * @brief Setter for keeping the flags remaining after every step in
+   *        FlagResult::stage_flags
+   *
+   * @param trace true to fill stage_flags
+   */
+  void setTrace(bool trace);
+
+  /**
+   * @brief Setter for the metrics every search is recorded in
+   *
+   * @param metrics counters shared by every thread, null to record nothing
+   */
+  void setMetrics(FlagMetrics* metrics);
+
+  /**
+   * @brief Setter for answering with the k flags closest to the test image
+   *        by feature distance instead of running the bucket filters. The
+   *        feature vectors and tree are built the first time k is set.
+   *
+   * @param k number of flags to return, 0 to run the bucket filters
+   */
+  void setNearestNeighbors(int k);
+
+  /**
+   * @brief Setter for answering with up to k flags ranked by their combined
+   *        distance to the test image, each with a confidence, instead of
+   *        running the bucket filters. No flag is returned when even the
+   *        closest is past FlagScorer::kRejectDistance. The scorer is built
+   *        the first time k is set, and the nearest neighbor search wins if
+   *        both are set.
+   *
+   * @param k number of flags to return, 0 to run the bucket filters
+   */
+  void setRanking(int k);
+
+  /**
+   * @brief Setter for decoding jpg test images straight to a reduced size
+   *        near the working size, see ImageDecoder. On by default.
+   *
+   * @param reduced false to always decode at full size
+   */
+  void setReducedDecode(bool reduced);
+
+  /**
+   * @brief Setter for the order of the filters after the MCC filter, see
+   *        CascadePlan. The fixed order is used until one is set.
+   *
+   * @param plan order of the filters, copied
+   */
+  void setPlan(const CascadePlan& plan);
+
+  /**
+   * @brief Adds the memory of the indexes built from the flag metadata to a
+   *        report, one line per index. The metadata itself is reported by
+   *        FlagIndex::getMemoryUsage.
+   *
+   * @param usage report to add to
+   */
+  void getMemoryUsage(std::vector<MemoryUsage>& usage) const;
+
+  /**
+   * @brief Runs the MCC filter on a decoded image, then each filter a plan
+   *        can order alone on its own copy of the flags the MCC filter left,
+   *        and records which flags each one kept and how long it took
+   *
+   * @param test_file decoded input image, not empty
+   * @param sample sample to fill, except for which flags are correct
+   * @param scratch buffers owned by the calling thread
+   */
+  void sampleFilters(const Mat& test_file, CascadeSample& sample, FlagScratch& scratch) const;
+
+  /**
+   * @brief Reads an image file and finds the flag in it
+   *
+   * @param filename name of the input image
+   * @return result with the ids of the determined possible flags
+   */
+  FlagResult findFlag(const std::string& filename) const;
+
+  /**
+   * @brief Reads an image file and finds the flag in it using the given
+   *        buffers. Safe to call from several threads with separate scratch.
+   *
+   * @param filename name of the input image
+   * @param result result to fill with the ids of the determined possible
+   *        flags, reset first so it can be reused between images
+   * @param scratch buffers owned by the calling thread
+   */
+  void findFlag(const std::string& filename, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Decodes an encoded image and finds the flag in it using the given
+   *        buffers. Safe to call from several threads with separate scratch.
+   *
+   * @param encoded bytes of an image file, such as a jpg or png
+   * @param result result to fill with the ids of the determined possible
+   *        flags, reset first so it can be reused between images
+   * @param scratch buffers owned by the calling thread
+   */
+  void findFlag(const std::vector<uchar>& encoded, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Find flags goes through sequential algorithm steps to find a flag
+   *        given a mapping of existing flags
+   *          [1]: Calculates color information for test flag
+   *          [2]: Narrows down possible flags based on dominant colors
+   *          [3]: Narrows down possible flags based on MCC ratios
+   *          [4]: Calculates edge information for test flags and possible flags
+   *          [5]: Narrows down possible flags based on edge information
+   *          [6]: Calculates quadrant test flag and possible flag information
+   *          [7]: Narrowd down possible flags using quadrant information
+   *
+   * @param test_file decoded input image, not changed
+   * @param result result to fill with the ids of the determined possible flags
+   */
+  void findFlag(const Mat& test_file, FlagResult& result) const;
+
+  /**
+   * @brief Finds the flag in a decoded image using the given buffers. Safe to
+   *        call from several threads with separate scratch.
+   *
+   * @param test_file decoded input image, not changed
+   * @param result result to fill with the ids of the determined possible
+   *        flags, reset first so it can be reused between images
+   * @param scratch buffers owned by the calling thread
+   */
+  void findFlag(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Finds the flag in a decoded image whose color histogram was
+   *        already counted, such as a video frame checked for a scene
+   *        change. Safe to call from several threads with separate scratch.
+   *
+   * @param test_file decoded input image, not empty
+   * @param result result to fill with the ids of the determined possible
+   *        flags, already reset and holding the decode and color bucket time
+   * @param scratch buffers owned by the calling thread, arena.histogram
+   *        holding the histogram of test_file
+   */
+  void findCounted(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief   findClosestFlag method will analyze an input image and determine
+   *            similar looking flags based on the most common color present.
+   *
+   * @param   bucket_index holds the flag ids in their appropriate bucket
+   *            based on the most common color present.
+   * @param   image_bucket is the color bucket for the input image.
+   * @param   candidates is set to the similar looking flags, cleared first.
+   */
+  void findClosestFlag(const BucketIndex& bucket_index, const ColorBucket& image_bucket, CandidateSet& candidates) const;
+
+  /**
+   * @brief filterRatios gets closer to the target flag by removing flags
+   *        whose stored ratio isn't within kAcceptableError of the ratio
+   *        measured on the test image
+   *
+   * @param candidates is the set of possible flags remaining
+   * @param ratios is the stored ratio of every index flag by id, either the
+   *        common color ratio or the canny edge ratio of a region
+   * @param test_ratio is the same ratio measured on the test image
+   */
+  void filterRatios(CandidateSet& candidates, const float* ratios, float test_ratio) const;
+
+  /**
+   * @brief Removes the flags whose share of the dominant color they matched
+   *        isn't within kAcceptableError of that color's share of the test
+   *        image. The share of a flag is its largest stored bucket in the
+   *        cell or an adjacent cell of the color, the bucket it was posted
+   *        under in the dominant color index.
+   *
+   * @param candidates flags remaining after findDominantFlags
+   * @param result result with the dominant colors of the test image
+   * @param scratch buffers owned by the calling thread, first_colors set by
+   *        findDominantFlags
+   */
+  void filterColorShares(CandidateSet& candidates, FlagResult& result, const FlagScratch& scratch) const;
+
+  /**
+   * @brief Builds a bucket index of flags by the color bucket of a region
+   *
+   * @param candidates flags to add
+   * @param bucket_index index to build
+   * @param region region of the flags to use color buckets of
+   */
+  void buildBucketIndex(const CandidateSet& candidates, BucketIndex& bucket_index, FlagRegion region) const;
+
+  private:
+
+  /**
+   * @brief Runs the filters of findFlag on a decoded image
+   *
+   * @param test_file decoded input image, not empty
+   * @param result result to fill with the ids of the determined possible flags
+   * @param scratch buffers owned by the calling thread
+   * @param counted true if arena.histogram already holds the histogram of
+   *        test_file
+   */
+  void runFilters(const Mat& test_file, FlagResult& result, FlagScratch& scratch, bool counted) const;
+
+  /**
+   * @brief Measures the color histogram and dominant colors of a test image
+   *
+   * @param test_file decoded input image, not empty
+   * @param result result to fill with the image bucket and dominant colors
+   * @param scratch buffers owned by the calling thread, arena.histogram is
+   *        set to the histogram of test_file
+   * @param counted true if arena.histogram already holds it
+   */
+  void measureColors(const Mat& test_file, FlagResult& result, FlagScratch& scratch, bool counted) const;
+
+  /**
+   * @brief Runs one of the filters a plan can order on scratch.candidates,
+   *        resizing the test image first if the filter needs it and it
+   *        wasn't resized yet
+   *
+   * @param stage filter to run, one of kPlannedStages
+   * @param test_file decoded input image, not empty
+   * @param result result to fill with the time and ratios of the filter
+   * @param scratch buffers owned by the calling thread
+   */
+  void runFilter(FlagStage stage, const Mat& test_file, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Finds the flag in a decoded image, adding to a result that may
+   *        already hold the decode time
+   *
+   * @param test_file decoded input image, not changed
+   * @param result result to fill with the ids of the determined possible flags
+   * @param scratch buffers owned by the calling thread
+   */
+  void findDecoded(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Finds the flags sharing the most dominant colors with a test
+   *        image. Each color of the test image matches the flags posted
+   *        under its bucket or an adjacent bucket, and only the flags
+   *        matching the most colors are kept.
+   *
+   * @param colors dominant colors of the test image
+   * @param num_colors number of colors
+   * @param scratch buffers owned by the calling thread, candidates is set to
+   *        the flags found
+   * @return number of colors the flags found share, 0 if none matched
+   */
+  int findDominantFlags(const ColorBucket* colors, int num_colors, FlagScratch& scratch) const;
+
+  /**
+   * @brief Finds the flags closest to a test image by feature distance
+   *
+   * @param test_file decoded input image, not empty
+   * @param result result to fill with the ids of the closest flags
+   * @param scratch buffers owned by the calling thread, arena.histogram
+   *        holding the histogram of test_file
+   */
+  void searchNearest(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Ranks the flags by combined distance to a test image, stopping
+   *        after a stage once the closest flag leads by
+   *        FlagScorer::kExitMargin
+   *
+   * @param test_file decoded input image, not empty
+   * @param result result to fill with the ids of the closest flags and
+   *        their confidences, image_bucket already set
+   * @param scratch buffers owned by the calling thread, arena.histogram
+   *        holding the histogram of test_file
+   */
+  void rankFlags(const Mat& test_file, FlagResult& result, FlagScratch& scratch) const;
+
+  /**
+   * @brief Notes that a step ran and keeps the flags remaining after it when
+   *        tracing
+   *
+   * @param candidates flags remaining
+   * @param stage step that just ran
+   * @param result result to keep them in
+   */
+  void traceStage(const CandidateSet& candidates, FlagStage stage, FlagResult& result) const;
+
+  /**
+   * @brief Adds a finished search to the metrics, if any are set
+   *
+   * @param result result of the search
+   */
+  void recordMetrics(const FlagResult& result) const;
+
+  // Flag metadata searched by the filters
+  const FlagIndex& index_;
+
+  // Flag ids by most common color bucket of each region, built once from the
+  // stored features so no step builds an index per query
+  BucketIndex bucket_indexes_[kNumRegions];
+
+  // Flag ids posted under every dominant color of the whole flag
+  BucketIndex dominant_index_;
+
+  // Feature vectors of every flag, searched when nearest_k_ is above 0
+  VpTree feature_tree_;
+  int nearest_k_;
+
+  // Features of every flag by stage, used when rank_k_ is above 0
+  FlagScorer scorer_;
+  int rank_k_;
+
+  // Order of the filters after the MCC filter
+  CascadePlan plan_;
+
+  // Counters every search is added to, not owned
+  FlagMetrics* metrics_;
+
+  // Fill FlagResult::stage_flags
+  bool trace_;
+
+  // Decode jpg files at a reduced scale
+  bool reduced_decode_;
+};
@@ -0,0 +1,717 @@
+/*********************************************************************
+ * @file       FlagIndex.cpp
+ * @brief      FlagIndex holds the metadata calculated for every reference
+ *              flag and persists it to a versioned binary index file so the
+ *              reference images don't have to be decoded on every run.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagIndex.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+#include "ColorQuantizer.h"
+#include "CommonColorFinder.h"
+#include "EdgeRatioFinder.h"
+#include "ImageDecoder.h"
+#include "WorkStealingPool.h"
+
+// Version of the index file layout, bumped whenever FlagRecord changes
+const uint32_t FlagIndex::kVersion = 5;
+
+/**
+ * @brief IndexHeader starts every index file, followed by the records
+ */
+struct IndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t record_count;
+  uint32_t color_scheme;
+};
+
+// Identifies a flag index file
+static const char kIndexMagic[8] = { 'F', 'L', 'A', 'G', 'I', 'D', 'X', '\0' };
+
+/**
+ * @brief Constructor creates an empty index
+ */
+FlagIndex::FlagIndex() : color_scheme_(kColorBgr), records_(nullptr), count_(0) {}
+
+/**
+ * @brief BuildScratch holds the buffers one worker measures reference images
+ *        in, so each image reuses the memory of the one before it
+ */
+struct BuildScratch {
+  std::vector<uchar> encoded;
+  Mat image;
+  FeatureArena arena;
+};
+
+/**
+ * @brief Continues a 64 bit FNV-1a hash over a block of bytes
+ *
+ * @param hash hash of the bytes before the block
+ * @param data first byte of the block
+ * @param size number of bytes in the block
+ * @return hash including the block
+ */
+static uint64_t hashBytes(uint64_t hash, const unsigned char* data, size_t size) {
+  const uint64_t fnv_prime = 1099511628211ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= fnv_prime;
+  }
+  return hash;
+}
+
+// Starting value of a 64 bit FNV-1a hash
+static const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+
+/**
+ * @brief Builds the index by decoding and measuring every reference flag.
+ *        Every name and file is checked before anything is decoded, so a
+ *        missing image is reported up front instead of after measuring
+ *        the others. The images are then read, decoded and measured on
+ *        num_threads workers, each holding only the image it works on.
+ *        Colors are counted in the scheme ColorQuantizer has selected.
+ *
+ * @param references flags to index, see ReferenceList
+ * @param num_threads number of workers, 0 for one per core
+ * @param log stream to print every unreadable image to
+ * @return true if every image could be read
+ */
+bool FlagIndex::build(const std::vector<ReferenceEntry>& references, int num_threads, std::ostream& log) {
+  FlagRecord limits;
+  bool success = true;
+  std::unordered_set<std::string> names;
+  for (const ReferenceEntry& reference : references) {
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    if (reference.name.size() >= sizeof(limits.name) || reference.group.size() >= sizeof(limits.group) ||
+        reference.path.size() >= sizeof(limits.path)) {
+      log << "Name, group or path of flag \"" << reference.name << "\" is too long" << std::endl;
+      success = false;
+    } else if (!names.insert(reference.name).second) {
+      log << "Flag \"" << reference.name << "\" is listed more than once" << std::endl;
+      success = false;
+    } else if (!stampSource(reference.path, mtime, size)) {
+      log << "Could not read reference image \"" << reference.path << "\"" << std::endl;
+      success = false;
+    }
+  }
+  if (!success) {
+    return false;
+  }
+
+  // Each reference writes only its own record and result, so the workers
+  // never wait on each other
+  std::vector<FlagRecord> records(references.size());
+  std::vector<char> extracted(references.size(), 0);
+  {
+    WorkStealingPool pool(WorkStealingPool::chooseThreadCount(num_threads));
+    std::vector<BuildScratch> scratch(pool.getThreadCount());
+
+    // The workers already use every core
+    int opencv_threads = getNumThreads();
+    if (pool.getThreadCount() > 1) {
+      setNumThreads(1);
+    }
+    for (size_t i = 0; i < references.size(); ++i) {
+      pool.submit([&references, &records, &extracted, &scratch, i](int worker) {
+        BuildScratch& buffers = scratch.at(worker);
+        extracted.at(i) = extractRecord(references.at(i), buffers.encoded, buffers.image, buffers.arena,
+                                        records.at(i)) ? 1 : 0;
+      });
+    }
+    pool.wait();
+    setNumThreads(opencv_threads);
+  }
+
+  for (size_t i = 0; i < references.size(); ++i) {
+    if (!extracted.at(i)) {
+      log << "Could not decode reference image \"" << references.at(i).path << "\"" << std::endl;
+      success = false;
+    }
+  }
+  if (!success) {
+    return false;
+  }
+
+  mapping_.close();
+  owned_records_.swap(records);
+  setRecords(owned_records_.data(), (int)owned_records_.size());
+  color_scheme_ = ColorQuantizer::getScheme();
+  return true;
+}
+
+/**
+ * @brief Writes the index to a binary index file. The file is written
+ *        next to path and then renamed over it, so a process loading path
+ *        at the same time sees either the old or the new index.
+ *
+ * @param path file to write
+ * @return true if the whole file was written and renamed
+ */
+bool FlagIndex::save(const std::string& path) const {
+  std::string temporary_path = path + ".tmp";
+  std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+
+  IndexHeader header;
+  std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+  header.version = kVersion;
+  header.record_size = (uint32_t)sizeof(FlagRecord);
+  header.record_count = (uint32_t)count_;
+  header.color_scheme = (uint32_t)color_scheme_;
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(records_), (std::streamsize)(sizeof(FlagRecord) * count_));
+  out.close();
+  if (!out) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Maps an index file written by save into memory. Records are used
+ *        in place from the mapping.
+ *
+ * @param path file to load
+ * @param log stream to print to if the file isn't an index of the current
+ *        version
+ * @return true if the file exists, has the current version and every
+ *         name, group and path ends within its field
+ */
+bool FlagIndex::load(const std::string& path, std::ostream& log) {
+  MappedFile mapping;
+  if (!mapping.open(path) || mapping.getSize() < sizeof(IndexHeader)) {
+    return false;
+  }
+
+  // Check the file is an index with the same record layout as this build
+  const IndexHeader* header = reinterpret_cast<const IndexHeader*>(mapping.getData());
+  if (std::memcmp(header->magic, kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+      header->version != kVersion ||
+      header->record_size != sizeof(FlagRecord) ||
+      header->color_scheme >= (uint32_t)kNumColorSchemes ||
+      mapping.getSize() != sizeof(IndexHeader) + (size_t)header->record_count * sizeof(FlagRecord)) {
+    log << "Index file \"" << path << "\" is not a version " << kVersion << " index." << std::endl;
+    return false;
+  }
+
+  // Names and paths are used as C strings in place, so a record cut off
+  // without its terminator would read past the end of the field
+  int count = (int)header->record_count;
+  const FlagRecord* records = reinterpret_cast<const FlagRecord*>(mapping.getData() + sizeof(IndexHeader));
+  for (int i = 0; i < count; ++i) {
+    if (std::memchr(records[i].name, 0, sizeof(records[i].name)) == nullptr ||
+        std::memchr(records[i].group, 0, sizeof(records[i].group)) == nullptr ||
+        std::memchr(records[i].path, 0, sizeof(records[i].path)) == nullptr) {
+      log << "Index file \"" << path << "\" has a name, group or path without an end." << std::endl;
+      return false;
+    }
+  }
+
+  color_scheme_ = (ColorScheme)header->color_scheme;
+  owned_records_.clear();
+  mapping_.close();
+
+  // Take over the mapping, the records are read from it in place
+  mapping_.swap(mapping);
+  setRecords(records, count);
+  return true;
+}
+
+/**
+ * @brief Makes this index an in memory copy of another index, so it can be
+ *        changed without touching the other one or its file
+ *
+ * @param other index to copy
+ */
+void FlagIndex::copyFrom(const FlagIndex& other) {
+  std::vector<FlagRecord> records(other.records_, other.records_ + other.count_);
+  color_scheme_ = other.color_scheme_;
+  mapping_.close();
+  owned_records_.swap(records);
+  setRecords(owned_records_.data(), (int)owned_records_.size());
+}
+
+/**
+ * @brief Empties the index and closes its file, so the file can be
+ *        replaced
+ */
+void FlagIndex::clear() {
+  mapping_.close();
+  owned_records_.clear();
+  setRecords(nullptr, 0);
+}
+
+/**
+ * @brief Adds one flag after the others without rebuilding the rest
+ *
+ * @param record record of the flag, see extractRecord
+ * @return false if a flag with the same name is already in the index
+ */
+bool FlagIndex::addFlag(const FlagRecord& record) {
+  if (getId(record.name) >= 0) {
+    return false;
+  }
+  ownRecords();
+  owned_records_.push_back(record);
+  setRecords(owned_records_.data(), (int)owned_records_.size());
+  return true;
+}
+
+/**
+ * @brief Replaces the record of the flag with the same name, which keeps
+ *        its id
+ *
+ * @param record new record of the flag, see extractRecord
+ * @return false if no flag has the name of the record
+ */
+bool FlagIndex::replaceFlag(const FlagRecord& record) {
+  int id = getId(record.name);
+  if (id < 0) {
+    return false;
+  }
+  ownRecords();
+  owned_records_[id] = record;
+  setRecords(owned_records_.data(), (int)owned_records_.size());
+  return true;
+}
+
+/**
+ * @brief Removes one flag. The ids of the flags after it move down by one.
+ *
+ * @param name name of the flag
+ * @return false if the flag isn't in the index
+ */
+bool FlagIndex::removeFlag(const std::string& name) {
+  int id = getId(name);
+  if (id < 0) {
+    return false;
+  }
+  ownRecords();
+  owned_records_.erase(owned_records_.begin() + id);
+  setRecords(owned_records_.data(), (int)owned_records_.size());
+  return true;
+}
+
+/**
+ * @brief Checks every record against its source image. An image is only
+ *        rehashed when its modified time or size has changed. If only the
+ *        modified time changed and the hash still matches, the record
+ *        takes the new stamp, so the image isn't hashed again once the
+ *        index is saved.
+ *
+ * @param stale names of flags whose image changed or is missing
+ * @param num_restamped number of records given a new stamp
+ * @return true if any source image is stale
+ */
+bool FlagIndex::findStaleSources(std::vector<std::string>& stale, int& num_restamped) {
+  num_restamped = 0;
+  for (int id = 0; id < count_; ++id) {
+    const FlagRecord& record = records_[id];
+
+    int64_t mtime = 0;
+    uint64_t size = 0;
+    if (!stampSource(record.path, mtime, size)) {
+      stale.push_back(record.name);
+      continue;
+    }
+
+    // Unchanged stamp, no need to read the image
+    if (mtime == record.source_mtime && size == record.source_size) {
+      continue;
+    }
+
+    // Stamp changed, only stale if the contents changed too
+    uint64_t hash = 0;
+    if (size != record.source_size || !hashSource(record.path, hash) || hash != record.source_hash) {
+      stale.push_back(record.name);
+      continue;
+    }
+
+    // Same contents, keep the new stamp in an owned copy of the records
+    ownRecords();
+    owned_records_[id].source_mtime = mtime;
+    owned_records_[id].source_size = size;
+    ++num_restamped;
+  }
+  return !stale.empty();
+}
+
+/**
+ * @brief Getter for the number of flags in the index
+ *
+ * @return number of flags
+ */
+int FlagIndex::getSize() const {
+  return count_;
+}
+
+/**
+ * @brief Getter for the color scheme the histograms and color buckets of
+ *        the records were counted in
+ *
+ * @return scheme of the records, which ColorQuantizer has to have selected
+ *         before test images are compared with them
+ */
+ColorScheme FlagIndex::getColorScheme() const {
+  return color_scheme_;
+}
+
+/**
+ * @brief Getter for the record of a flag
+ *
+ * @param id position of the flag in the index
+ * @return record of the flag
+ */
+const FlagRecord& FlagIndex::getRecord(int id) const {
+  return records_[id];
+}
+
+/**
+ * @brief Getter for the name of a flag
+ *
+ * @param id position of the flag in the index
+ * @return name of the flag, stored in the record so no copy is made
+ */
+const char* FlagIndex::getName(int id) const {
+  return records_[id].name;
+}
+
+/**
+ * @brief Getter for the group of a flag, which is the flag it is a variant
+ *        of
+ *
+ * @param id position of the flag in the index
+ * @return group of the flag, or its name if it isn't a variant
+ */
+const char* FlagIndex::getGroup(int id) const {
+  return records_[id].group[0] != '\0' ? records_[id].group : records_[id].name;
+}
+
+/**
+ * @brief Finds the position of a flag by name
+ *
+ * @param name name of the flag
+ * @return position of the flag or -1 if it isn't in the index
+ */
+int FlagIndex::getId(const std::string& name) const {
+  std::unordered_map<std::string, int>::const_iterator it = ids_.find(name);
+  if (it == ids_.end()) {
+    return -1;
+  }
+  return it->second;
+}
+
+/**
+ * @brief Getter for the color bucket of a region of a flag
+ *
+ * @param id position of the flag in the index
+ * @param region region of the flag
+ * @return ColorBucket with the most common color and its ratio
+ */
+ColorBucket FlagIndex::getColorBucket(int id, FlagRegion region) const {
+  const RegionRecord& stored = records_[id].regions[region];
+
+  ColorBucket bucket;
+  bucket.setRedBucket(stored.red_bucket);
+  bucket.setGreenBucket(stored.green_bucket);
+  bucket.setBlueBucket(stored.blue_bucket);
+  bucket.setCount(stored.count);
+  bucket.setCommonColorRatio(stored.common_color_ratio);
+  return bucket;
+}
+
+/**
+ * @brief Getter for the canny edge ratio of a region of a flag
+ *
+ * @param id position of the flag in the index
+ * @param region region of the flag
+ * @param scale size the flag had when its edges were counted
+ * @return edge pixel count divided by total pixel count
+ */
+float FlagIndex::getEdgeRatio(int id, FlagRegion region, EdgeScale scale) const {
+  return records_[id].regions[region].edge_ratios[scale];
+}
+
+/**
+ * @brief Getter for the common color ratio of a region of every flag
+ *
+ * @param region region of the flags
+ * @return array of getSize() ratios indexed by flag id
+ */
+const float* FlagIndex::getCommonColorRatios(FlagRegion region) const {
+  return common_color_ratios_[region].data();
+}
+
+/**
+ * @brief Getter for the canny edge ratio of a region of every flag
+ *
+ * @param region region of the flags
+ * @param scale size the flags had when their edges were counted
+ * @return array of getSize() ratios indexed by flag id
+ */
+const float* FlagIndex::getEdgeRatios(FlagRegion region, EdgeScale scale) const {
+  return edge_ratios_[region][scale].data();
+}
+
+/**
+ * @brief Getter for the 8x8x8 histogram of a flag. The Mat points at the
+ *        stored counts and should not outlive the index.
+ *
+ * @param id position of the flag in the index
+ * @return histogram in the same layout as CommonColorFinder::populateHistogram
+ */
+Mat FlagIndex::getHistogram(int id) const {
+  int dims[] = { 8, 8, 8 };
+  return Mat(3, dims, CV_32S, const_cast<int32_t*>(records_[id].histogram));
+}
+
+/**
+ * @brief Adds the memory of the metadata to a report: the records, the
+ *        ratio arrays and the name lookup. Records used in place from a
+ *        mapped file are file pages the system can drop and read again,
+ *        and are reported as mapped.
+ *
+ * @param usage report to add to
+ */
+void FlagIndex::getMemoryUsage(std::vector<MemoryUsage>& usage) const {
+  if (owned_records_.empty()) {
+    usage.push_back({ "index records (mapped)", mapping_.getSize() });
+  } else {
+    usage.push_back({ "index records", owned_records_.capacity() * sizeof(FlagRecord) });
+  }
+
+  size_t ratio_bytes = 0;
+  for (int r = 0; r < kNumRegions; ++r) {
+    ratio_bytes += common_color_ratios_[r].capacity() * sizeof(float);
+    for (int s = 0; s < kNumEdgeScales; ++s) {
+      ratio_bytes += edge_ratios_[r][s].capacity() * sizeof(float);
+    }
+  }
+  usage.push_back({ "index ratio arrays", ratio_bytes });
+
+  // Names are stored again as keys. Each entry is a node of a key and id
+  // plus a next pointer, which is close for the common standard libraries.
+  size_t name_bytes = ids_.bucket_count() * sizeof(void*);
+  for (const std::pair<const std::string, int>& entry : ids_) {
+    name_bytes += sizeof(entry) + sizeof(void*);
+    if (entry.first.capacity() >= sizeof(std::string)) {
+      name_bytes += entry.first.capacity() + 1;
+    }
+  }
+  usage.push_back({ "index name lookup", name_bytes });
+}
+
+/**
+ * @brief Calculates the record for one image
+ *
+ * @param reference name, image file and group of the flag
+ * @param record record to fill
+ * @return true if the image could be read
+ */
+bool FlagIndex::extractRecord(const ReferenceEntry& reference, FlagRecord& record) {
+  std::vector<uchar> encoded;
+  Mat image;
+  FeatureArena arena;
+  return extractRecord(reference, encoded, image, arena, record);
+}
+
+/**
+ * @brief Calculates the record for one image in the given buffers. The
+ *        file is read once and hashed from memory before it is decoded.
+ *
+ * @param reference name, image file and group of the flag
+ * @param encoded buffer for the bytes of the file
+ * @param image buffer for the decoded image
+ * @param arena buffers the regions are measured in
+ * @param record record to fill
+ * @return true if the image could be read
+ */
+bool FlagIndex::extractRecord(const ReferenceEntry& reference, std::vector<uchar>& encoded, Mat& image,
+                              FeatureArena& arena, FlagRecord& record) {
+  std::memset(&record, 0, sizeof(record));
+  if (reference.name.size() >= sizeof(record.name) || reference.group.size() >= sizeof(record.group) ||
+      reference.path.size() >= sizeof(record.path)) {
+    return false;
+  }
+  std::memcpy(record.name, reference.name.c_str(), reference.name.size());
+  std::memcpy(record.group, reference.group.c_str(), reference.group.size());
+  std::memcpy(record.path, reference.path.c_str(), reference.path.size());
+
+  // Stamp the source before reading it so a later change is always noticed
+  if (!stampSource(reference.path, record.source_mtime, record.source_size) ||
+      !ImageDecoder::readFile(reference.path, encoded)) {
+    return false;
+  }
+  record.source_hash = hashBytes(kFnvOffsetBasis, encoded.data(), encoded.size());
+
+  // Reference images are always measured at full size
+  ImageDecoder::decode(encoded, false, image);
+  if (image.empty()) {
+    return false;
+  }
+  record.rows = image.rows;
+  record.cols = image.cols;
+
+  // Full histogram of the whole flag
+  Mat histogram = CommonColorFinder::populateHistogram(image);
+  std::memcpy(record.histogram, histogram.ptr<int>(), sizeof(record.histogram));
+
+  // Same flag at the size test images are resized to
+  Mat working_image = EdgeRatioFinder::resizeToWorkingSize(image);
+
+  // Color bucket and edge information for the whole flag, each quadrant and
+  // each grid cell, measured on views in one set of buffers
+  for (int r = 0; r < kNumRegions; ++r) {
+    Mat region = getRegion(image, (FlagRegion)r);
+    ColorBucket bucket = CommonColorFinder::getCommonColorBucket(region, arena.histogram);
+
+    RegionRecord& stored = record.regions[r];
+    stored.red_bucket = bucket.getRedBucket();
+    stored.green_bucket = bucket.getGreenBucket();
+    stored.blue_bucket = bucket.getBlueBucket();
+    stored.count = bucket.getCount();
+    stored.common_color_ratio = bucket.getCommonColorRatio();
+    stored.edge_ratios[kEdgeScaleNative] = EdgeRatioFinder::getEdgeRatio(region, arena);
+    stored.edge_ratios[kEdgeScaleWorking] = EdgeRatioFinder::getEdgeRatio(getRegion(working_image, (FlagRegion)r), arena);
+  }
+  return true;
+}
+
+/**
+ * @brief Points records_ at the given records and maps names to positions
+ *
+ * @param records first record
+ * @param count number of records
+ */
+void FlagIndex::setRecords(const FlagRecord* records, int count) {
+  records_ = records;
+  count_ = count;
+
+  ids_.clear();
+  for (int id = 0; id < count_; ++id) {
+    ids_[records_[id].name] = id;
+  }
+
+  // Copy the ratios the filters scan into one array per region and scale
+  for (int r = 0; r < kNumRegions; ++r) {
+    common_color_ratios_[r].resize(count_);
+    for (int s = 0; s < kNumEdgeScales; ++s) {
+      edge_ratios_[r][s].resize(count_);
+    }
+    for (int id = 0; id < count_; ++id) {
+      const RegionRecord& region = records_[id].regions[r];
+      common_color_ratios_[r][id] = region.common_color_ratio;
+      for (int s = 0; s < kNumEdgeScales; ++s) {
+        edge_ratios_[r][s][id] = region.edge_ratios[s];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Copies mapped records into owned_records_ and closes the mapping,
+ *        so the records can be changed
+ */
+void FlagIndex::ownRecords() {
+  if (mapping_.getData() == nullptr) {
+    return;
+  }
+  std::vector<FlagRecord> records(records_, records_ + count_);
+  mapping_.close();
+  owned_records_.swap(records);
+  setRecords(owned_records_.data(), (int)owned_records_.size());
+}
+
+/**
+ * @brief Gets the modified time and size of a file
+ *
+ * @param path file to check
+ * @param mtime modified time of the file
+ * @param size size of the file in bytes
+ * @return true if the file exists
+ */
+bool FlagIndex::stampSource(const std::string& path, int64_t& mtime, uint64_t& size) {
+  std::error_code error;
+  std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+  if (error) {
+    return false;
+  }
+  uintmax_t bytes = std::filesystem::file_size(path, error);
+  if (error) {
+    return false;
+  }
+
+  mtime = (int64_t)time.time_since_epoch().count();
+  size = (uint64_t)bytes;
+  return true;
+}
+
+/**
+ * @brief Reads the color scheme of an index file from its header without
+ *        loading the records
+ *
+ * @param path index file written by save
+ * @param scheme scheme to fill
+ * @return false if the file is missing or isn't an index of the current
+ *         version
+ */
+bool FlagIndex::readColorScheme(const std::string& path, ColorScheme& scheme) {
+  std::ifstream in(path, std::ios::binary);
+  IndexHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || header.version != kVersion ||
+      header.color_scheme >= (uint32_t)kNumColorSchemes) {
+    return false;
+  }
+  scheme = (ColorScheme)header.color_scheme;
+  return true;
+}
+
+/**
+ * @brief Hashes the contents of a file with 64 bit FNV-1a
+ *
+ * @param path file to hash
+ * @param hash hash of the file
+ * @return true if the file could be read
+ */
+bool FlagIndex::hashSource(const std::string& path, uint64_t& hash) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+
+  hash = kFnvOffsetBasis;
+  char buffer[64 * 1024];
+  while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+    hash = hashBytes(hash, reinterpret_cast<const unsigned char*>(buffer), (size_t)in.gcount());
+  }
+  return true;
+}
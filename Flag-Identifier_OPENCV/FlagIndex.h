@@ -0,0 +1,367 @@
+/*********************************************************************
+ * @file       FlagIndex.h
+ * @brief      FlagIndex holds the metadata calculated for every reference
+ *              flag and persists it to a versioned binary index file so the
+ *              reference images don't have to be decoded on every run.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ColorBucket.h"
+#include "ColorQuantizer.h"
+#include "EdgeRatioFinder.h"
+#include "FlagRegion.h"
+#include "MappedFile.h"
+#include "MemoryUsage.h"
+#include "ReferenceList.h"
+
+using namespace cv;
+
+/**
+ * @brief RegionRecord holds the color bucket and edge information for one
+ *        region of a reference flag. Edge ratios are kept for every EdgeScale
+ *        so the edge filters never have to decode reference images. The
+ *        layout is written to disk as is.
+ */
+struct RegionRecord {
+  int32_t red_bucket;
+  int32_t green_bucket;
+  int32_t blue_bucket;
+  int32_t count;
+  float common_color_ratio;
+  float edge_ratios[kNumEdgeScales];
+};
+
+/**
+ * @brief FlagRecord holds everything calculated for one reference flag and
+ *        the stamp of the image it was calculated from. The layout is written
+ *        to disk as is and used in place when the index file is mapped.
+ */
+struct FlagRecord {
+  char name[64];
+  char group[64];
+  char path[256];
+  int64_t source_mtime;
+  uint64_t source_size;
+  uint64_t source_hash;
+  int32_t rows;
+  int32_t cols;
+  int32_t histogram[8 * 8 * 8];
+  RegionRecord regions[kNumRegions];
+};
+
+/**
+ * @class FlagIndex is the database of reference flag metadata. It is either
+ *        built by decoding the reference images or loaded from an index file
+ *        that was saved by an earlier build.
+ */
+class FlagIndex {
+  public:
+
+  // Version of the index file layout, bumped whenever FlagRecord changes
+  static const uint32_t kVersion;
+
+  /**
+   * @brief Constructor creates an empty index
+   */
+  FlagIndex();
+
+  /**
+   * @brief Builds the index by decoding and measuring every reference flag.
+   *        Every name and file is checked before anything is decoded, so a
+   *        missing image is reported up front instead of after measuring
+   *        the others. The images are then read, decoded and measured on
+   *        num_threads workers, each holding only the image it works on.
+   *        Colors are counted in the scheme ColorQuantizer has selected.
+   *
+   * @param references flags to index, see ReferenceList
+   * @param num_threads number of workers, 0 for one per core
+   * @param log stream to print every unreadable image to
+   * @return true if every image could be read
+   */
+  bool build(const std::vector<ReferenceEntry>& references, int num_threads, std::ostream& log);
+
+  /**
+   * @brief Writes the index to a binary index file. The file is written
+   *        next to path and then renamed over it, so a process loading path
+   *        at the same time sees either the old or the new index.
+   *
+   * @param path file to write
+   * @return true if the whole file was written and renamed
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * @brief Maps an index file written by save into memory. Records are used
+   *        in place from the mapping.
+   *
+   * @param path file to load
+   * @param log stream to print to if the file isn't an index of the current
+   *        version
+   * @return true if the file exists, has the current version and every
+   *         name, group and path ends within its field
+   */
+  bool load(const std::string& path, std::ostream& log);
+
+  /**
+   * @brief Makes this index an in memory copy of another index, so it can be
+   *        changed without touching the other one or its file
+   *
+   * @param other index to copy
+   */
+  void copyFrom(const FlagIndex& other);
+
+  /**
+   * @brief Empties the index and closes its file, so the file can be
+   *        replaced
+   */
+  void clear();
+
+  /**
+   * @brief Adds one flag after the others without rebuilding the rest
+   *
+   * @param record record of the flag, see extractRecord
+   * @return false if a flag with the same name is already in the index
+   */
+  bool addFlag(const FlagRecord& record);
+
+  /**
+   * @brief Replaces the record of the flag with the same name, which keeps
+   *        its id
+   *
+   * @param record new record of the flag, see extractRecord
+   * @return false if no flag has the name of the record
+   */
+  bool replaceFlag(const FlagRecord& record);
+
+  /**
+   * @brief Removes one flag. The ids of the flags after it move down by one.
+   *
+   * @param name name of the flag
+   * @return false if the flag isn't in the index
+   */
+  bool removeFlag(const std::string& name);
+
+  /**
+   * @brief Checks every record against its source image. An image is only
+   *        rehashed when its modified time or size has changed. If only the
+   *        modified time changed and the hash still matches, the record
+   *        takes the new stamp, so the image isn't hashed again once the
+   *        index is saved.
+   *
+   * @param stale names of flags whose image changed or is missing
+   * @param num_restamped number of records given a new stamp
+   * @return true if any source image is stale
+   */
+  bool findStaleSources(std::vector<std::string>& stale, int& num_restamped);
+
+  /**
+   * @brief Getter for the number of flags in the index
+   *
+   * @return number of flags
+   */
+  int getSize() const;
+
+  /**
+   * @brief Getter for the color scheme the histograms and color buckets of
+   *        the records were counted in
+   *
+   * @return scheme of the records, which ColorQuantizer has to have selected
+   *         before test images are compared with them
+   */
+  ColorScheme getColorScheme() const;
+
+  /**
+   * @brief Getter for the record of a flag
+   *
+   * @param id position of the flag in the index
+   * @return record of the flag
+   */
+  const FlagRecord& getRecord(int id) const;
+
+  /**
+   * @brief Getter for the name of a flag
+   *
+   * @param id position of the flag in the index
+   * @return name of the flag, stored in the record so no copy is made
+   */
+  const char* getName(int id) const;
+
+  /**
+   * @brief Getter for the group of a flag, which is the flag it is a variant
+   *        of
+   *
+   * @param id position of the flag in the index
+   * @return group of the flag, or its name if it isn't a variant
+   */
+  const char* getGroup(int id) const;
+
+  /**
+   * @brief Finds the position of a flag by name
+   *
+   * @param name name of the flag
+   * @return position of the flag or -1 if it isn't in the index
+   */
+  int getId(const std::string& name) const;
+
+  /**
+   * @brief Getter for the color bucket of a region of a flag
+   *
+   * @param id position of the flag in the index
+   * @param region region of the flag
+   * @return ColorBucket with the most common color and its ratio
+   */
+  ColorBucket getColorBucket(int id, FlagRegion region) const;
+
+  /**
+   * @brief Getter for the canny edge ratio of a region of a flag
+   *
+   * @param id position of the flag in the index
+   * @param region region of the flag
+   * @param scale size the flag had when its edges were counted
+   * @return edge pixel count divided by total pixel count
+   */
+  float getEdgeRatio(int id, FlagRegion region, EdgeScale scale) const;
+
+  /**
+   * @brief Getter for the common color ratio of a region of every flag
+   *
+   * @param region region of the flags
+   * @return array of getSize() ratios indexed by flag id
+   */
+  const float* getCommonColorRatios(FlagRegion region) const;
+
+  /**
+   * @brief Getter for the canny edge ratio of a region of every flag
+   *
+   * @param region region of the flags
+   * @param scale size the flags had when their edges were counted
+   * @return array of getSize() ratios indexed by flag id
+   */
+  const float* getEdgeRatios(FlagRegion region, EdgeScale scale) const;
+
+  /**
+   * @brief Getter for the 8x8x8 histogram of a flag. The Mat points at the
+   *        stored counts and should not outlive the index.
+   *
+   * @param id position of the flag in the index
+   * @return histogram in the same layout as CommonColorFinder::populateHistogram
+   */
+  Mat getHistogram(int id) const;
+
+  /**
+   * @brief Adds the memory of the metadata to a report: the records, the
+   *        ratio arrays and the name lookup. Records used in place from a
+   *        mapped file are file pages the system can drop and read again,
+   *        and are reported as mapped.
+   *
+   * @param usage report to add to
+   */
+  void getMemoryUsage(std::vector<MemoryUsage>& usage) const;
+
+  /**
+   * @brief Calculates the record for one image
+   *
+   * @param reference name, image file and group of the flag
+   * @param record record to fill
+   * @return true if the image could be read
+   */
+  static bool extractRecord(const ReferenceEntry& reference, FlagRecord& record);
+
+  /**
+   * @brief Gets the modified time and size of a file
+   *
+   * @param path file to check
+   * @param mtime modified time of the file
+   * @param size size of the file in bytes
+   * @return true if the file exists
+   */
+  static bool stampSource(const std::string& path, int64_t& mtime, uint64_t& size);
+
+  /**
+   * @brief Reads the color scheme of an index file from its header without
+   *        loading the records
+   *
+   * @param path index file written by save
+   * @param scheme scheme to fill
+   * @return false if the file is missing or isn't an index of the current
+   *         version
+   */
+  static bool readColorScheme(const std::string& path, ColorScheme& scheme);
+
+  private:
+
+  // Copying would share the file mapping
+  FlagIndex(const FlagIndex&);
+  FlagIndex& operator=(const FlagIndex&);
+
+  /**
+   * @brief Points records_ at the given records and maps names to positions
+   *
+   * @param records first record
+   * @param count number of records
+   */
+  void setRecords(const FlagRecord* records, int count);
+
+  /**
+   * @brief Copies mapped records into owned_records_ and closes the mapping,
+   *        so the records can be changed
+   */
+  void ownRecords();
+
+  /**
+   * @brief Calculates the record for one image in the given buffers. The
+   *        file is read once and hashed from memory before it is decoded.
+   *
+   * @param reference name, image file and group of the flag
+   * @param encoded buffer for the bytes of the file
+   * @param image buffer for the decoded image
+   * @param arena buffers the regions are measured in
+   * @param record record to fill
+   * @return true if the image could be read
+   */
+  static bool extractRecord(const ReferenceEntry& reference, std::vector<uchar>& encoded, Mat& image,
+                            FeatureArena& arena, FlagRecord& record);
+
+  /**
+   * @brief Hashes the contents of a file with 64 bit FNV-1a
+   *
+   * @param path file to hash
+   * @param hash hash of the file
+   * @return true if the file could be read
+   */
+  static bool hashSource(const std::string& path, uint64_t& hash);
+
+  // Scheme the records were counted in, kept in the file header
+  ColorScheme color_scheme_;
+
+  // Records built in memory, empty when the records come from a mapped file
+  std::vector<FlagRecord> owned_records_;
+  MappedFile mapping_;
+
+  // Records in use, either owned_records_ or inside mapping_
+  const FlagRecord* records_;
+  int count_;
+
+  // Flag name to position in records_
+  std::unordered_map<std::string, int> ids_;
+
+  // Ratios of every record by region, indexed by flag id so the filters
+  // read one contiguous array instead of striding over whole records
+  std::vector<float> common_color_ratios_[kNumRegions];
+  std::vector<float> edge_ratios_[kNumRegions][kNumEdgeScales];
+};
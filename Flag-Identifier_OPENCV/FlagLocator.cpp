@@ -0,0 +1,241 @@
+/*********************************************************************
+ * @file       FlagLocator.cpp
+ * @brief      FlagLocator finds where a flag is in a larger picture by
+ *              sliding windows of every flag's shape over an integral
+ *              histogram of the picture.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagLocator.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+const int FlagLocator::kWorkingSize = 480;
+const int FlagLocator::kCellSize = 8;
+const float FlagLocator::kMinBinShare = 0.002f;
+const int FlagLocator::kMinWindowCells = 8;
+const double FlagLocator::kScaleStep = 1.25;
+const int FlagLocator::kStepsPerWindow = 8;
+const int FlagLocator::kRingFraction = 4;
+
+/**
+ * @brief Constructor builds the color models of the flags in the index
+ *
+ * @param index reference flag metadata
+ */
+FlagLocator::FlagLocator(const FlagIndex& index) : index_(index) {
+
+  // Flags whose height to width ratio rounds to the same tenth share a group
+  std::vector<int> group_keys;
+  for (int flag = 0; flag < index_.getSize(); ++flag) {
+    const FlagRecord& record = index_.getRecord(flag);
+    if (record.rows <= 0 || record.cols <= 0) {
+      continue;
+    }
+    int key = (int)std::lround(10.0 * record.rows / record.cols);
+    size_t g = std::find(group_keys.begin(), group_keys.end(), key) - group_keys.begin();
+    if (g == group_keys.size()) {
+      group_keys.push_back(key);
+      groups_.push_back(LocatorGroup());
+      groups_.back().aspect = key / 10.0;
+    }
+    LocatorGroup& group = groups_[g];
+
+    double total = 0.0;
+    for (int bin = 0; bin < IntegralHistogram::kNumBins; ++bin) {
+      total += record.histogram[bin];
+    }
+    if (total <= 0.0) {
+      continue;
+    }
+    LocatorModel model;
+    model.flag = flag;
+    for (int bin = 0; bin < IntegralHistogram::kNumBins; ++bin) {
+      float share = (float)(record.histogram[bin] / total);
+      if (share < kMinBinShare) {
+        continue;
+      }
+      size_t slot = std::find(group.bins.begin(), group.bins.end(), bin) - group.bins.begin();
+      if (slot == group.bins.size()) {
+        group.bins.push_back(bin);
+      }
+      model.slots.push_back((int)slot);
+      model.weights.push_back(std::sqrt(share));
+    }
+    group.models.push_back(model);
+  }
+}
+
+/**
+ * @brief Finds the window of the picture that looks most like one of the
+ *        flags
+ *
+ * @param image BGR picture to search
+ * @param location best window and flag, filled when one is found
+ * @return false if the picture is empty or there are no flags
+ */
+bool FlagLocator::locate(const Mat& image, FlagLocation& location) {
+  if (image.empty() || groups_.empty()) {
+    return false;
+  }
+
+  // Only the colors of each cell are needed, so a smaller picture loses
+  // little and cuts the counting
+  double scale = std::min(1.0, (double)kWorkingSize / std::max(image.rows, image.cols));
+  const Mat* working = &image;
+  if (scale < 1.0) {
+    resize(image, working_file_, Size(), scale, scale, INTER_AREA);
+    working = &working_file_;
+  }
+  integral_.build(*working, kCellSize);
+  int grid_rows = integral_.getRows();
+  int grid_cols = integral_.getCols();
+
+  float best_score = -2.0f;
+  const LocatorGroup* best_group = nullptr;
+  const LocatorModel* best_model = nullptr;
+  int best_row = 0;
+  int best_col = 0;
+  int best_rows = 0;
+  int best_cols = 0;
+  for (const LocatorGroup& group : groups_) {
+    int last_cols = 0;
+    double width = std::min(kMinWindowCells, grid_cols);
+    while (true) {
+      int cols = (int)std::lround(width);
+      int rows = std::max(1, (int)std::lround(cols * group.aspect));
+      if (cols != last_cols && rows <= grid_rows) {
+        int step = std::max(1, cols / kStepsPerWindow);
+        for (int row = 0; row + rows <= grid_rows; row += step) {
+          for (int col = 0; col + cols <= grid_cols; col += step) {
+            measureWindow(group, row, col, rows, cols);
+            for (const LocatorModel& model : group.models) {
+              float score = scoreModel(model);
+              if (score > best_score) {
+                best_score = score;
+                best_group = &group;
+                best_model = &model;
+                best_row = row;
+                best_col = col;
+                best_rows = rows;
+                best_cols = cols;
+              }
+            }
+          }
+        }
+      }
+      last_cols = cols;
+      if (width >= grid_cols) {
+        break;
+      }
+      width = std::min((double)grid_cols, width * kScaleStep);
+    }
+  }
+  if (best_model == nullptr) {
+    return false;
+  }
+
+  // Move one edge of the best window by a cell at a time, keeping the move
+  // that helps most, so the box fits the flag closer than the scale and
+  // position steps allow
+  static const int kMoves[8][4] = {
+    { -1, 0, 1, 0 }, { 1, 0, -1, 0 }, { 0, 0, 1, 0 }, { 0, 0, -1, 0 },
+    { 0, -1, 0, 1 }, { 0, 1, 0, -1 }, { 0, 0, 0, 1 }, { 0, 0, 0, -1 }
+  };
+  for (int moves = 0; moves < grid_rows + grid_cols; ++moves) {
+    int move = -1;
+    float move_score = best_score;
+    for (int m = 0; m < 8; ++m) {
+      int row = best_row + kMoves[m][0];
+      int col = best_col + kMoves[m][1];
+      int rows = best_rows + kMoves[m][2];
+      int cols = best_cols + kMoves[m][3];
+      if (row < 0 || col < 0 || rows < 1 || cols < 1 || row + rows > grid_rows || col + cols > grid_cols) {
+        continue;
+      }
+      measureWindow(*best_group, row, col, rows, cols);
+      float score = scoreModel(*best_model);
+      if (score > move_score) {
+        move = m;
+        move_score = score;
+      }
+    }
+    if (move < 0) {
+      break;
+    }
+    best_score = move_score;
+    best_row += kMoves[move][0];
+    best_col += kMoves[move][1];
+    best_rows += kMoves[move][2];
+    best_cols += kMoves[move][3];
+  }
+
+  // Cells back to pixels of the picture given
+  int left = best_col * kCellSize;
+  int top = best_row * kCellSize;
+  int right = std::min((best_col + best_cols) * kCellSize, working->cols);
+  int bottom = std::min((best_row + best_rows) * kCellSize, working->rows);
+  Rect box((int)std::lround(left / scale), (int)std::lround(top / scale),
+    (int)std::lround((right - left) / scale), (int)std::lround((bottom - top) / scale));
+  location.box = box & Rect(0, 0, image.cols, image.rows);
+  location.flag = best_model->flag;
+  location.score = best_score;
+  return true;
+}
+
+/**
+ * @brief Fills inside_ and ring_ with the square root of each group bin's
+ *        share of a window and of the ring around it. The ring is cut off
+ *        at the edges of the picture and is all zero if nothing is left.
+ *
+ * @param group group whose bins to measure
+ * @param row first row of cells of the window
+ * @param col first column of cells of the window
+ * @param rows rows of cells of the window
+ * @param cols columns of cells of the window
+ */
+void FlagLocator::measureWindow(const LocatorGroup& group, int row, int col, int rows, int cols) {
+  int margin_rows = std::max(1, rows / kRingFraction);
+  int margin_cols = std::max(1, cols / kRingFraction);
+  int outer_row = std::max(0, row - margin_rows);
+  int outer_col = std::max(0, col - margin_cols);
+  int outer_rows = std::min(integral_.getRows(), row + rows + margin_rows) - outer_row;
+  int outer_cols = std::min(integral_.getCols(), col + cols + margin_cols) - outer_col;
+
+  double pixels = integral_.getPixelCount(row, col, rows, cols);
+  double ring_pixels = integral_.getPixelCount(outer_row, outer_col, outer_rows, outer_cols) - pixels;
+  inside_.resize(group.bins.size());
+  ring_.resize(group.bins.size());
+  for (size_t i = 0; i < group.bins.size(); ++i) {
+    int count = integral_.getCount(row, col, rows, cols, group.bins[i]);
+    inside_[i] = (float)std::sqrt(count / pixels);
+    if (ring_pixels > 0.0) {
+      int ring_count = integral_.getCount(outer_row, outer_col, outer_rows, outer_cols, group.bins[i]) - count;
+      ring_[i] = (float)std::sqrt(ring_count / ring_pixels);
+    } else {
+      ring_[i] = 0.0f;
+    }
+  }
+}
+
+/**
+ * @brief Scores the last measured window against one flag
+ *
+ * @param model color model of the flag
+ * @return similarity of the window less that of its ring
+ */
+float FlagLocator::scoreModel(const LocatorModel& model) const {
+  float score = 0.0f;
+  for (size_t j = 0; j < model.slots.size(); ++j) {
+    score += model.weights[j] * (inside_[model.slots[j]] - ring_[model.slots[j]]);
+  }
+  return score;
+}
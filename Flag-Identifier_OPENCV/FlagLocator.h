@@ -0,0 +1,154 @@
+/*********************************************************************
+ * @file       FlagLocator.h
+ * @brief      FlagLocator finds where a flag is in a larger picture by
+ *              sliding windows of every flag's shape over an integral
+ *              histogram of the picture.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+#include "FlagIndex.h"
+#include "IntegralHistogram.h"
+
+using namespace cv;
+
+/**
+ * @brief FlagLocation is the best window FlagLocator found
+ */
+struct FlagLocation {
+
+  // Window in pixels of the picture given to locate
+  Rect box;
+
+  // Id of the flag whose colors fit the window best
+  int flag;
+
+  // Bhattacharyya coefficient of the window and the flag, less that of the
+  // ring around the window, from -1 to 1
+  float score;
+};
+
+/**
+ * @class FlagLocator keeps a sparse color model of every reference flag,
+ *        the square root of each bucket holding at least kMinBinShare of
+ *        the flag, and groups the flags by their height to width ratio.
+ *        locate shrinks the picture to kWorkingSize, builds an
+ *        IntegralHistogram of it and tries windows of each group's shape at
+ *        every scale and position. A window scores how much more like a flag
+ *        its colors are than the colors of a ring around it, so a window
+ *        holding only part of a flag, with more of the flag around it, loses
+ *        to the window holding the whole flag. The best window is then
+ *        grown or shrunk one cell at a time while its score improves. The
+ *        index must outlive the locator.
+ */
+class FlagLocator {
+  public:
+
+  // Longest side of the picture the windows slide over
+  static const int kWorkingSize;
+
+  // Width and height of a cell of the integral histogram, in working pixels
+  static const int kCellSize;
+
+  // Share of a flag a bucket needs to be in its color model
+  static const float kMinBinShare;
+
+  // Narrowest window in cells, and how much wider each scale is
+  static const int kMinWindowCells;
+  static const double kScaleStep;
+
+  // Windows move by 1 / kStepsPerWindow of their width, at least a cell
+  static const int kStepsPerWindow;
+
+  // The ring adds 1 / kRingFraction of the window on each side
+  static const int kRingFraction;
+
+  /**
+   * @brief Constructor builds the color models of the flags in the index
+   *
+   * @param index reference flag metadata
+   */
+  explicit FlagLocator(const FlagIndex& index);
+
+  /**
+   * @brief Finds the window of the picture that looks most like one of the
+   *        flags
+   *
+   * @param image BGR picture to search
+   * @param location best window and flag, filled when one is found
+   * @return false if the picture is empty or there are no flags
+   */
+  bool locate(const Mat& image, FlagLocation& location);
+
+  private:
+
+  /**
+   * @brief LocatorModel is the sparse color model of one flag
+   */
+  struct LocatorModel {
+    int flag;
+
+    // Positions in the group's bins, and the square root of the flag's
+    // share of each
+    std::vector<int> slots;
+    std::vector<float> weights;
+  };
+
+  /**
+   * @brief LocatorGroup is the flags that share a window shape
+   */
+  struct LocatorGroup {
+
+    // Height over width of the windows
+    double aspect;
+
+    // Every bucket in any model of the group
+    std::vector<int> bins;
+
+    std::vector<LocatorModel> models;
+  };
+
+  // Copying would share the buffers
+  FlagLocator(const FlagLocator&);
+  FlagLocator& operator=(const FlagLocator&);
+
+  /**
+   * @brief Fills inside_ and ring_ with the square root of each group bin's
+   *        share of a window and of the ring around it. The ring is cut off
+   *        at the edges of the picture and is all zero if nothing is left.
+   *
+   * @param group group whose bins to measure
+   * @param row first row of cells of the window
+   * @param col first column of cells of the window
+   * @param rows rows of cells of the window
+   * @param cols columns of cells of the window
+   */
+  void measureWindow(const LocatorGroup& group, int row, int col, int rows, int cols);
+
+  /**
+   * @brief Scores the last measured window against one flag
+   *
+   * @param model color model of the flag
+   * @return similarity of the window less that of its ring
+   */
+  float scoreModel(const LocatorModel& model) const;
+
+  const FlagIndex& index_;
+  std::vector<LocatorGroup> groups_;
+
+  // Buffers reused between pictures
+  Mat working_file_;
+  IntegralHistogram integral_;
+  std::vector<float> inside_;
+  std::vector<float> ring_;
+};
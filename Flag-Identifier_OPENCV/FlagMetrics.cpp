@@ -0,0 +1,248 @@
+/*********************************************************************
+ * @file       FlagMetrics.cpp
+ * @brief      FlagMetrics counts the time and candidates of every step of
+ *              findFlag across all queries and threads, and StageTimer times
+ *              one step of one query.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagMetrics.h"
+
+#include <fstream>
+
+const double FlagMetrics::kLatencyBucketsMs[FlagMetrics::kNumLatencyBuckets] = {
+  0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 25.0, 50.0, 100.0, 250.0
+};
+
+/**
+ * @brief Returns the label of a step used in metric names
+ *
+ * @param stage step to name
+ * @return lower case name without spaces
+ */
+static const char* getStageKey(int stage) {
+  switch (stage) {
+    case kStageDecode:
+      return "decode";
+    case kStageColorBucket:
+      return "color_bucket";
+    case kStageMcc:
+      return "mcc";
+    case kStageMccRatio:
+      return "mcc_ratio";
+    case kStageResize:
+      return "resize";
+    case kStageCanny:
+      return "canny";
+    case kStageQuadrant:
+      return "quadrant";
+    case kStageNearest:
+      return "nearest";
+    case kStageScoreColor:
+      return "score_color";
+    case kStageScoreLayout:
+      return "score_layout";
+    case kStageScoreEdges:
+      return "score_edges";
+    case kStageFrameReuse:
+      return "frame_reuse";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief Constructor starts timing a step
+ *
+ * @param result result to write the time into
+ * @param stage step being timed
+ */
+StageTimer::StageTimer(FlagResult& result, FlagStage stage)
+  : result_(result), stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+/**
+ * @brief Destructor writes the time of the step
+ */
+StageTimer::~StageTimer() {
+  result_.stage_ms[stage_] =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
+
+/**
+ * @brief Constructor starts every counter at 0
+ */
+FlagMetrics::FlagMetrics() {
+  reset();
+}
+
+/**
+ * @brief Adds the times and candidate counts of one query
+ *
+ * @param result result of findFlag
+ */
+void FlagMetrics::record(const FlagResult& result) {
+  queries_.fetch_add(1, std::memory_order_relaxed);
+  if (!result.decoded) {
+    unreadable_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    double ms = result.stage_ms[stage];
+    if (ms < 0.0) {
+      continue;
+    }
+    StageCounters& counters = stages_[stage];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.total_ns.fetch_add((uint64_t)(ms * 1e6), std::memory_order_relaxed);
+
+    int bucket = 0;
+    while (bucket < kNumLatencyBuckets && ms > kLatencyBucketsMs[bucket]) {
+      ++bucket;
+    }
+    counters.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    if (result.candidates_in[stage] >= 0) {
+      counters.candidates_in.fetch_add(result.candidates_in[stage], std::memory_order_relaxed);
+      counters.candidates_out.fetch_add(result.candidates_out[stage], std::memory_order_relaxed);
+    }
+  }
+
+  if (result.decoded) {
+    stages_[result.deciding_stage].decided.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Sets every counter back to 0
+ */
+void FlagMetrics::reset() {
+  queries_.store(0, std::memory_order_relaxed);
+  unreadable_.store(0, std::memory_order_relaxed);
+  for (StageCounters& counters : stages_) {
+    counters.calls.store(0, std::memory_order_relaxed);
+    counters.total_ns.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint64_t>& count : counters.latency) {
+      count.store(0, std::memory_order_relaxed);
+    }
+    counters.candidates_in.store(0, std::memory_order_relaxed);
+    counters.candidates_out.store(0, std::memory_order_relaxed);
+    counters.decided.store(0, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Writes every counter in the Prometheus text format
+ *
+ * @param out stream to write to
+ */
+void FlagMetrics::writePrometheus(std::ostream& out) const {
+  out << "# HELP flag_queries_total Images searched by findFlag.\n"
+      << "# TYPE flag_queries_total counter\n"
+      << "flag_queries_total " << queries_.load(std::memory_order_relaxed) << "\n"
+      << "# HELP flag_unreadable_total Images that could not be decoded.\n"
+      << "# TYPE flag_unreadable_total counter\n"
+      << "flag_unreadable_total " << unreadable_.load(std::memory_order_relaxed) << "\n";
+
+  // Histogram buckets are cumulative in the text format
+  out << "# HELP flag_stage_duration_seconds Time spent in each step of findFlag.\n"
+      << "# TYPE flag_stage_duration_seconds histogram\n";
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    const StageCounters& counters = stages_[stage];
+    uint64_t cumulative = 0;
+    for (int bucket = 0; bucket <= kNumLatencyBuckets; ++bucket) {
+      cumulative += counters.latency[bucket].load(std::memory_order_relaxed);
+      out << "flag_stage_duration_seconds_bucket{stage=\"" << getStageKey(stage) << "\",le=\"";
+      if (bucket < kNumLatencyBuckets) {
+        out << kLatencyBucketsMs[bucket] / 1000.0;
+      } else {
+        out << "+Inf";
+      }
+      out << "\"} " << cumulative << "\n";
+    }
+    out << "flag_stage_duration_seconds_sum{stage=\"" << getStageKey(stage) << "\"} "
+        << counters.total_ns.load(std::memory_order_relaxed) / 1e9 << "\n"
+        << "flag_stage_duration_seconds_count{stage=\"" << getStageKey(stage) << "\"} " << cumulative << "\n";
+  }
+
+  out << "# HELP flag_stage_candidates_in_total Candidate flags before each filter.\n"
+      << "# TYPE flag_stage_candidates_in_total counter\n";
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    out << "flag_stage_candidates_in_total{stage=\"" << getStageKey(stage) << "\"} "
+        << stages_[stage].candidates_in.load(std::memory_order_relaxed) << "\n";
+  }
+  out << "# HELP flag_stage_candidates_out_total Candidate flags after each filter.\n"
+      << "# TYPE flag_stage_candidates_out_total counter\n";
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    out << "flag_stage_candidates_out_total{stage=\"" << getStageKey(stage) << "\"} "
+        << stages_[stage].candidates_out.load(std::memory_order_relaxed) << "\n";
+  }
+  out << "# HELP flag_stage_decided_total Images whose search ended after each step.\n"
+      << "# TYPE flag_stage_decided_total counter\n";
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    out << "flag_stage_decided_total{stage=\"" << getStageKey(stage) << "\"} "
+        << stages_[stage].decided.load(std::memory_order_relaxed) << "\n";
+  }
+}
+
+/**
+ * @brief Writes every counter as one JSON object
+ *
+ * @param out stream to write to
+ */
+void FlagMetrics::writeJson(std::ostream& out) const {
+  out << "{\n"
+      << "  \"queries\": " << queries_.load(std::memory_order_relaxed) << ",\n"
+      << "  \"unreadable\": " << unreadable_.load(std::memory_order_relaxed) << ",\n"
+      << "  \"stages\": {\n";
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    const StageCounters& counters = stages_[stage];
+    uint64_t calls = counters.calls.load(std::memory_order_relaxed);
+    double total_ms = counters.total_ns.load(std::memory_order_relaxed) / 1e6;
+    out << "    \"" << getStageKey(stage) << "\": { \"calls\": " << calls
+        << ", \"total_ms\": " << total_ms
+        << ", \"mean_ms\": " << (calls > 0 ? total_ms / calls : 0.0)
+        << ", \"candidates_in\": " << counters.candidates_in.load(std::memory_order_relaxed)
+        << ", \"candidates_out\": " << counters.candidates_out.load(std::memory_order_relaxed)
+        << ", \"decided\": " << counters.decided.load(std::memory_order_relaxed)
+        << ", \"latency_ms\": [";
+    for (int bucket = 0; bucket <= kNumLatencyBuckets; ++bucket) {
+      out << (bucket > 0 ? ", " : "") << "{ \"le\": ";
+      if (bucket < kNumLatencyBuckets) {
+        out << kLatencyBucketsMs[bucket];
+      } else {
+        out << "\"+Inf\"";
+      }
+      out << ", \"count\": " << counters.latency[bucket].load(std::memory_order_relaxed) << " }";
+    }
+    out << "] }" << (stage + 1 < kNumStages ? "," : "") << "\n";
+  }
+  out << "  }\n}\n";
+}
+
+/**
+ * @brief Writes the counters to a file, as JSON if the name ends in .json
+ *        and in the Prometheus text format otherwise
+ *
+ * @param path file to write
+ * @return true if the file was written
+ */
+bool FlagMetrics::writeFile(const std::string& path) const {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  const std::string json_extension = ".json";
+  if (path.size() >= json_extension.size() &&
+      path.compare(path.size() - json_extension.size(), json_extension.size(), json_extension) == 0) {
+    writeJson(out);
+  } else {
+    writePrometheus(out);
+  }
+  return (bool)out;
+}
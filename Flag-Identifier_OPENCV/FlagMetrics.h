@@ -0,0 +1,142 @@
+/*********************************************************************
+ * @file       FlagMetrics.h
+ * @brief      FlagMetrics counts the time and candidates of every step of
+ *              findFlag across all queries and threads, and StageTimer times
+ *              one step of one query.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "FlagFinder.h"
+
+/**
+ * @class StageTimer writes the milliseconds between its construction and
+ *        destruction into the stage time of a result
+ */
+class StageTimer {
+  public:
+
+  /**
+   * @brief Constructor starts timing a step
+   *
+   * @param result result to write the time into
+   * @param stage step being timed
+   */
+  StageTimer(FlagResult& result, FlagStage stage);
+
+  /**
+   * @brief Destructor writes the time of the step
+   */
+  ~StageTimer();
+
+  private:
+
+  // Copying would time the step twice
+  StageTimer(const StageTimer&);
+  StageTimer& operator=(const StageTimer&);
+
+  FlagResult& result_;
+  FlagStage stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @class FlagMetrics adds up the results of findFlag. Every counter is a
+ *        relaxed atomic, so any number of threads can record at once without
+ *        a lock. Totals are read while recording continues, so a dump may
+ *        split a query that is being recorded.
+ */
+class FlagMetrics {
+  public:
+
+  // Upper bounds of the latency histogram buckets in milliseconds
+  static const int kNumLatencyBuckets = 12;
+  static const double kLatencyBucketsMs[kNumLatencyBuckets];
+
+  /**
+   * @brief Constructor starts every counter at 0
+   */
+  FlagMetrics();
+
+  /**
+   * @brief Adds the times and candidate counts of one query
+   *
+   * @param result result of findFlag
+   */
+  void record(const FlagResult& result);
+
+  /**
+   * @brief Sets every counter back to 0
+   */
+  void reset();
+
+  /**
+   * @brief Writes every counter in the Prometheus text format
+   *
+   * @param out stream to write to
+   */
+  void writePrometheus(std::ostream& out) const;
+
+  /**
+   * @brief Writes every counter as one JSON object
+   *
+   * @param out stream to write to
+   */
+  void writeJson(std::ostream& out) const;
+
+  /**
+   * @brief Writes the counters to a file, as JSON if the name ends in .json
+   *        and in the Prometheus text format otherwise
+   *
+   * @param path file to write
+   * @return true if the file was written
+   */
+  bool writeFile(const std::string& path) const;
+
+  private:
+
+  // Copying atomics isn't allowed
+  FlagMetrics(const FlagMetrics&);
+  FlagMetrics& operator=(const FlagMetrics&);
+
+  /**
+   * @brief StageCounters holds the counters of one step on its own cache
+   *        line so threads recording different steps don't share lines
+   */
+  struct alignas(64) StageCounters {
+
+    // Queries the step ran for
+    std::atomic<uint64_t> calls;
+
+    // Total time of the step in nanoseconds
+    std::atomic<uint64_t> total_ns;
+
+    // Queries that took at most each latency bucket, last bucket is +Inf
+    std::atomic<uint64_t> latency[kNumLatencyBuckets + 1];
+
+    // Total candidates before and after the step
+    std::atomic<uint64_t> candidates_in;
+    std::atomic<uint64_t> candidates_out;
+
+    // Queries the step decided, ending the search early for all but the
+    // last step
+    std::atomic<uint64_t> decided;
+  };
+
+  StageCounters stages_[kNumStages];
+  std::atomic<uint64_t> queries_;
+  std::atomic<uint64_t> unreadable_;
+};
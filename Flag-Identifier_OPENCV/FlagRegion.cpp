@@ -0,0 +1,89 @@
+/*********************************************************************
+ * @file       FlagRegion.cpp
+ * @brief      FlagRegion names the parts of a flag image that features are
+ *              calculated for (the whole image and each quadrant).
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagRegion.h"
+
+/**
+ * @brief Returns a view of the given region of an image. No pixels are copied.
+ *
+ * @param img Image to take the region from
+ * @param region Region of the image to return
+ * @return Mat header over the region of img
+ */
+Mat getRegion(const Mat& img, FlagRegion region) {
+  int half_rows = img.rows / 2;
+  int half_cols = img.cols / 2;
+
+  switch (region) {
+    case kRegionUpperLeft:
+      return img(Range(0, half_rows), Range(0, half_cols));
+    case kRegionUpperRight:
+      return img(Range(0, half_rows), Range(half_cols, img.cols));
+    case kRegionLowerLeft:
+      return img(Range(half_rows, img.rows), Range(0, half_cols));
+    case kRegionLowerRight:
+      return img(Range(half_rows, img.rows), Range(half_cols, img.cols));
+    default:
+      break;
+  }
+
+  // Grid cells, rounded down so the cells cover the whole image
+  if (region >= kRegionCell00 && region <= kRegionCell22) {
+    int row = (region - kRegionCell00) / kGridSize;
+    int col = (region - kRegionCell00) % kGridSize;
+    return img(Range(row * img.rows / kGridSize, (row + 1) * img.rows / kGridSize),
+               Range(col * img.cols / kGridSize, (col + 1) * img.cols / kGridSize));
+  }
+  return img;
+}
+
+/**
+ * @brief Returns a printable name for a region
+ *
+ * @param region Region to name
+ * @return Name of the region
+ */
+const char* getRegionName(FlagRegion region) {
+  switch (region) {
+    case kRegionWhole:
+      return "whole";
+    case kRegionUpperLeft:
+      return "upper left";
+    case kRegionUpperRight:
+      return "upper right";
+    case kRegionLowerLeft:
+      return "lower left";
+    case kRegionLowerRight:
+      return "lower right";
+    case kRegionCell00:
+      return "cell 0,0";
+    case kRegionCell01:
+      return "cell 0,1";
+    case kRegionCell02:
+      return "cell 0,2";
+    case kRegionCell10:
+      return "cell 1,0";
+    case kRegionCell11:
+      return "cell 1,1";
+    case kRegionCell12:
+      return "cell 1,2";
+    case kRegionCell20:
+      return "cell 2,0";
+    case kRegionCell21:
+      return "cell 2,1";
+    case kRegionCell22:
+      return "cell 2,2";
+    default:
+      return "unknown";
+  }
+}
@@ -0,0 +1,62 @@
+/*********************************************************************
+ * @file       FlagRegion.h
+ * @brief      FlagRegion names the parts of a flag image that features are
+ *              calculated for (the whole image and each quadrant).
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+
+using namespace cv;
+
+/**
+ * @brief Regions of a flag image that features are stored for. Quadrants are
+ *        split at rows / 2 and cols / 2, the same as the quadrant filter.
+ *        Grid cells split the image into 3x3 and are named by row, then
+ *        column.
+ */
+enum FlagRegion {
+  kRegionWhole = 0,
+  kRegionUpperLeft,
+  kRegionUpperRight,
+  kRegionLowerLeft,
+  kRegionLowerRight,
+  kRegionCell00,
+  kRegionCell01,
+  kRegionCell02,
+  kRegionCell10,
+  kRegionCell11,
+  kRegionCell12,
+  kRegionCell20,
+  kRegionCell21,
+  kRegionCell22,
+  kNumRegions
+};
+
+// Number of grid cells along each side of an image
+const int kGridSize = 3;
+
+/**
+ * @brief Returns a view of the given region of an image. No pixels are copied.
+ *
+ * @param img Image to take the region from
+ * @param region Region of the image to return
+ * @return Mat header over the region of img
+ */
+Mat getRegion(const Mat& img, FlagRegion region);
+
+/**
+ * @brief Returns a printable name for a region
+ *
+ * @param region Region to name
+ * @return Name of the region
+ */
+const char* getRegionName(FlagRegion region);
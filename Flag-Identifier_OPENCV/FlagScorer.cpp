@@ -0,0 +1,300 @@
+/*********************************************************************
+ * @file       FlagScorer.cpp
+ * @brief      FlagScorer ranks reference flags by one combined distance
+ *              over their color, layout and edge features, with a
+ *              confidence for each and a distance past which a test image
+ *              matches no flag.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagScorer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Number of buckets in an 8x8x8 histogram
+static const int kHistogramBins = 8 * 8 * 8;
+
+// Regions whose color bucket is scored, every region but the whole flag
+static const int kNumLayoutRegions = kNumRegions - 1;
+
+// Spread of each feature between copies of the same flag that were
+// rescaled, cropped, brightened, blurred and saved as jpg again. A
+// difference of one spread adds 1 to the distance.
+static const float kHistogramSpread = 0.15f;
+static const float kAspectSpread = 0.02f;
+static const float kBucketSpread = 3.0f;
+static const float kEdgeSpread = 0.008f;
+
+// Largest distance one feature can add
+static const float kTermCap = 25.0f;
+
+// Distance that divides the chance of a flag by e, see rank
+static const float kConfidenceScale = 8.0f;
+
+// A copy of the right flag is within 60 about 95% of the time, and about
+// 2% of the world flags are within 60 of a state flag
+const float FlagScorer::kRejectDistance = 60.0f;
+
+// Leads of 25 were never wrong on the noisy copies, and skip the edge
+// stage for about a quarter of them
+const float FlagScorer::kExitMargin = 25.0f;
+
+/**
+ * @brief Returns the distance one feature adds
+ *
+ * @param difference difference between the test and flag feature
+ * @param spread spread of the feature between copies of the same flag
+ * @return squared difference in spreads, at most kTermCap
+ */
+static float getTerm(float difference, float spread) {
+  float spreads = difference / spread;
+  return std::min(spreads * spreads, kTermCap);
+}
+
+/**
+ * @brief Constructor creates a scorer of no flags
+ */
+FlagScorer::FlagScorer() : count_(0) {}
+
+/**
+ * @brief Copies the features of every flag out of the index, laid out so
+ *        each stage reads one contiguous array
+ *
+ * @param index flag metadata to score
+ */
+void FlagScorer::build(const FlagIndex& index) {
+  count_ = index.getSize();
+  histograms_.resize((size_t)count_ * kHistogramBins);
+  aspects_.resize(count_);
+  buckets_.resize((size_t)count_ * kNumLayoutRegions * 3);
+  edge_ratios_.resize((size_t)count_ * kNumScoredEdgeRegions);
+
+  for (int id = 0; id < count_; ++id) {
+    const FlagRecord& record = index.getRecord(id);
+
+    double total = 0.0;
+    for (int i = 0; i < kHistogramBins; ++i) {
+      total += record.histogram[i];
+    }
+    float* histogram = &histograms_[(size_t)id * kHistogramBins];
+    for (int i = 0; i < kHistogramBins; ++i) {
+      histogram[i] = total > 0.0 ? (float)std::sqrt(record.histogram[i] / total) : 0.0f;
+    }
+
+    aspects_[id] = std::log((float)record.cols / record.rows);
+
+    uint8_t* buckets = &buckets_[(size_t)id * kNumLayoutRegions * 3];
+    for (int r = 0; r < kNumLayoutRegions; ++r) {
+      const RegionRecord& region = record.regions[r + 1];
+      buckets[r * 3] = (uint8_t)region.red_bucket;
+      buckets[r * 3 + 1] = (uint8_t)region.green_bucket;
+      buckets[r * 3 + 2] = (uint8_t)region.blue_bucket;
+    }
+
+    for (int r = 0; r < kNumScoredEdgeRegions; ++r) {
+      edge_ratios_[(size_t)id * kNumScoredEdgeRegions + r] = std::sqrt(record.regions[r].edge_ratios[kEdgeScaleWorking]);
+    }
+  }
+}
+
+/**
+ * @brief Getter for the number of flags
+ *
+ * @return number of flags the scorer was built with
+ */
+int FlagScorer::getSize() const {
+  return count_;
+}
+
+/**
+ * @brief Returns the memory the scorer holds
+ *
+ * @return bytes allocated, counting the capacity of its buffers
+ */
+size_t FlagScorer::getMemoryBytes() const {
+  return (histograms_.capacity() + aspects_.capacity() + edge_ratios_.capacity()) * sizeof(float) +
+    buckets_.capacity() * sizeof(uint8_t);
+}
+
+/**
+ * @brief Starts the distance of every flag with the Hellinger distance of
+ *        its color histogram and the difference of its aspect ratio
+ *
+ * @param histogram 8x8x8 histogram of the test image
+ * @param aspect columns divided by rows of the test image
+ * @param features buffer for the normalized test histogram
+ * @param candidates set to the flags within kRejectDistance
+ * @param distances distance of every flag by id
+ */
+void FlagScorer::scoreColor(const Mat& histogram, float aspect, std::vector<float>& features, CandidateSet& candidates,
+                            std::vector<float>& distances) const {
+  const int* counts = histogram.ptr<int>();
+  double total = 0.0;
+  for (int i = 0; i < kHistogramBins; ++i) {
+    total += counts[i];
+  }
+  features.resize(kHistogramBins);
+  for (int i = 0; i < kHistogramBins; ++i) {
+    features[i] = total > 0.0 ? (float)std::sqrt(counts[i] / total) : 0.0f;
+  }
+
+  // Both histograms have length 1, so the squared distance between them is
+  // 2 minus twice their dot product
+  float log_aspect = std::log(aspect);
+  distances.resize(count_);
+  candidates.reset(count_);
+  for (int id = 0; id < count_; ++id) {
+    const float* flag_histogram = &histograms_[(size_t)id * kHistogramBins];
+    float dot = 0.0f;
+    for (int i = 0; i < kHistogramBins; ++i) {
+      dot += features[i] * flag_histogram[i];
+    }
+    float hellinger = std::sqrt(std::max(2.0f - 2.0f * dot, 0.0f));
+    distances[id] = getTerm(hellinger, kHistogramSpread) + getTerm(log_aspect - aspects_[id], kAspectSpread);
+    if (distances[id] <= kRejectDistance) {
+      candidates.insert(id);
+    }
+  }
+}
+
+/**
+ * @brief Adds the distance between the color buckets of each quadrant and
+ *        grid cell
+ *
+ * @param buckets color bucket of every region of the test image, by
+ *        FlagRegion, the whole image is not used
+ * @param candidates flags still in reach, those past kRejectDistance are
+ *        removed
+ * @param distances distance of every flag by id
+ */
+void FlagScorer::scoreLayout(const ColorBucket* buckets, CandidateSet& candidates, std::vector<float>& distances) const {
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    const uint8_t* flag_buckets = &buckets_[(size_t)id * kNumLayoutRegions * 3];
+    for (int r = 0; r < kNumLayoutRegions; ++r) {
+      const ColorBucket& bucket = buckets[r + 1];
+      int red = bucket.getRedBucket() - flag_buckets[r * 3];
+      int green = bucket.getGreenBucket() - flag_buckets[r * 3 + 1];
+      int blue = bucket.getBlueBucket() - flag_buckets[r * 3 + 2];
+      distances[id] += getTerm(std::sqrt((float)(red * red + green * green + blue * blue)), kBucketSpread);
+    }
+  }
+  prune(candidates, distances);
+}
+
+/**
+ * @brief Adds the difference of the edge ratio of the whole flag and
+ *        each quadrant
+ *
+ * @param edge_ratios kNumScoredEdgeRegions edge ratios of the test image
+ *        at the working size, by FlagRegion
+ * @param candidates flags still in reach, those past kRejectDistance are
+ *        removed
+ * @param distances distance of every flag by id
+ */
+void FlagScorer::scoreEdges(const float* edge_ratios, CandidateSet& candidates, std::vector<float>& distances) const {
+
+  // Square roots even out the spread of busy and plain flags
+  float roots[kNumScoredEdgeRegions];
+  for (int r = 0; r < kNumScoredEdgeRegions; ++r) {
+    roots[r] = std::sqrt(std::max(edge_ratios[r], 0.0f));
+  }
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    const float* flag_ratios = &edge_ratios_[(size_t)id * kNumScoredEdgeRegions];
+    for (int r = 0; r < kNumScoredEdgeRegions; ++r) {
+      distances[id] += getTerm(roots[r] - flag_ratios[r], kEdgeSpread);
+    }
+  }
+  prune(candidates, distances);
+}
+
+/**
+ * @brief Checks if the closest flag leads by at least kExitMargin
+ *
+ * @param candidates flags still in reach
+ * @param distances distance of every flag by id
+ * @return true if the later stages can't change the answer
+ */
+bool FlagScorer::isDecided(const CandidateSet& candidates, const std::vector<float>& distances) const {
+  if (candidates.empty()) {
+    return true;
+  }
+
+  // A lone flag still has to stay clear of the reject distance
+  float closest = kRejectDistance;
+  float second = kRejectDistance;
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    if (distances[id] < closest) {
+      second = closest;
+      closest = distances[id];
+    } else if (distances[id] < second) {
+      second = distances[id];
+    }
+  }
+  return second - closest >= kExitMargin;
+}
+
+/**
+ * @brief Lists the closest flags with the chance that each is the flag
+ *        in the test image. The chances are weighed by exp(-distance / 8),
+ *        fitted on noisy copies of the reference flags, against the
+ *        weight of a flag at kRejectDistance, which stands for none of
+ *        them.
+ *
+ * @param candidates flags still in reach
+ * @param distances distance of every flag by id
+ * @param k largest number of flags to list
+ * @param ranked closest flags, closest first
+ * @param confidences chance of each flag in ranked
+ */
+void FlagScorer::rank(const CandidateSet& candidates, const std::vector<float>& distances, int k,
+                      std::vector<Neighbor>& ranked, std::vector<float>& confidences) const {
+  ranked.clear();
+  confidences.clear();
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    Neighbor neighbor;
+    neighbor.id = id;
+    neighbor.distance = distances[id];
+    ranked.push_back(neighbor);
+  }
+  if (ranked.empty()) {
+    return;
+  }
+
+  // Weights are taken relative to the closest flag so none underflow
+  size_t listed = std::min(ranked.size(), (size_t)std::max(k, 1));
+  std::partial_sort(ranked.begin(), ranked.begin() + listed, ranked.end(),
+                    [](const Neighbor& a, const Neighbor& b) {
+                      return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+                    });
+  float closest = ranked.front().distance;
+  double total = std::exp((closest - kRejectDistance) / kConfidenceScale);
+  for (const Neighbor& neighbor : ranked) {
+    total += std::exp((closest - neighbor.distance) / kConfidenceScale);
+  }
+
+  ranked.resize(listed);
+  for (const Neighbor& neighbor : ranked) {
+    confidences.push_back((float)(std::exp((closest - neighbor.distance) / kConfidenceScale) / total));
+  }
+}
+
+/**
+ * @brief Removes the flags past kRejectDistance
+ *
+ * @param candidates flags still in reach
+ * @param distances distance of every flag by id
+ */
+void FlagScorer::prune(CandidateSet& candidates, const std::vector<float>& distances) const {
+  for (int id = candidates.first(); id >= 0; id = candidates.next(id)) {
+    if (distances[id] > kRejectDistance) {
+      candidates.erase(id);
+    }
+  }
+}
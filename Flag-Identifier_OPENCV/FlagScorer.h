@@ -0,0 +1,171 @@
+/*********************************************************************
+ * @file       FlagScorer.h
+ * @brief      FlagScorer ranks reference flags by one combined distance
+ *              over their color, layout and edge features, with a
+ *              confidence for each and a distance past which a test image
+ *              matches no flag.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "CandidateSet.h"
+#include "ColorBucket.h"
+#include "FlagIndex.h"
+#include "FlagRegion.h"
+#include "VpTree.h"
+
+using namespace cv;
+
+// Regions whose edge ratio is scored: the whole flag and each quadrant
+const int kNumScoredEdgeRegions = 5;
+
+/**
+ * @class FlagScorer adds up a distance for every flag in stages, cheapest
+ *        first: the color histogram and aspect ratio, then the color bucket
+ *        of each quadrant and grid cell, then the edge ratios. Each feature
+ *        adds its squared difference divided by the spread it has between
+ *        copies of the same flag, capped so one noisy feature can't push
+ *        the right flag out on its own. Distances only grow, so a flag past
+ *        kRejectDistance is dropped as soon as it gets there and later
+ *        stages only score the flags still in reach.
+ */
+class FlagScorer {
+  public:
+
+  // Distance past which a flag is not a match, even if it is the closest
+  static const float kRejectDistance;
+
+  // Lead the closest flag needs over the next one, or over kRejectDistance
+  // if it is the only one left, for the later stages to be skipped
+  static const float kExitMargin;
+
+  /**
+   * @brief Constructor creates a scorer of no flags
+   */
+  FlagScorer();
+
+  /**
+   * @brief Copies the features of every flag out of the index, laid out so
+   *        each stage reads one contiguous array
+   *
+   * @param index flag metadata to score
+   */
+  void build(const FlagIndex& index);
+
+  /**
+   * @brief Getter for the number of flags
+   *
+   * @return number of flags the scorer was built with
+   */
+  int getSize() const;
+
+  /**
+   * @brief Returns the memory the scorer holds
+   *
+   * @return bytes allocated, counting the capacity of its buffers
+   */
+  size_t getMemoryBytes() const;
+
+  /**
+   * @brief Starts the distance of every flag with the Hellinger distance of
+   *        its color histogram and the difference of its aspect ratio
+   *
+   * @param histogram 8x8x8 histogram of the test image
+   * @param aspect columns divided by rows of the test image
+   * @param features buffer for the normalized test histogram
+   * @param candidates set to the flags within kRejectDistance
+   * @param distances distance of every flag by id
+   */
+  void scoreColor(const Mat& histogram, float aspect, std::vector<float>& features, CandidateSet& candidates,
+                  std::vector<float>& distances) const;
+
+  /**
+   * @brief Adds the distance between the color buckets of each quadrant and
+   *        grid cell
+   *
+   * @param buckets color bucket of every region of the test image, by
+   *        FlagRegion, the whole image is not used
+   * @param candidates flags still in reach, those past kRejectDistance are
+   *        removed
+   * @param distances distance of every flag by id
+   */
+  void scoreLayout(const ColorBucket* buckets, CandidateSet& candidates, std::vector<float>& distances) const;
+
+  /**
+   * @brief Adds the difference of the edge ratio of the whole flag and
+   *        each quadrant
+   *
+   * @param edge_ratios kNumScoredEdgeRegions edge ratios of the test image
+   *        at the working size, by FlagRegion
+   * @param candidates flags still in reach, those past kRejectDistance are
+   *        removed
+   * @param distances distance of every flag by id
+   */
+  void scoreEdges(const float* edge_ratios, CandidateSet& candidates, std::vector<float>& distances) const;
+
+  /**
+   * @brief Checks if the closest flag leads by at least kExitMargin
+   *
+   * @param candidates flags still in reach
+   * @param distances distance of every flag by id
+   * @return true if the later stages can't change the answer
+   */
+  bool isDecided(const CandidateSet& candidates, const std::vector<float>& distances) const;
+
+  /**
+   * @brief Lists the closest flags with the chance that each is the flag
+   *        in the test image. The chances are weighed by exp(-distance / 8),
+   *        fitted on noisy copies of the reference flags, against the
+   *        weight of a flag at kRejectDistance, which stands for none of
+   *        them.
+   *
+   * @param candidates flags still in reach
+   * @param distances distance of every flag by id
+   * @param k largest number of flags to list
+   * @param ranked closest flags, closest first
+   * @param confidences chance of each flag in ranked
+   */
+  void rank(const CandidateSet& candidates, const std::vector<float>& distances, int k, std::vector<Neighbor>& ranked,
+            std::vector<float>& confidences) const;
+
+  private:
+
+  // Copying would duplicate every feature array
+  FlagScorer(const FlagScorer&);
+  FlagScorer& operator=(const FlagScorer&);
+
+  /**
+   * @brief Removes the flags past kRejectDistance
+   *
+   * @param candidates flags still in reach
+   * @param distances distance of every flag by id
+   */
+  void prune(CandidateSet& candidates, const std::vector<float>& distances) const;
+
+  int count_;
+
+  // Square root of the normalized histogram of each flag, 512 per flag
+  std::vector<float> histograms_;
+
+  // Log of the aspect ratio of each flag
+  std::vector<float> aspects_;
+
+  // Red, green and blue bucket of every region but the whole flag, 3 per
+  // region and (kNumRegions - 1) * 3 per flag
+  std::vector<uint8_t> buckets_;
+
+  // Square root of the edge ratio of each scored region at the working
+  // size, kNumScoredEdgeRegions per flag
+  std::vector<float> edge_ratios_;
+};
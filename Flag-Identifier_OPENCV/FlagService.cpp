@@ -0,0 +1,407 @@
+/*********************************************************************
+ * @file       FlagService.cpp
+ * @brief      FlagService keeps the flag index loaded and answers a stream
+ *              of encoded test images, grouping requests that arrive close
+ *              together into one batch for the BatchQueryEngine.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagService.h"
+
+#include <memory>
+#include <sstream>
+
+#include "JsonFormat.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Writing to a closed client shouldn't stop the service
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// Largest image accepted in one frame
+static const uint32_t kMaxFrameBytes = 64u << 20;
+
+/**
+ * @brief Reads a 4 byte little endian frame length
+ *
+ * @param bytes first byte of the length
+ * @return length of the frame
+ */
+static uint32_t decodeLength(const unsigned char* bytes) {
+  return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+/**
+ * @brief Constructor starts the batch thread and the query workers
+ *
+ * @param catalog flags to search, read again for every batch
+ * @param num_threads number of query workers, 0 for one per core
+ * @param batch_size most requests searched in one batch, at least 1
+ * @param max_wait_ms longest a request waits for its batch to fill
+ */
+FlagService::FlagService(const FlagCatalog& catalog, int num_threads, int batch_size, int max_wait_ms)
+  : catalog_(catalog), engine_(num_threads), batch_size_(batch_size > 0 ? batch_size : 1),
+    max_wait_(max_wait_ms > 0 ? max_wait_ms : 0), stopping_(false), metrics_(nullptr) {
+  batch_thread_ = std::thread(&FlagService::batchLoop, this);
+}
+
+/**
+ * @brief Destructor answers every waiting request and stops the threads
+ */
+FlagService::~FlagService() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  batch_thread_.join();
+}
+
+/**
+ * @brief Setter for a metrics file rewritten at most once a second while
+ *        batches are searched, and once more when the service stops
+ *
+ * @param metrics counters the finder records into
+ * @param path file to write, see FlagMetrics::writeFile
+ */
+void FlagService::setMetricsFile(const FlagMetrics* metrics, const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  metrics_ = metrics;
+  metrics_path_ = path;
+}
+
+/**
+ * @brief Queues an encoded image to be searched in the next batch
+ *
+ * @param id number echoed in the response
+ * @param encoded bytes of the image file, moved from
+ * @param reply called with the response once the batch is searched
+ * @return false if the service is stopping, in which case the request is
+ *         not queued and reply is never called
+ */
+bool FlagService::submit(int64_t id, std::vector<uchar>& encoded, Reply reply) {
+  Request request;
+  request.id = id;
+  request.encoded.swap(encoded);
+  request.reply = reply;
+  request.arrival = Clock::now();
+
+  bool full;
+  {
+    // The batch thread may already have stopped and would never answer
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return false;
+    }
+    pending_.push_back(std::move(request));
+    full = pending_.size() == 1 || pending_.size() >= batch_size_;
+  }
+
+  // The batch thread only needs waking for the first request or a full batch
+  if (full) {
+    ready_.notify_one();
+  }
+  return true;
+}
+
+/**
+ * @brief Answers framed requests read from a stream, writing one JSON line
+ *        per request to out. Returns after the stream ends and every
+ *        request has been answered.
+ *
+ * @param in stream of framed requests, opened in binary mode
+ * @param out stream the responses are written to
+ * @return number of requests answered
+ */
+int64_t FlagService::serveStream(std::istream& in, std::ostream& out) {
+  std::mutex out_mutex;
+  std::condition_variable answered;
+  int64_t num_requests = 0;
+  int64_t num_answered = 0;
+
+  std::vector<uchar> encoded;
+  while (readFrame(in, encoded)) {
+    bool queued = submit(num_requests, encoded, [&](const std::string& response) {
+      std::lock_guard<std::mutex> lock(out_mutex);
+      out << response << std::endl;
+      ++num_answered;
+      answered.notify_one();
+    });
+    if (!queued) {
+      break;
+    }
+    ++num_requests;
+  }
+
+  // Every reply refers to locals of this call, wait for the last one
+  std::unique_lock<std::mutex> lock(out_mutex);
+  answered.wait(lock, [&] { return num_answered == num_requests; });
+  return num_answered;
+}
+
+/**
+ * @brief Answers framed requests from every client of a Unix domain socket.
+ *        Each client gets the responses to its own requests, numbered from
+ *        0 on each connection. Runs until the socket fails, then shuts
+ *        down every connection and waits for its reader thread, so no
+ *        request is submitted after it returns.
+ *
+ * @param path file name of the socket, replaced if it exists
+ * @return false if the socket could not be opened or isn't supported
+ */
+#ifdef _WIN32
+bool FlagService::serveSocket(const std::string& path) {
+  std::cerr << "Unix domain sockets are not supported on this platform, use stdin instead." << std::endl;
+  return false;
+}
+#else
+bool FlagService::serveSocket(const std::string& path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "Socket path \"" << path << "\" is too long." << std::endl;
+    return false;
+  }
+  path.copy(address.sun_path, path.size());
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path.c_str());
+  if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+    std::cerr << "Could not listen on \"" << path << "\"." << std::endl;
+    if (listener >= 0) {
+      close(listener);
+    }
+    return false;
+  }
+
+  while (true) {
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) {
+      break;
+    }
+
+    // Threads of clients that have disconnected are joined as new ones come
+    for (size_t c = 0; c < clients_.size();) {
+      if (!clients_[c].connection->reading) {
+        clients_[c].thread.join();
+        clients_[c] = std::move(clients_.back());
+        clients_.pop_back();
+      } else {
+        ++c;
+      }
+    }
+
+    // Each client is read on its own thread so slow clients don't hold up
+    // the batches of others
+    Client client;
+    client.connection = std::make_shared<Connection>(fd);
+    client.thread = std::thread(&FlagService::readClient, this, client.connection);
+    clients_.push_back(std::move(client));
+  }
+
+  // Shutting a connection down ends its blocked recv, so every reader stops
+  // before the service can be destroyed. Replies still queued hold their own
+  // reference to the connection and fail quietly.
+  for (Client& client : clients_) {
+    shutdown(client.connection->fd, SHUT_RDWR);
+    client.thread.join();
+  }
+  clients_.clear();
+
+  close(listener);
+  unlink(path.c_str());
+  return true;
+}
+#endif
+
+/**
+ * @brief Constructor for a client that is being read
+ *
+ * @param client_fd accepted socket, closed by the destructor
+ */
+FlagService::Connection::Connection(int client_fd) : fd(client_fd), reading(true) {}
+
+/**
+ * @brief Destructor closes the socket once nothing refers to the client
+ */
+FlagService::Connection::~Connection() {
+#ifndef _WIN32
+  close(fd);
+#endif
+}
+
+/**
+ * @brief Reads framed requests from a socket client until it stops
+ *        sending or the connection is shut down
+ *
+ * @param connection client to read from
+ */
+void FlagService::readClient(std::shared_ptr<Connection> connection) {
+#ifndef _WIN32
+  int64_t id = 0;
+  unsigned char header[4];
+  std::vector<uchar> encoded;
+  while (recv(connection->fd, header, sizeof(header), MSG_WAITALL) == (ssize_t)sizeof(header)) {
+    uint32_t length = decodeLength(header);
+    if (length == 0 || length > kMaxFrameBytes) {
+      break;
+    }
+    encoded.resize(length);
+    if (recv(connection->fd, encoded.data(), length, MSG_WAITALL) != (ssize_t)length) {
+      break;
+    }
+    bool queued = submit(id++, encoded, [connection](const std::string& response) {
+      std::lock_guard<std::mutex> lock(connection->write_mutex);
+      std::string line = response + "\n";
+      send(connection->fd, line.data(), line.size(), MSG_NOSIGNAL);
+    });
+    if (!queued) {
+      break;
+    }
+  }
+  shutdown(connection->fd, SHUT_RD);
+#endif
+  connection->reading = false;
+}
+
+/**
+ * @brief Reads the next framed request from a stream
+ *
+ * @param in stream of framed requests
+ * @param encoded bytes of the image file
+ * @return false at the end of the stream or a zero length frame
+ */
+bool FlagService::readFrame(std::istream& in, std::vector<uchar>& encoded) {
+  unsigned char header[4];
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+    return false;
+  }
+  uint32_t length = decodeLength(header);
+  if (length == 0 || length > kMaxFrameBytes) {
+    return false;
+  }
+  encoded.resize(length);
+  return (bool)in.read(reinterpret_cast<char*>(encoded.data()), length);
+}
+
+/**
+ * @brief Waits for each batch to fill and searches it until stopped
+ */
+void FlagService::batchLoop() {
+  std::vector<Request> batch;
+  std::vector<std::vector<uchar>> buffers;
+  std::vector<FlagResult> results;
+  Clock::time_point last_dump = Clock::now();
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        if (metrics_ != nullptr) {
+          metrics_->writeFile(metrics_path_);
+        }
+        return;
+      }
+
+      // Give the batch until the oldest request's deadline to fill
+      Clock::time_point deadline = pending_.front().arrival + max_wait_;
+      ready_.wait_until(lock, deadline, [this] { return stopping_ || pending_.size() >= batch_size_; });
+
+      batch.clear();
+      while (!pending_.empty() && batch.size() < batch_size_) {
+        batch.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+    }
+
+    Clock::time_point start = Clock::now();
+    buffers.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      buffers[i].swap(batch[i].encoded);
+    }
+
+    // The whole batch is searched and reported on one snapshot, which stays
+    // alive until the responses are formatted even if the flags change
+    std::shared_ptr<const IndexSnapshot> snapshot = catalog_.acquire();
+    engine_.setFinder(*snapshot->finder);
+    engine_.run(buffers, results);
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      double queue_ms = std::chrono::duration<double, std::milli>(start - batch[i].arrival).count();
+      batch[i].reply(formatResponse(snapshot->index, batch[i].id, results[i], queue_ms, (int)batch.size()));
+    }
+
+    // Dumps are throttled so writing them never shows up in latency
+    if (metrics_ != nullptr && Clock::now() - last_dump >= std::chrono::seconds(1)) {
+      metrics_->writeFile(metrics_path_);
+      last_dump = Clock::now();
+    }
+  }
+}
+
+/**
+ * @brief Formats the response to one request
+ *
+ * @param index flag metadata of the snapshot the request was searched on
+ * @param id number of the request
+ * @param result result of the search
+ * @param queue_ms milliseconds the request waited for its batch
+ * @param batch_size number of requests searched with it
+ * @return one line of JSON without the newline
+ */
+std::string FlagService::formatResponse(const FlagIndex& index, int64_t id, const FlagResult& result, double queue_ms,
+                                        int batch_size) const {
+  double search_ms = 0.0;
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    if (result.stage_ms[stage] >= 0.0) {
+      search_ms += result.stage_ms[stage];
+    }
+  }
+
+  // Each flag left by the filters is equally likely, ranked flags come
+  // with their own chances
+  double confidence = result.flags.empty() ? 0.0 : 1.0 / result.flags.size();
+  if (!result.confidences.empty()) {
+    confidence = result.confidences.front();
+  }
+
+  std::ostringstream out;
+  out << "{ \"id\": " << id << ", \"decoded\": " << (result.decoded ? "true" : "false") << ", \"flags\": [";
+  for (size_t i = 0; i < result.flags.size(); ++i) {
+    out << (i > 0 ? ", " : "") << "\"" << escapeJson(index.getName(result.flags[i])) << "\"";
+  }
+  out << "]";
+  if (!result.neighbors.empty()) {
+    out << ", \"distances\": [";
+    for (size_t i = 0; i < result.neighbors.size(); ++i) {
+      out << (i > 0 ? ", " : "") << result.neighbors[i].distance;
+    }
+    out << "]";
+  }
+  if (!result.confidences.empty()) {
+    out << ", \"confidences\": [";
+    for (size_t i = 0; i < result.confidences.size(); ++i) {
+      out << (i > 0 ? ", " : "") << result.confidences[i];
+    }
+    out << "]";
+  }
+  out << ", \"deciding_stage\": \"" << (result.decoded ? getStageName(result.deciding_stage) : "Unreadable")
+      << "\", \"confidence\": " << confidence << ", \"queue_ms\": " << queue_ms << ", \"search_ms\": " << search_ms
+      << ", \"batch_size\": " << batch_size << " }";
+  return out.str();
+}
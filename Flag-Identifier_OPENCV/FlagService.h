@@ -0,0 +1,211 @@
+/*********************************************************************
+ * @file       FlagService.h
+ * @brief      FlagService keeps the flag index loaded and answers a stream
+ *              of encoded test images, grouping requests that arrive close
+ *              together into one batch for the BatchQueryEngine.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BatchQueryEngine.h"
+#include "FlagCatalog.h"
+#include "FlagFinder.h"
+#include "FlagIndex.h"
+#include "FlagMetrics.h"
+
+using namespace cv;
+
+/**
+ * @class FlagService collects requests from any number of threads. A batch
+ *        is started once batch size requests are waiting or the oldest
+ *        request has waited the max wait time, whichever comes first. Each
+ *        request is answered with one line of JSON.
+ *
+ *        Requests are framed the same way on stdin and on a socket: a 4 byte
+ *        little endian length followed by that many bytes of an image file.
+ *        A length of 0 ends the stream.
+ *
+ *        Each batch is searched on the snapshot of the catalog that was
+ *        current when it started, so flags can be changed while serving.
+ */
+class FlagService {
+  public:
+
+  // Receives the JSON line answering one request, called on the batch thread
+  typedef std::function<void(const std::string&)> Reply;
+
+  /**
+   * @brief Constructor starts the batch thread and the query workers
+   *
+   * @param catalog flags to search, read again for every batch
+   * @param num_threads number of query workers, 0 for one per core
+   * @param batch_size most requests searched in one batch, at least 1
+   * @param max_wait_ms longest a request waits for its batch to fill
+   */
+  FlagService(const FlagCatalog& catalog, int num_threads, int batch_size, int max_wait_ms);
+
+  /**
+   * @brief Destructor answers every waiting request and stops the threads
+   */
+  ~FlagService();
+
+  /**
+   * @brief Setter for a metrics file rewritten at most once a second while
+   *        batches are searched, and once more when the service stops
+   *
+   * @param metrics counters the finder records into
+   * @param path file to write, see FlagMetrics::writeFile
+   */
+  void setMetricsFile(const FlagMetrics* metrics, const std::string& path);
+
+  /**
+   * @brief Queues an encoded image to be searched in the next batch
+   *
+   * @param id number echoed in the response
+   * @param encoded bytes of the image file, moved from
+   * @param reply called with the response once the batch is searched
+   * @return false if the service is stopping, in which case the request is
+   *         not queued and reply is never called
+   */
+  bool submit(int64_t id, std::vector<uchar>& encoded, Reply reply);
+
+  /**
+   * @brief Answers framed requests read from a stream, writing one JSON line
+   *        per request to out. Returns after the stream ends and every
+   *        request has been answered.
+   *
+   * @param in stream of framed requests, opened in binary mode
+   * @param out stream the responses are written to
+   * @return number of requests answered
+   */
+  int64_t serveStream(std::istream& in, std::ostream& out);
+
+  /**
+   * @brief Answers framed requests from every client of a Unix domain socket.
+   *        Each client gets the responses to its own requests, numbered from
+   *        0 on each connection. Runs until the socket fails, then shuts
+   *        down every connection and waits for its reader thread, so no
+   *        request is submitted after it returns.
+   *
+   * @param path file name of the socket, replaced if it exists
+   * @return false if the socket could not be opened or isn't supported
+   */
+  bool serveSocket(const std::string& path);
+
+  /**
+   * @brief Reads the next framed request from a stream
+   *
+   * @param in stream of framed requests
+   * @param encoded bytes of the image file
+   * @return false at the end of the stream or a zero length frame
+   */
+  static bool readFrame(std::istream& in, std::vector<uchar>& encoded);
+
+  private:
+
+  // Copying would share the batch thread
+  FlagService(const FlagService&);
+  FlagService& operator=(const FlagService&);
+
+  /**
+   * @brief Request is one image waiting for its batch
+   */
+  struct Request {
+    int64_t id;
+    std::vector<uchar> encoded;
+    Reply reply;
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  /**
+   * @brief Connection is one socket client, closed once the client has
+   *        stopped sending and every reply to it has been written
+   */
+  struct Connection {
+    int fd;
+    std::mutex write_mutex;
+
+    // Cleared by the reader thread when it stops reading requests
+    std::atomic<bool> reading;
+
+    Connection(int client_fd);
+    ~Connection();
+  };
+
+  /**
+   * @brief Client is the reader thread of a connection
+   */
+  struct Client {
+    std::thread thread;
+    std::shared_ptr<Connection> connection;
+  };
+
+  /**
+   * @brief Reads framed requests from a socket client until it stops
+   *        sending or the connection is shut down
+   *
+   * @param connection client to read from
+   */
+  void readClient(std::shared_ptr<Connection> connection);
+
+  /**
+   * @brief Waits for each batch to fill and searches it until stopped
+   */
+  void batchLoop();
+
+  /**
+   * @brief Formats the response to one request
+   *
+   * @param index flag metadata of the snapshot the request was searched on
+   * @param id number of the request
+   * @param result result of the search
+   * @param queue_ms milliseconds the request waited for its batch
+   * @param batch_size number of requests searched with it
+   * @return one line of JSON without the newline
+   */
+  std::string formatResponse(const FlagIndex& index, int64_t id, const FlagResult& result, double queue_ms,
+                             int batch_size) const;
+
+  const FlagCatalog& catalog_;
+  BatchQueryEngine engine_;
+
+  // Batch limits
+  size_t batch_size_;
+  std::chrono::milliseconds max_wait_;
+
+  // Requests waiting for a batch, guarded by mutex_
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<Request> pending_;
+  bool stopping_;
+
+  std::thread batch_thread_;
+
+  // Reader threads of the socket clients, only touched by serveSocket
+  std::vector<Client> clients_;
+
+  // Metrics written by the batch thread, set before requests are submitted
+  const FlagMetrics* metrics_;
+  std::string metrics_path_;
+};
@@ -0,0 +1,51 @@
+/*********************************************************************
+ * @file       FlagStage.cpp
+ * @brief      FlagStage names the steps of findFlag, shared by the finder,
+ *              the cascade plan and everything that reports on a search.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FlagStage.h"
+
+/**
+ * @brief Returns the printable name of a step of findFlag
+ *
+ * @param stage step to name
+ * @return name of the step
+ */
+const char* getStageName(FlagStage stage) {
+  switch (stage) {
+    case kStageDecode:
+      return "Decode";
+    case kStageColorBucket:
+      return "Color Bucket";
+    case kStageMcc:
+      return "MCC filter";
+    case kStageMccRatio:
+      return "MCC Ratio Filter";
+    case kStageResize:
+      return "Resize";
+    case kStageCanny:
+      return "Canny Edge Filter";
+    case kStageQuadrant:
+      return "Upper Left Quadrant modular filter";
+    case kStageNearest:
+      return "Nearest Neighbor Search";
+    case kStageScoreColor:
+      return "Color Score";
+    case kStageScoreLayout:
+      return "Layout Score";
+    case kStageScoreEdges:
+      return "Edge Score";
+    case kStageFrameReuse:
+      return "Previous Frame";
+    default:
+      return "Unknown";
+  }
+}
@@ -0,0 +1,52 @@
+/*********************************************************************
+ * @file       FlagStage.h
+ * @brief      FlagStage names the steps of findFlag, shared by the finder,
+ *              the cascade plan and everything that reports on a search.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+/**
+ * @brief Steps of findFlag, in the order they run by default
+ */
+enum FlagStage {
+  kStageDecode = 0,
+  kStageColorBucket,
+  kStageMcc,
+
+  // Filters after the MCC filter, run in the order of the cascade plan
+  kStageMccRatio,
+  kStageResize,
+  kStageCanny,
+  kStageQuadrant,
+
+  // Replaces the filters after resize when the finder searches by nearest
+  // neighbors instead
+  kStageNearest,
+
+  // Replace the filters when the finder ranks flags by combined distance
+  // instead, cheapest first. Resize runs before the edge stage.
+  kStageScoreColor,
+  kStageScoreLayout,
+  kStageScoreEdges,
+
+  // Replaces every step after the color histogram when a video frame
+  // barely changed since the last frame searched, see FrameStream
+  kStageFrameReuse,
+  kNumStages
+};
+
+/**
+ * @brief Returns the printable name of a step of findFlag
+ *
+ * @param stage step to name
+ * @return name of the step
+ */
+const char* getStageName(FlagStage stage);
@@ -0,0 +1,176 @@
+/*********************************************************************
+ * @file       FrameStream.cpp
+ * @brief      FrameStream reads a video, camera or numbered image sequence
+ *              and finds the flag in every frame, reusing the last answer
+ *              while the scene stays the same.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "FrameStream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include "CommonColorFinder.h"
+#include "FlagMetrics.h"
+
+// Number of buckets in an 8x8x8 histogram
+static const int kHistogramBins = 8 * 8 * 8;
+
+const double FrameStream::kDefaultChangeThreshold = 0.1;
+const int FrameStream::kDefaultRefreshFrames = 30;
+
+/**
+ * @brief Constructor for a stream with no source open
+ *
+ * @param finder finder to search the changed frames with, must outlive
+ *        the stream
+ * @param change_threshold share of pixels, from 0 to 1, that have to
+ *        change color bucket for a frame to be searched, 0 to search
+ *        every frame
+ * @param refresh_frames frames a result is reused for at most
+ */
+FrameStream::FrameStream(const FlagFinder& finder, double change_threshold, int refresh_frames)
+  : finder_(finder), change_threshold_(change_threshold), refresh_frames_(std::max(refresh_frames, 1)),
+    frames_since_key_(0), frame_count_(0), search_count_(0) {}
+
+/**
+ * @brief Opens a video file, a numbered image sequence such as
+ *        "frames/%04d.png", or a camera when the source is a number
+ *
+ * @param source file, sequence pattern or camera number
+ * @return true if the source could be opened
+ */
+bool FrameStream::open(const std::string& source) {
+  key_histogram_.release();
+  frames_since_key_ = 0;
+  frame_count_ = 0;
+  search_count_ = 0;
+  if (!source.empty() && std::all_of(source.begin(), source.end(), ::isdigit)) {
+    return capture_.open(atoi(source.c_str()));
+  }
+  return capture_.open(source);
+}
+
+/**
+ * @brief Reads the next frame and finds the flag in it, or reuses the
+ *        result of the last searched frame if the scene barely changed
+ *
+ * @param result result to fill, reset first. A reused result has
+ *        kStageFrameReuse as its deciding step.
+ * @return false once there are no more frames
+ */
+bool FrameStream::next(FlagResult& result) {
+  result.reset();
+  Mat& frame = scratch_.test_file;
+  {
+    StageTimer timer(result, kStageDecode);
+    if (!capture_.isOpened() || !capture_.read(frame)) {
+      frame.release();
+    }
+  }
+  if (frame.empty()) {
+    return false;
+  }
+  ++frame_count_;
+
+  // The histogram is the first step of the filters either way
+  Mat& histogram = scratch_.arena.histogram;
+  {
+    StageTimer timer(result, kStageColorBucket);
+    CommonColorFinder::populateHistogram(frame, histogram);
+  }
+
+  // Same scene, keep the flags of the last searched frame
+  if (!key_histogram_.empty() && frames_since_key_ < refresh_frames_) {
+    double change;
+    {
+      StageTimer timer(result, kStageFrameReuse);
+      change = getChange(histogram);
+    }
+    if (change < change_threshold_) {
+      ++frames_since_key_;
+      result.decoded = true;
+      result.deciding_stage = kStageFrameReuse;
+      result.flags = key_result_.flags;
+      result.image_bucket = key_result_.image_bucket;
+      result.neighbors = key_result_.neighbors;
+      result.confidences = key_result_.confidences;
+      result.candidates_in[kStageFrameReuse] = (int)key_result_.flags.size();
+      result.candidates_out[kStageFrameReuse] = (int)key_result_.flags.size();
+      result.filter_order.push_back(kStageFrameReuse);
+      return true;
+    }
+  }
+
+  // The filters reuse the histogram slot, so it is kept first
+  histogram.copyTo(key_histogram_);
+  finder_.findCounted(frame, result, scratch_);
+  key_result_ = result;
+  frames_since_key_ = 0;
+  ++search_count_;
+  return true;
+}
+
+/**
+ * @brief Getter for the frame last read
+ *
+ * @return decoded frame, empty before the first read
+ */
+const Mat& FrameStream::getFrame() const {
+  return scratch_.test_file;
+}
+
+/**
+ * @brief Getter for the number of frames read
+ *
+ * @return frames read since open
+ */
+int64_t FrameStream::getFrameCount() const {
+  return frame_count_;
+}
+
+/**
+ * @brief Getter for the number of frames the filters ran for
+ *
+ * @return frames searched since open
+ */
+int64_t FrameStream::getSearchCount() const {
+  return search_count_;
+}
+
+/**
+ * @brief Returns the share of pixels in a different color bucket than in
+ *        the last searched frame, half the L1 distance of the normalized
+ *        histograms
+ *
+ * @param histogram histogram of the current frame
+ * @return share from 0 (same colors) to 1 (no color in common)
+ */
+double FrameStream::getChange(const Mat& histogram) const {
+  const int* counts = histogram.ptr<int>();
+  const int* key_counts = key_histogram_.ptr<int>();
+  double total = 0.0;
+  double key_total = 0.0;
+  for (int i = 0; i < kHistogramBins; ++i) {
+    total += counts[i];
+    key_total += key_counts[i];
+  }
+  if (total <= 0.0 || key_total <= 0.0) {
+    return 1.0;
+  }
+
+  double distance = 0.0;
+  for (int i = 0; i < kHistogramBins; ++i) {
+    distance += std::abs(counts[i] / total - key_counts[i] / key_total);
+  }
+  return distance / 2.0;
+}
@@ -0,0 +1,132 @@
+/*********************************************************************
+ * @file       FrameStream.h
+ * @brief      FrameStream reads a video, camera or numbered image sequence
+ *              and finds the flag in every frame, reusing the last answer
+ *              while the scene stays the same.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <cstdint>
+#include <string>
+
+#include "FlagFinder.h"
+
+using namespace cv;
+
+/**
+ * @class FrameStream finds the flag in each frame of a VideoCapture. The
+ *        color histogram of every frame is counted, since it is the first
+ *        step of findFlag anyway, and compared with the histogram of the
+ *        last frame that was searched. While less than the change threshold
+ *        of the pixels moved to another color bucket, the frame keeps the
+ *        flags found for that frame and the filters don't run. Frames are
+ *        always compared with the last searched frame, not the one before,
+ *        so a slow drift still triggers a search once it adds up.
+ */
+class FrameStream {
+  public:
+
+  // Share of pixels that have to change color bucket for a new search. Two
+  // different state flags are closer than this less than 1 time in 500.
+  static const double kDefaultChangeThreshold;
+
+  // Frames a result is reused for at most before the frame is searched
+  // again anyway
+  static const int kDefaultRefreshFrames;
+
+  /**
+   * @brief Constructor for a stream with no source open
+   *
+   * @param finder finder to search the changed frames with, must outlive
+   *        the stream
+   * @param change_threshold share of pixels, from 0 to 1, that have to
+   *        change color bucket for a frame to be searched, 0 to search
+   *        every frame
+   * @param refresh_frames frames a result is reused for at most
+   */
+  FrameStream(const FlagFinder& finder, double change_threshold, int refresh_frames);
+
+  /**
+   * @brief Opens a video file, a numbered image sequence such as
+   *        "frames/%04d.png", or a camera when the source is a number
+   *
+   * @param source file, sequence pattern or camera number
+   * @return true if the source could be opened
+   */
+  bool open(const std::string& source);
+
+  /**
+   * @brief Reads the next frame and finds the flag in it, or reuses the
+   *        result of the last searched frame if the scene barely changed
+   *
+   * @param result result to fill, reset first. A reused result has
+   *        kStageFrameReuse as its deciding step.
+   * @return false once there are no more frames
+   */
+  bool next(FlagResult& result);
+
+  /**
+   * @brief Getter for the frame last read
+   *
+   * @return decoded frame, empty before the first read
+   */
+  const Mat& getFrame() const;
+
+  /**
+   * @brief Getter for the number of frames read
+   *
+   * @return frames read since open
+   */
+  int64_t getFrameCount() const;
+
+  /**
+   * @brief Getter for the number of frames the filters ran for
+   *
+   * @return frames searched since open
+   */
+  int64_t getSearchCount() const;
+
+  private:
+
+  // Copying would share the capture
+  FrameStream(const FrameStream&);
+  FrameStream& operator=(const FrameStream&);
+
+  /**
+   * @brief Returns the share of pixels in a different color bucket than in
+   *        the last searched frame, half the L1 distance of the normalized
+   *        histograms
+   *
+   * @param histogram histogram of the current frame
+   * @return share from 0 (same colors) to 1 (no color in common)
+   */
+  double getChange(const Mat& histogram) const;
+
+  const FlagFinder& finder_;
+  double change_threshold_;
+  int refresh_frames_;
+
+  VideoCapture capture_;
+
+  // Buffers of the one thread reading the stream
+  FlagScratch scratch_;
+
+  // Histogram and result of the last searched frame, empty before the
+  // first search
+  Mat key_histogram_;
+  FlagResult key_result_;
+  int frames_since_key_;
+
+  int64_t frame_count_;
+  int64_t search_count_;
+};
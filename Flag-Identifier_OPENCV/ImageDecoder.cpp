@@ -0,0 +1,165 @@
+/*********************************************************************
+ * @file       ImageDecoder.cpp
+ * @brief      ImageDecoder reads test images, decoding large jpg files
+ *              straight to a reduced size near the working size of the
+ *              filters.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "ImageDecoder.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <fstream>
+
+#include "EdgeRatioFinder.h"
+
+/**
+ * @brief Default constructor is private and doesn't allow calling
+ */
+ImageDecoder::ImageDecoder() {
+  // Do nothing
+}
+
+/**
+ * @brief Reads every byte of a file
+ *
+ * @param filename file to read
+ * @param encoded bytes of the file
+ * @return false if the file couldn't be read
+ */
+bool ImageDecoder::readFile(const std::string& filename, std::vector<uchar>& encoded) {
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in) {
+    encoded.clear();
+    return false;
+  }
+  std::streamoff size = in.tellg();
+  in.seekg(0, std::ios::beg);
+  encoded.resize((size_t)std::max<std::streamoff>(size, 0));
+  if (!encoded.empty() && !in.read((char*)encoded.data(), (std::streamsize)encoded.size())) {
+    encoded.clear();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the size of a jpg from its frame header without decoding it
+ *
+ * @param encoded bytes of an image file
+ * @param rows rows of the image
+ * @param cols columns of the image
+ * @return false if the bytes aren't a jpg or have no frame header
+ */
+bool ImageDecoder::readJpegSize(const std::vector<uchar>& encoded, int& rows, int& cols) {
+  const size_t size = encoded.size();
+  if (size < 4 || encoded[0] != 0xFF || encoded[1] != 0xD8) {
+    return false;
+  }
+
+  // Walk the segments after the start of image marker until a frame header
+  size_t position = 2;
+  while (position + 4 <= size) {
+    if (encoded[position] != 0xFF) {
+      return false;
+    }
+
+    // Any number of 0xFF may pad a marker
+    uchar marker = encoded[position + 1];
+    if (marker == 0xFF) {
+      ++position;
+      continue;
+    }
+    position += 2;
+
+    // Markers without a segment
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      continue;
+    }
+
+    // Scan data or end of image before any frame header
+    if (marker == 0xDA || marker == 0xD9) {
+      return false;
+    }
+
+    size_t length = ((size_t)encoded[position] << 8) | encoded[position + 1];
+    if (length < 2 || position + length > size) {
+      return false;
+    }
+
+    // Frame headers are 0xC0 to 0xCF except DHT, JPG and DAC: length,
+    // precision, rows, columns
+    bool frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+    if (frame) {
+      if (length < 7) {
+        return false;
+      }
+      rows = (encoded[position + 3] << 8) | encoded[position + 4];
+      cols = (encoded[position + 5] << 8) | encoded[position + 6];
+      return rows > 0 && cols > 0;
+    }
+    position += length;
+  }
+  return false;
+}
+
+/**
+ * @brief Returns the imdecode mode of the smallest jpg scale that keeps
+ *        the shorter side at least EdgeRatioFinder::kWorkingRows. The
+ *        shorter side is used since the EXIF orientation may swap rows and
+ *        columns.
+ *
+ * @param rows rows of the image
+ * @param cols columns of the image
+ * @return IMREAD_REDUCED_COLOR_8, _4, _2 or IMREAD_COLOR
+ */
+int ImageDecoder::getReducedMode(int rows, int cols) {
+
+  // A scaled jpg decode rounds up, so shorter / scale rows are always kept
+  int shorter = std::min(rows, cols);
+  if (shorter >= 8 * EdgeRatioFinder::kWorkingRows) {
+    return IMREAD_REDUCED_COLOR_8;
+  }
+  if (shorter >= 4 * EdgeRatioFinder::kWorkingRows) {
+    return IMREAD_REDUCED_COLOR_4;
+  }
+  if (shorter >= 2 * EdgeRatioFinder::kWorkingRows) {
+    return IMREAD_REDUCED_COLOR_2;
+  }
+  return IMREAD_COLOR;
+}
+
+/**
+ * @brief Decodes an encoded image to BGR
+ *
+ * @param encoded bytes of an image file
+ * @param reduced true to decode a jpg at the scale getReducedMode picks
+ * @param image decoded image, empty if it couldn't be decoded. Its memory
+ *        is reused when the new image has the same size.
+ */
+void ImageDecoder::decode(const std::vector<uchar>& encoded, bool reduced, Mat& image) {
+  if (encoded.empty()) {
+    image.release();
+    return;
+  }
+
+  // Without a jpg frame header there may be no decoder at all, and imdecode
+  // leaves the old image in place when it finds none, so decode fresh
+  int rows = 0;
+  int cols = 0;
+  if (!readJpegSize(encoded, rows, cols)) {
+    image = imdecode(encoded, IMREAD_COLOR);
+    return;
+  }
+
+  // Decoding into the old image keeps its memory when the size is the same
+  int mode = reduced ? getReducedMode(rows, cols) : IMREAD_COLOR;
+  imdecode(encoded, mode, &image);
+}
@@ -0,0 +1,81 @@
+/*********************************************************************
+ * @file       ImageDecoder.h
+ * @brief      ImageDecoder reads test images, decoding large jpg files
+ *              straight to a reduced size near the working size of the
+ *              filters.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+using namespace cv;
+
+/**
+ * @class ImageDecoder is a helper class that picks the imdecode mode for an
+ *        encoded image. A jpg can be decoded at 1/2, 1/4 or 1/8 of its size
+ *        for much less work than a full decode, so the size in its header
+ *        picks the smallest scale that still has at least
+ *        EdgeRatioFinder::kWorkingRows on its shorter side. Other formats are
+ *        always decoded at full size.
+ */
+class ImageDecoder {
+  public:
+
+  /**
+   * @brief Reads every byte of a file
+   *
+   * @param filename file to read
+   * @param encoded bytes of the file
+   * @return false if the file couldn't be read
+   */
+  static bool readFile(const std::string& filename, std::vector<uchar>& encoded);
+
+  /**
+   * @brief Reads the size of a jpg from its frame header without decoding it
+   *
+   * @param encoded bytes of an image file
+   * @param rows rows of the image
+   * @param cols columns of the image
+   * @return false if the bytes aren't a jpg or have no frame header
+   */
+  static bool readJpegSize(const std::vector<uchar>& encoded, int& rows, int& cols);
+
+  /**
+   * @brief Returns the imdecode mode of the smallest jpg scale that keeps
+   *        the shorter side at least EdgeRatioFinder::kWorkingRows. The
+   *        shorter side is used since the EXIF orientation may swap rows and
+   *        columns.
+   *
+   * @param rows rows of the image
+   * @param cols columns of the image
+   * @return IMREAD_REDUCED_COLOR_8, _4, _2 or IMREAD_COLOR
+   */
+  static int getReducedMode(int rows, int cols);
+
+  /**
+   * @brief Decodes an encoded image to BGR
+   *
+   * @param encoded bytes of an image file
+   * @param reduced true to decode a jpg at the scale getReducedMode picks
+   * @param image decoded image, empty if it couldn't be decoded. Its memory
+   *        is reused when the new image has the same size.
+   */
+  static void decode(const std::vector<uchar>& encoded, bool reduced, Mat& image);
+
+  private:
+
+  /**
+   * @brief Default constructor is private and doesn't allow calling
+   */
+  ImageDecoder();
+};
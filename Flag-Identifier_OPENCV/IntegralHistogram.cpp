@@ -0,0 +1,163 @@
+/*********************************************************************
+ * @file       IntegralHistogram.cpp
+ * @brief      IntegralHistogram gives the 8x8x8 color histogram of any
+ *              rectangle of cells of an image in constant time.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "IntegralHistogram.h"
+
+#include <algorithm>
+
+#include "ColorQuantizer.h"
+
+/**
+ * @brief Constructor creates a histogram of no cells
+ */
+IntegralHistogram::IntegralHistogram() : rows_(0), cols_(0), cell_size_(1), image_rows_(0), image_cols_(0) {}
+
+/**
+ * @brief Counts the cells of an image and sums them into corner
+ *        histograms. Memory is only allocated when the grid grows.
+ *
+ * @param image BGR image to count
+ * @param cell_size width and height of a cell in pixels, the last row
+ *        and column of cells can be smaller
+ */
+void IntegralHistogram::build(const Mat& image, int cell_size) {
+  cell_size_ = std::max(cell_size, 1);
+  image_rows_ = image.rows;
+  image_cols_ = image.cols;
+  rows_ = (image.rows + cell_size_ - 1) / cell_size_;
+  cols_ = (image.cols + cell_size_ - 1) / cell_size_;
+  corners_.resize((size_t)(rows_ + 1) * (cols_ + 1) * kNumBins);
+  row_cells_.resize((size_t)cols_ * kNumBins);
+  row_sum_.resize(kNumBins);
+
+  // Top row of corners has nothing above it
+  std::fill(corners_.begin(), corners_.begin() + (size_t)(cols_ + 1) * kNumBins, 0);
+
+  for (int cell_row = 0; cell_row < rows_; ++cell_row) {
+
+    // Count every pixel of the band of cells into its cell
+    std::fill(row_cells_.begin(), row_cells_.end(), 0);
+    int last_row = std::min((cell_row + 1) * cell_size_, image.rows);
+    for (int row = cell_row * cell_size_; row < last_row; ++row) {
+      const uchar* pixel = image.ptr<uchar>(row);
+      for (int col = 0; col < image.cols; ++col) {
+        const uchar* bgr = pixel + col * 3;
+        int bin = ColorQuantizer::getBin(bgr[0], bgr[1], bgr[2]);
+        ++row_cells_[(size_t)(col / cell_size_) * kNumBins + bin];
+      }
+    }
+
+    // Each corner is the corner above it plus the band up to its column
+    std::fill(row_sum_.begin(), row_sum_.end(), 0);
+    int* corner = &corners_[(size_t)(cell_row + 1) * (cols_ + 1) * kNumBins];
+    const int* above = &corners_[(size_t)cell_row * (cols_ + 1) * kNumBins];
+    std::fill(corner, corner + kNumBins, 0);
+    for (int cell_col = 0; cell_col < cols_; ++cell_col) {
+      const int* cell = &row_cells_[(size_t)cell_col * kNumBins];
+      int* next = corner + (size_t)(cell_col + 1) * kNumBins;
+      const int* next_above = above + (size_t)(cell_col + 1) * kNumBins;
+      for (int bin = 0; bin < kNumBins; ++bin) {
+        row_sum_[bin] += cell[bin];
+        next[bin] = next_above[bin] + row_sum_[bin];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Getter for the rows of cells
+ *
+ * @return number of cells down the image
+ */
+int IntegralHistogram::getRows() const {
+  return rows_;
+}
+
+/**
+ * @brief Getter for the columns of cells
+ *
+ * @return number of cells across the image
+ */
+int IntegralHistogram::getCols() const {
+  return cols_;
+}
+
+/**
+ * @brief Getter for the size of a cell
+ *
+ * @return width and height of a cell in pixels
+ */
+int IntegralHistogram::getCellSize() const {
+  return cell_size_;
+}
+
+/**
+ * @brief Returns how many pixels of a rectangle of cells fall in a bucket
+ *
+ * @param row first row of cells
+ * @param col first column of cells
+ * @param rows rows of cells, at least 1
+ * @param cols columns of cells, at least 1
+ * @param bin bucket, see ColorQuantizer::getBin
+ * @return pixel count of the bucket
+ */
+int IntegralHistogram::getCount(int row, int col, int rows, int cols, int bin) const {
+  return getCorner(row + rows, col + cols)[bin] - getCorner(row, col + cols)[bin] -
+    getCorner(row + rows, col)[bin] + getCorner(row, col)[bin];
+}
+
+/**
+ * @brief Fills the whole histogram of a rectangle of cells
+ *
+ * @param row first row of cells
+ * @param col first column of cells
+ * @param rows rows of cells, at least 1
+ * @param cols columns of cells, at least 1
+ * @param histogram kNumBins counts to fill
+ */
+void IntegralHistogram::getHistogram(int row, int col, int rows, int cols, int* histogram) const {
+  const int* bottom_right = getCorner(row + rows, col + cols);
+  const int* top_right = getCorner(row, col + cols);
+  const int* bottom_left = getCorner(row + rows, col);
+  const int* top_left = getCorner(row, col);
+  for (int bin = 0; bin < kNumBins; ++bin) {
+    histogram[bin] = bottom_right[bin] - top_right[bin] - bottom_left[bin] + top_left[bin];
+  }
+}
+
+/**
+ * @brief Returns the number of pixels in a rectangle of cells
+ *
+ * @param row first row of cells
+ * @param col first column of cells
+ * @param rows rows of cells, at least 1
+ * @param cols columns of cells, at least 1
+ * @return pixels in the rectangle, less than a full cell each for the
+ *         cells on the bottom and right edges of the image
+ */
+int IntegralHistogram::getPixelCount(int row, int col, int rows, int cols) const {
+  int height = std::min((row + rows) * cell_size_, image_rows_) - row * cell_size_;
+  int width = std::min((col + cols) * cell_size_, image_cols_) - col * cell_size_;
+  return height * width;
+}
+
+/**
+ * @brief Returns the corner histogram above and left of a cell corner
+ *
+ * @param row corner row, 0 to getRows()
+ * @param col corner column, 0 to getCols()
+ * @return kNumBins counts
+ */
+const int* IntegralHistogram::getCorner(int row, int col) const {
+  return &corners_[((size_t)row * (cols_ + 1) + col) * kNumBins];
+}
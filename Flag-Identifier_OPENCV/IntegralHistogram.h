@@ -0,0 +1,133 @@
+/*********************************************************************
+ * @file       IntegralHistogram.h
+ * @brief      IntegralHistogram gives the 8x8x8 color histogram of any
+ *              rectangle of cells of an image in constant time.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+using namespace cv;
+
+/**
+ * @class IntegralHistogram splits an image into square cells and keeps,
+ *        for every cell corner, the histogram of everything above and to
+ *        the left of it, in the bucket layout of
+ *        CommonColorFinder::populateHistogram. The count of a bucket in any
+ *        rectangle of cells is then four lookups. Keeping a histogram per
+ *        pixel would take 2 KB a pixel, so rectangles are whole cells.
+ */
+class IntegralHistogram {
+  public:
+
+  // Number of buckets in an 8x8x8 histogram
+  static const int kNumBins = 8 * 8 * 8;
+
+  /**
+   * @brief Constructor creates a histogram of no cells
+   */
+  IntegralHistogram();
+
+  /**
+   * @brief Counts the cells of an image and sums them into corner
+   *        histograms. Memory is only allocated when the grid grows.
+   *
+   * @param image BGR image to count
+   * @param cell_size width and height of a cell in pixels, the last row
+   *        and column of cells can be smaller
+   */
+  void build(const Mat& image, int cell_size);
+
+  /**
+   * @brief Getter for the rows of cells
+   *
+   * @return number of cells down the image
+   */
+  int getRows() const;
+
+  /**
+   * @brief Getter for the columns of cells
+   *
+   * @return number of cells across the image
+   */
+  int getCols() const;
+
+  /**
+   * @brief Getter for the size of a cell
+   *
+   * @return width and height of a cell in pixels
+   */
+  int getCellSize() const;
+
+  /**
+   * @brief Returns how many pixels of a rectangle of cells fall in a bucket
+   *
+   * @param row first row of cells
+   * @param col first column of cells
+   * @param rows rows of cells, at least 1
+   * @param cols columns of cells, at least 1
+   * @param bin bucket, see ColorQuantizer::getBin
+   * @return pixel count of the bucket
+   */
+  int getCount(int row, int col, int rows, int cols, int bin) const;
+
+  /**
+   * @brief Fills the whole histogram of a rectangle of cells
+   *
+   * @param row first row of cells
+   * @param col first column of cells
+   * @param rows rows of cells, at least 1
+   * @param cols columns of cells, at least 1
+   * @param histogram kNumBins counts to fill
+   */
+  void getHistogram(int row, int col, int rows, int cols, int* histogram) const;
+
+  /**
+   * @brief Returns the number of pixels in a rectangle of cells
+   *
+   * @param row first row of cells
+   * @param col first column of cells
+   * @param rows rows of cells, at least 1
+   * @param cols columns of cells, at least 1
+   * @return pixels in the rectangle, less than a full cell each for the
+   *         cells on the bottom and right edges of the image
+   */
+  int getPixelCount(int row, int col, int rows, int cols) const;
+
+  private:
+
+  /**
+   * @brief Returns the corner histogram above and left of a cell corner
+   *
+   * @param row corner row, 0 to getRows()
+   * @param col corner column, 0 to getCols()
+   * @return kNumBins counts
+   */
+  const int* getCorner(int row, int col) const;
+
+  int rows_;
+  int cols_;
+  int cell_size_;
+
+  // Pixels of the image the grid was built from
+  int image_rows_;
+  int image_cols_;
+
+  // (rows_ + 1) * (cols_ + 1) corner histograms of kNumBins counts, row by
+  // row, with the top row and left column all zero
+  std::vector<int> corners_;
+
+  // Histogram of each cell of the row being counted, and the running sum
+  // along the row
+  std::vector<int> row_cells_;
+  std::vector<int> row_sum_;
+};
@@ -0,0 +1,39 @@
+/*********************************************************************
+ * @file       JsonFormat.cpp
+ * @brief      Helpers for writing the JSON reports and responses of the
+ *              batch and serve commands.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "JsonFormat.h"
+
+#include <cstdio>
+
+/**
+ * @brief Escapes a string to be written inside JSON quotes
+ *
+ * @param text string to escape
+ * @return escaped string
+ */
+std::string escapeJson(const std::string& text) {
+  std::string result;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if ((unsigned char)c < 0x20) {
+      char code[8];
+      snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+      result += code;
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,24 @@
+/*********************************************************************
+ * @file       JsonFormat.h
+ * @brief      Helpers for writing the JSON reports and responses of the
+ *              batch and serve commands.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Escapes a string to be written inside JSON quotes
+ *
+ * @param text string to escape
+ * @return escaped string
+ */
+std::string escapeJson(const std::string& text);
@@ -0,0 +1,99 @@
+/*********************************************************************
+ * @file       JsonSink.cpp
+ * @brief      JsonSink writes each result of findFlag as one line of JSON.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "JsonSink.h"
+
+#include "JsonFormat.h"
+
+/**
+ * @brief Constructor for a sink writing to a stream
+ *
+ * @param index flag metadata the results point into
+ * @param out stream to write to on flush
+ */
+JsonSink::JsonSink(const FlagIndex& index, std::ostream& out) : index_(index), out_(out) {}
+
+/**
+ * @brief Destructor writes out anything still buffered
+ */
+JsonSink::~JsonSink() {
+  flush();
+}
+
+/**
+ * @brief Formats one result into the buffer
+ *
+ * @param source name of the test image
+ * @param image decoded test image, not used
+ * @param result result of findFlag for the image
+ */
+void JsonSink::write(const std::string& source, const Mat& /* image */, const FlagResult& result) {
+  buffer_ << "{ \"image\": \"" << escapeJson(source) << "\", \"decoded\": " << (result.decoded ? "true" : "false")
+          << ", \"flags\": [";
+  for (size_t i = 0; i < result.flags.size(); ++i) {
+    buffer_ << (i > 0 ? ", " : "") << "\"" << escapeJson(index_.getName(result.flags[i])) << "\"";
+  }
+  buffer_ << "]";
+  if (!result.neighbors.empty()) {
+    buffer_ << ", \"distances\": [";
+    for (size_t i = 0; i < result.neighbors.size(); ++i) {
+      buffer_ << (i > 0 ? ", " : "") << result.neighbors[i].distance;
+    }
+    buffer_ << "]";
+  }
+  if (!result.confidences.empty()) {
+    buffer_ << ", \"confidences\": [";
+    for (size_t i = 0; i < result.confidences.size(); ++i) {
+      buffer_ << (i > 0 ? ", " : "") << result.confidences[i];
+    }
+    buffer_ << "]";
+  }
+  buffer_ << ", \"deciding_stage\": \"" << (result.decoded ? getStageName(result.deciding_stage) : "Unreadable")
+          << "\", \"stages\": [";
+
+  // Only the steps that ran
+  bool first = true;
+  for (int stage = 0; stage < kNumStages; ++stage) {
+    if (result.stage_ms[stage] < 0.0) {
+      continue;
+    }
+    buffer_ << (first ? "" : ", ") << "{ \"stage\": \"" << getStageName((FlagStage)stage)
+            << "\", \"ms\": " << result.stage_ms[stage];
+    if (result.candidates_in[stage] >= 0) {
+      buffer_ << ", \"candidates_in\": " << result.candidates_in[stage]
+              << ", \"candidates_out\": " << result.candidates_out[stage];
+    }
+    buffer_ << " }";
+    first = false;
+  }
+  buffer_ << "]";
+
+  if (result.decoded) {
+    buffer_ << ", \"common_color_ratio\": " << result.image_bucket.getCommonColorRatio();
+  }
+  if (result.edge_ratio >= 0.0f) {
+    buffer_ << ", \"edge_ratio\": " << result.edge_ratio;
+  }
+  if (result.quadrant_edge_ratio >= 0.0f) {
+    buffer_ << ", \"quadrant_edge_ratio\": " << result.quadrant_edge_ratio;
+  }
+  buffer_ << " }\n";
+}
+
+/**
+ * @brief Writes the buffer to the stream and empties it
+ */
+void JsonSink::flush() {
+  out_ << buffer_.str();
+  out_.flush();
+  buffer_.str("");
+}
@@ -0,0 +1,62 @@
+/*********************************************************************
+ * @file       JsonSink.h
+ * @brief      JsonSink writes each result of findFlag as one line of JSON.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "FlagIndex.h"
+#include "ResultSink.h"
+
+/**
+ * @class JsonSink writes one JSON object per line with the flags found, the
+ *        deciding step, the time and candidate counts of every step and the
+ *        ratios measured on the test image. Lines are buffered until flush.
+ */
+class JsonSink : public ResultSink {
+  public:
+
+  /**
+   * @brief Constructor for a sink writing to a stream
+   *
+   * @param index flag metadata the results point into
+   * @param out stream to write to on flush
+   */
+  JsonSink(const FlagIndex& index, std::ostream& out);
+
+  /**
+   * @brief Destructor writes out anything still buffered
+   */
+  ~JsonSink();
+
+  /**
+   * @brief Formats one result into the buffer
+   *
+   * @param source name of the test image
+   * @param image decoded test image, not used
+   * @param result result of findFlag for the image
+   */
+  void write(const std::string& source, const Mat& image, const FlagResult& result);
+
+  /**
+   * @brief Writes the buffer to the stream and empties it
+   */
+  void flush();
+
+  private:
+
+  const FlagIndex& index_;
+  std::ostream& out_;
+  std::ostringstream buffer_;
+};
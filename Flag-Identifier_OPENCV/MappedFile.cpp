@@ -0,0 +1,157 @@
+/*********************************************************************
+ * @file       MappedFile.cpp
+ * @brief      MappedFile maps a whole file read-only into memory so its
+ *              contents can be used in place without reading it.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Constructor creates an empty mapping
+ */
+MappedFile::MappedFile() : data_(nullptr), size_(0), file_handle_(nullptr), mapping_handle_(nullptr) {}
+
+/**
+ * @brief Destructor releases the mapping
+ */
+MappedFile::~MappedFile() {
+  close();
+}
+
+/**
+ * @brief Maps the given file into memory, releasing any earlier mapping
+ *
+ * @param path file to map
+ * @return true if the file was opened and mapped
+ */
+bool MappedFile::open(const std::string& path) {
+  close();
+
+#ifdef _WIN32
+  // Sharing delete lets a new index be renamed over the file while it is
+  // mapped, as it can be on other systems
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  file_handle_ = file;
+  mapping_handle_ = mapping;
+  data_ = static_cast<const char*>(view);
+  size_ = (size_t)file_size.QuadPart;
+#else
+  int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(file, &info) != 0 || info.st_size == 0) {
+    ::close(file);
+    return false;
+  }
+
+  void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+  // The mapping stays valid after the descriptor is closed
+  ::close(file);
+  if (view == MAP_FAILED) {
+    return false;
+  }
+
+  data_ = static_cast<const char*>(view);
+  size_ = (size_t)info.st_size;
+#endif
+
+  return true;
+}
+
+/**
+ * @brief Releases the mapping if there is one
+ */
+void MappedFile::close() {
+  if (data_ == nullptr) {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+  CloseHandle(mapping_handle_);
+  CloseHandle(file_handle_);
+#else
+  munmap(const_cast<char*>(data_), size_);
+#endif
+
+  data_ = nullptr;
+  size_ = 0;
+  file_handle_ = nullptr;
+  mapping_handle_ = nullptr;
+}
+
+/**
+ * @brief Exchanges mappings with another MappedFile
+ *
+ * @param other mapping to exchange with
+ */
+void MappedFile::swap(MappedFile& other) {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(file_handle_, other.file_handle_);
+  std::swap(mapping_handle_, other.mapping_handle_);
+}
+
+/**
+ * @brief Getter for the mapped bytes
+ *
+ * @return pointer to the first byte of the file or nullptr if not mapped
+ */
+const char* MappedFile::getData() const {
+  return data_;
+}
+
+/**
+ * @brief Getter for the size of the mapped file
+ *
+ * @return number of mapped bytes
+ */
+size_t MappedFile::getSize() const {
+  return size_;
+}
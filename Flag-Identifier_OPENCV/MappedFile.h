@@ -0,0 +1,83 @@
+/*********************************************************************
+ * @file       MappedFile.h
+ * @brief      MappedFile maps a whole file read-only into memory so its
+ *              contents can be used in place without reading it.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile owns a read-only memory mapping of a file. The mapping is
+ *        released when the object is closed or destroyed.
+ */
+class MappedFile {
+  public:
+
+  /**
+   * @brief Constructor creates an empty mapping
+   */
+  MappedFile();
+
+  /**
+   * @brief Destructor releases the mapping
+   */
+  ~MappedFile();
+
+  /**
+   * @brief Maps the given file into memory, releasing any earlier mapping
+   *
+   * @param path file to map
+   * @return true if the file was opened and mapped
+   */
+  bool open(const std::string& path);
+
+  /**
+   * @brief Releases the mapping if there is one
+   */
+  void close();
+
+  /**
+   * @brief Exchanges mappings with another MappedFile
+   *
+   * @param other mapping to exchange with
+   */
+  void swap(MappedFile& other);
+
+  /**
+   * @brief Getter for the mapped bytes
+   *
+   * @return pointer to the first byte of the file or nullptr if not mapped
+   */
+  const char* getData() const;
+
+  /**
+   * @brief Getter for the size of the mapped file
+   *
+   * @return number of mapped bytes
+   */
+  size_t getSize() const;
+
+  private:
+
+  // Copying would release the same mapping twice
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  // Start and size of the mapped view
+  const char* data_;
+  size_t size_;
+
+  // Operating system handles for the file and its mapping
+  void* file_handle_;
+  void* mapping_handle_;
+};
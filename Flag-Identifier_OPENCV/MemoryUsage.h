@@ -0,0 +1,30 @@
+/*********************************************************************
+ * @file       MemoryUsage.h
+ * @brief      MemoryUsage is one line of a report of the memory a part of
+ *              the program holds.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief MemoryUsage is the bytes held by one component, filled by the
+ *        getMemoryUsage of the classes that own it
+ */
+struct MemoryUsage {
+
+  // Printable name of the component
+  std::string component;
+
+  // Bytes allocated for it, counting the capacity of its buffers
+  size_t bytes;
+};
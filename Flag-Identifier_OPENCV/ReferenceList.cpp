@@ -0,0 +1,141 @@
+/*********************************************************************
+ * @file       ReferenceList.cpp
+ * @brief      ReferenceList reads the list of reference flags to index
+ *              from a directory of images or from a manifest file.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "ReferenceList.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Default constructor is private and doesn't allow calling
+ */
+ReferenceList::ReferenceList() {
+  // Do nothing
+}
+
+/**
+ * @brief Lists the reference flags of a directory or a manifest file.
+ *        Every .jpg, .jpeg and .png image of a directory is a flag named
+ *        after its file, and the images in each subdirectory are variants
+ *        grouped under the name of the subdirectory. A manifest has one
+ *        "path[,name[,group]]" line per flag (lines starting with # are
+ *        skipped), the name defaults to the file name and relative paths
+ *        are relative to the manifest.
+ *
+ * @param source directory or manifest file
+ * @param references flags in the order they are listed
+ * @param log stream to print unreadable lines to
+ * @return true if the source could be read and every line was valid
+ */
+bool ReferenceList::load(const std::string& source, std::vector<ReferenceEntry>& references, std::ostream& log) {
+  std::error_code error;
+  if (fs::is_directory(source, error)) {
+    return listDirectory(source, "", references);
+  }
+
+  std::ifstream manifest(source);
+  if (!manifest) {
+    log << "Could not read reference list \"" << source << "\"" << std::endl;
+    return false;
+  }
+  fs::path base = fs::path(source).parent_path();
+
+  bool valid = true;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(manifest, line)) {
+    ++line_number;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    // Fields after the path are optional
+    ReferenceEntry reference;
+    size_t first_comma = line.find(',');
+    reference.path = line.substr(0, first_comma);
+    if (first_comma != std::string::npos) {
+      size_t second_comma = line.find(',', first_comma + 1);
+      reference.name = line.substr(first_comma + 1, second_comma - first_comma - 1);
+      if (second_comma != std::string::npos) {
+        reference.group = line.substr(second_comma + 1);
+      }
+    }
+
+    if (reference.path.empty()) {
+      log << source << ":" << line_number << ": missing image path" << std::endl;
+      valid = false;
+      continue;
+    }
+    if (reference.name.empty()) {
+      reference.name = fs::path(reference.path).stem().string();
+    }
+    if (fs::path(reference.path).is_relative()) {
+      reference.path = (base / reference.path).string();
+    }
+    references.push_back(reference);
+  }
+  return valid;
+}
+
+/**
+ * @brief Lists the images of one directory, sorted so every build gives
+ *        the flags the same ids
+ *
+ * @param directory folder to list
+ * @param group group of every image in the folder
+ * @param references list to add the images to
+ * @return true if the folder could be listed
+ */
+bool ReferenceList::listDirectory(const std::string& directory, const std::string& group,
+                                  std::vector<ReferenceEntry>& references) {
+  std::error_code error;
+  std::vector<std::string> paths;
+  std::vector<std::string> subdirectories;
+  for (const fs::directory_entry& entry : fs::directory_iterator(directory, error)) {
+    std::string extension = entry.path().extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg" || extension == ".png")) {
+      paths.push_back(entry.path().string());
+    } else if (entry.is_directory() && group.empty()) {
+      subdirectories.push_back(entry.path().string());
+    }
+  }
+  if (error) {
+    return false;
+  }
+  std::sort(paths.begin(), paths.end());
+  std::sort(subdirectories.begin(), subdirectories.end());
+
+  for (const std::string& path : paths) {
+    ReferenceEntry reference;
+    reference.name = fs::path(path).stem().string();
+    reference.path = path;
+    reference.group = group;
+    references.push_back(reference);
+  }
+
+  // Variants only go one folder deep
+  for (const std::string& subdirectory : subdirectories) {
+    if (!listDirectory(subdirectory, fs::path(subdirectory).filename().string(), references)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,78 @@
+/*********************************************************************
+ * @file       ReferenceList.h
+ * @brief      ReferenceList reads the list of reference flags to index
+ *              from a directory of images or from a manifest file.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief ReferenceEntry is one reference flag to index
+ */
+struct ReferenceEntry {
+
+  // Name the flag is reported by, unique within the index
+  std::string name;
+
+  // Image file of the flag
+  std::string path;
+
+  // Flag this one is a variant of, empty if it is a flag of its own
+  std::string group;
+};
+
+/**
+ * @class ReferenceList is a helper class that lists the reference flags of
+ *        a directory or manifest. Nothing is decoded, so a list of thousands
+ *        of flags is read in moments and FlagIndex::build can check every
+ *        file before it starts measuring.
+ */
+class ReferenceList {
+  public:
+
+  /**
+   * @brief Lists the reference flags of a directory or a manifest file.
+   *        Every .jpg, .jpeg and .png image of a directory is a flag named
+   *        after its file, and the images in each subdirectory are variants
+   *        grouped under the name of the subdirectory. A manifest has one
+   *        "path[,name[,group]]" line per flag (lines starting with # are
+   *        skipped), the name defaults to the file name and relative paths
+   *        are relative to the manifest.
+   *
+   * @param source directory or manifest file
+   * @param references flags in the order they are listed
+   * @param log stream to print unreadable lines to
+   * @return true if the source could be read and every line was valid
+   */
+  static bool load(const std::string& source, std::vector<ReferenceEntry>& references, std::ostream& log);
+
+  private:
+
+  /**
+   * @brief Default constructor is private and doesn't allow calling
+   */
+  ReferenceList();
+
+  /**
+   * @brief Lists the images of one directory, sorted so every build gives
+   *        the flags the same ids
+   *
+   * @param directory folder to list
+   * @param group group of every image in the folder
+   * @param references list to add the images to
+   * @return true if the folder could be listed
+   */
+  static bool listDirectory(const std::string& directory, const std::string& group,
+                            std::vector<ReferenceEntry>& references);
+};
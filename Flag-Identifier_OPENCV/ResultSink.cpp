@@ -0,0 +1,25 @@
+/*********************************************************************
+ * @file       ResultSink.cpp
+ * @brief      ResultSink is the interface for reporting the results of
+ *              findFlag, kept out of the filters so searching never waits
+ *              on the console or a window.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "ResultSink.h"
+
+/**
+ * @brief Destructor for sinks deleted through the interface
+ */
+ResultSink::~ResultSink() {}
+
+/**
+ * @brief Writes out anything buffered, nothing by default
+ */
+void ResultSink::flush() {}
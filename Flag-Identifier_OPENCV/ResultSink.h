@@ -0,0 +1,49 @@
+/*********************************************************************
+ * @file       ResultSink.h
+ * @brief      ResultSink is the interface for reporting the results of
+ *              findFlag, kept out of the filters so searching never waits
+ *              on the console or a window.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+
+#include "FlagFinder.h"
+
+using namespace cv;
+
+/**
+ * @class ResultSink receives each result after its search has finished.
+ *        Sinks may buffer what they write until flush is called.
+ */
+class ResultSink {
+  public:
+
+  /**
+   * @brief Destructor for sinks deleted through the interface
+   */
+  virtual ~ResultSink();
+
+  /**
+   * @brief Reports the result of one test image
+   *
+   * @param source name of the test image
+   * @param image decoded test image, empty if it couldn't be read
+   * @param result result of findFlag for the image
+   */
+  virtual void write(const std::string& source, const Mat& image, const FlagResult& result) = 0;
+
+  /**
+   * @brief Writes out anything buffered
+   */
+  virtual void flush();
+};
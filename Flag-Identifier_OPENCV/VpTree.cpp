@@ -0,0 +1,198 @@
+/*********************************************************************
+ * @file       VpTree.cpp
+ * @brief      VpTree is a vantage point tree that finds the nearest feature
+ *              vectors to a query by euclidean distance.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "VpTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Orders neighbors so the farthest is on top of a heap
+ *
+ * @param a first neighbor
+ * @param b second neighbor
+ * @return true if a is closer than b
+ */
+static bool isCloser(const Neighbor& a, const Neighbor& b) {
+  return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+}
+
+/**
+ * @brief Constructor creates an empty tree
+ */
+VpTree::VpTree() : dims_(0), root_(-1) {}
+
+/**
+ * @brief Builds the tree over a set of points
+ *
+ * @param points count x dims values, one row per point. The id of a point
+ *        is its row.
+ * @param count number of points
+ * @param dims number of values in each point
+ */
+void VpTree::build(const float* points, int count, int dims) {
+  points_.assign(points, points + (size_t)count * dims);
+  dims_ = dims;
+  nodes_.clear();
+  nodes_.reserve(count);
+
+  std::vector<int> ids(count);
+  for (int i = 0; i < count; ++i) {
+    ids[i] = i;
+  }
+  root_ = buildNode(ids.data(), count);
+}
+
+/**
+ * @brief Finds the k points closest to a query
+ *
+ * @param query dims values
+ * @param k number of points to find
+ * @param neighbors filled with up to k points, closest first
+ */
+void VpTree::search(const float* query, int k, std::vector<Neighbor>& neighbors) const {
+  neighbors.clear();
+  if (root_ < 0 || k <= 0) {
+    return;
+  }
+  searchNode(root_, query, k, neighbors);
+  std::sort_heap(neighbors.begin(), neighbors.end(), isCloser);
+}
+
+/**
+ * @brief Getter for the number of points in the tree
+ *
+ * @return number of points
+ */
+int VpTree::getSize() const {
+  return (int)nodes_.size();
+}
+
+/**
+ * @brief Returns the memory the tree holds
+ *
+ * @return bytes allocated, counting the capacity of its buffers
+ */
+size_t VpTree::getMemoryBytes() const {
+  return points_.capacity() * sizeof(float) + nodes_.capacity() * sizeof(Node);
+}
+
+/**
+ * @brief Getter for the number of values in each point
+ *
+ * @return number of values
+ */
+int VpTree::getDims() const {
+  return dims_;
+}
+
+/**
+ * @brief Builds the subtree over a range of point ids
+ *
+ * @param ids first id of the range, reordered while building
+ * @param count number of ids in the range
+ * @return position of the subtree root in nodes_, -1 if count is 0
+ */
+int VpTree::buildNode(int* ids, int count) {
+  if (count == 0) {
+    return -1;
+  }
+
+  // The first id is the vantage point, the rest are split at the median
+  // distance to it
+  int position = (int)nodes_.size();
+  Node node = { ids[0], 0.0f, -1, -1 };
+  nodes_.push_back(node);
+  if (count == 1) {
+    return position;
+  }
+
+  const float* vantage = &points_[(size_t)ids[0] * dims_];
+  int* rest = ids + 1;
+  int num_rest = count - 1;
+  int median = num_rest / 2;
+  std::nth_element(rest, rest + median, rest + num_rest, [this, vantage](int a, int b) {
+    return getDistance(a, vantage) < getDistance(b, vantage);
+  });
+
+  // Children are built after the push so positions stay valid
+  float radius = getDistance(rest[median], vantage);
+  int inside = buildNode(rest, median + 1);
+  int outside = buildNode(rest + median + 1, num_rest - median - 1);
+  nodes_[position].radius = radius;
+  nodes_[position].inside = inside;
+  nodes_[position].outside = outside;
+  return position;
+}
+
+/**
+ * @brief Searches a subtree, keeping the k closest points in a max heap
+ *
+ * @param node position of the subtree root in nodes_
+ * @param query dims values
+ * @param k number of points to find
+ * @param heap closest points so far, farthest on top
+ */
+void VpTree::searchNode(int node, const float* query, int k, std::vector<Neighbor>& heap) const {
+  const Node& vantage = nodes_[node];
+  float distance = getDistance(vantage.id, query);
+
+  Neighbor found = { vantage.id, distance };
+  if ((int)heap.size() < k) {
+    heap.push_back(found);
+    std::push_heap(heap.begin(), heap.end(), isCloser);
+  } else if (isCloser(found, heap.front())) {
+    std::pop_heap(heap.begin(), heap.end(), isCloser);
+    heap.back() = found;
+    std::push_heap(heap.begin(), heap.end(), isCloser);
+  }
+
+  // Farthest distance that can still enter the heap
+  float tau = (int)heap.size() < k ? INFINITY : heap.front().distance;
+
+  // Search the side the query is on first, it is more likely to shrink tau
+  if (distance <= vantage.radius) {
+    if (vantage.inside >= 0 && distance - tau <= vantage.radius) {
+      searchNode(vantage.inside, query, k, heap);
+      tau = (int)heap.size() < k ? INFINITY : heap.front().distance;
+    }
+    if (vantage.outside >= 0 && distance + tau >= vantage.radius) {
+      searchNode(vantage.outside, query, k, heap);
+    }
+  } else {
+    if (vantage.outside >= 0 && distance + tau >= vantage.radius) {
+      searchNode(vantage.outside, query, k, heap);
+      tau = (int)heap.size() < k ? INFINITY : heap.front().distance;
+    }
+    if (vantage.inside >= 0 && distance - tau <= vantage.radius) {
+      searchNode(vantage.inside, query, k, heap);
+    }
+  }
+}
+
+/**
+ * @brief Euclidean distance between a point in the tree and a query
+ *
+ * @param id point in the tree
+ * @param query dims values
+ * @return distance
+ */
+float VpTree::getDistance(int id, const float* query) const {
+  const float* point = &points_[(size_t)id * dims_];
+  float sum = 0.0f;
+  for (int i = 0; i < dims_; ++i) {
+    float difference = point[i] - query[i];
+    sum += difference * difference;
+  }
+  return std::sqrt(sum);
+}
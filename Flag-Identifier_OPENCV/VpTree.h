@@ -0,0 +1,126 @@
+/*********************************************************************
+ * @file       VpTree.h
+ * @brief      VpTree is a vantage point tree that finds the nearest feature
+ *              vectors to a query by euclidean distance.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Neighbor is one flag found by a nearest neighbor search
+ */
+struct Neighbor {
+  int id;
+  float distance;
+};
+
+/**
+ * @class VpTree splits the points at every node by their distance to one
+ *        vantage point, so a search only visits the side of a node whose
+ *        distance range can still hold a closer point. Nodes are kept in one
+ *        array and the points are copied into the tree.
+ */
+class VpTree {
+  public:
+
+  /**
+   * @brief Constructor creates an empty tree
+   */
+  VpTree();
+
+  /**
+   * @brief Builds the tree over a set of points
+   *
+   * @param points count x dims values, one row per point. The id of a point
+   *        is its row.
+   * @param count number of points
+   * @param dims number of values in each point
+   */
+  void build(const float* points, int count, int dims);
+
+  /**
+   * @brief Finds the k points closest to a query
+   *
+   * @param query dims values
+   * @param k number of points to find
+   * @param neighbors filled with up to k points, closest first
+   */
+  void search(const float* query, int k, std::vector<Neighbor>& neighbors) const;
+
+  /**
+   * @brief Getter for the number of points in the tree
+   *
+   * @return number of points
+   */
+  int getSize() const;
+
+  /**
+   * @brief Returns the memory the tree holds
+   *
+   * @return bytes allocated, counting the capacity of its buffers
+   */
+  size_t getMemoryBytes() const;
+
+  /**
+   * @brief Getter for the number of values in each point
+   *
+   * @return number of values
+   */
+  int getDims() const;
+
+  private:
+
+  /**
+   * @brief Node is one vantage point. Points within radius of it are under
+   *        inside, the rest under outside.
+   */
+  struct Node {
+    int id;
+    float radius;
+    int inside;
+    int outside;
+  };
+
+  /**
+   * @brief Builds the subtree over a range of point ids
+   *
+   * @param ids first id of the range, reordered while building
+   * @param count number of ids in the range
+   * @return position of the subtree root in nodes_, -1 if count is 0
+   */
+  int buildNode(int* ids, int count);
+
+  /**
+   * @brief Searches a subtree, keeping the k closest points in a max heap
+   *
+   * @param node position of the subtree root in nodes_
+   * @param query dims values
+   * @param k number of points to find
+   * @param heap closest points so far, farthest on top
+   */
+  void searchNode(int node, const float* query, int k, std::vector<Neighbor>& heap) const;
+
+  /**
+   * @brief Euclidean distance between a point in the tree and a query
+   *
+   * @param id point in the tree
+   * @param query dims values
+   * @return distance
+   */
+  float getDistance(int id, const float* query) const;
+
+  std::vector<float> points_;
+  int dims_;
+  std::vector<Node> nodes_;
+  int root_;
+};
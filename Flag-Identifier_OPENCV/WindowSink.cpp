@@ -0,0 +1,118 @@
+/*********************************************************************
+ * @file       WindowSink.cpp
+ * @brief      WindowSink shows each test image and the flags found for it
+ *              in windows, waiting for a key press after each one.
+ *
+ * @author Joseph Lan
+ * @author Andy Tran
+ * @author Kevin Xu
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "WindowSink.h"
+
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+const int WindowSink::kMaxThumbnails = 8;
+const int WindowSink::kThumbnailSize = 480;
+
+/**
+ * @brief Constructor for a sink showing flags of an index
+ *
+ * @param index flag metadata the results point into
+ */
+WindowSink::WindowSink(const FlagIndex& index) : index_(index), shown_(0) {}
+
+/**
+ * @brief Shows the test image and then each flag found for it
+ *
+ * @param source name of the test image, not used
+ * @param image decoded test image, empty if it couldn't be read
+ * @param result result of findFlag for the image
+ */
+void WindowSink::write(const std::string& /* source */, const Mat& image, const FlagResult& result) {
+
+  // Print out test image
+  if (!image.empty()) {
+    namedWindow("Test Image", WINDOW_NORMAL);
+    resizeWindow("Test Image", image.cols, image.rows);
+    imshow("Test Image", image);
+  }
+  waitKey(0);
+
+  for (int flag : result.flags) {
+    std::string title = std::string("Result: ") + index_.getName(flag);
+
+    // Show result flag, unless its image was removed after it was indexed
+    const Mat& flag_image = getThumbnail(flag);
+    if (flag_image.empty()) {
+      continue;
+    }
+    namedWindow(title, WINDOW_NORMAL);
+    resizeWindow(title, flag_image.cols, flag_image.rows);
+    imshow(title, flag_image);
+    waitKey(0);
+  }
+}
+
+/**
+ * @brief Returns the memory the kept reference images hold
+ *
+ * @return bytes of pixels kept, at most kMaxThumbnails images of
+ *         kThumbnailSize on their longest side
+ */
+size_t WindowSink::getMemoryBytes() const {
+  size_t bytes = thumbnails_.capacity() * sizeof(Thumbnail);
+  for (const Thumbnail& thumbnail : thumbnails_) {
+    bytes += thumbnail.image.total() * thumbnail.image.elemSize();
+  }
+  return bytes;
+}
+
+/**
+ * @brief Returns the image of a flag, reading it and dropping the least
+ *        recently shown image if it isn't kept
+ *
+ * @param flag id of the flag
+ * @return image of the flag, empty if its file can't be read, valid
+ *         until the next call
+ */
+const Mat& WindowSink::getThumbnail(int flag) {
+  ++shown_;
+  for (Thumbnail& thumbnail : thumbnails_) {
+    if (thumbnail.flag == flag) {
+      thumbnail.last_shown = shown_;
+      return thumbnail.image;
+    }
+  }
+
+  // Reuse the slot of the least recently shown image once all are taken
+  std::vector<Thumbnail>::iterator slot;
+  if ((int)thumbnails_.size() < kMaxThumbnails) {
+    slot = thumbnails_.insert(thumbnails_.end(), Thumbnail());
+  } else {
+    slot = std::min_element(thumbnails_.begin(), thumbnails_.end(), [](const Thumbnail& a, const Thumbnail& b) {
+      return a.last_shown < b.last_shown;
+    });
+  }
+  Thumbnail& thumbnail = *slot;
+  thumbnail.flag = flag;
+  thumbnail.last_shown = shown_;
+
+  Mat image = imread(index_.getRecord(flag).path);
+  int longest = std::max(image.rows, image.cols);
+  if (longest > kThumbnailSize) {
+    double scale = (double)kThumbnailSize / longest;
+    resize(image, thumbnail.image, Size(), scale, scale, INTER_AREA);
+  } else {
+    thumbnail.image = image;
+  }
+  return thumbnail.image;
+}
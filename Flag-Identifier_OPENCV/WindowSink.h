@@ -0,0 +1,97 @@
+/*********************************************************************
+ * @file       WindowSink.h
+ * @brief      WindowSink shows each test image and the flags found for it
+ *              in windows, waiting for a key press after each one.
+ *
+ * @author Joseph Lan
+ * @author Andy Tran
+ * @author Kevin Xu
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FlagIndex.h"
+#include "ResultSink.h"
+
+using namespace cv;
+
+/**
+ * @class WindowSink opens a window for the test image and one for each flag
+ *        found. Nothing but the index is needed to find flags, so reference
+ *        images are only read when they are shown. The last kMaxThumbnails
+ *        shown are kept, shrunk to kThumbnailSize, so a flag that comes up
+ *        again isn't read again and the pixels held stay small however many
+ *        flags there are.
+ */
+class WindowSink : public ResultSink {
+  public:
+
+  // Reference images kept for showing again, least recently shown dropped
+  // first
+  static const int kMaxThumbnails;
+
+  // Longest side of a kept reference image
+  static const int kThumbnailSize;
+
+  /**
+   * @brief Constructor for a sink showing flags of an index
+   *
+   * @param index flag metadata the results point into
+   */
+  explicit WindowSink(const FlagIndex& index);
+
+  /**
+   * @brief Shows the test image and then each flag found for it
+   *
+   * @param source name of the test image, not used
+   * @param image decoded test image, empty if it couldn't be read
+   * @param result result of findFlag for the image
+   */
+  void write(const std::string& source, const Mat& image, const FlagResult& result);
+
+  /**
+   * @brief Returns the memory the kept reference images hold
+   *
+   * @return bytes of pixels kept, at most kMaxThumbnails images of
+   *         kThumbnailSize on their longest side
+   */
+  size_t getMemoryBytes() const;
+
+  private:
+
+  /**
+   * @brief Thumbnail is a reference image kept for showing again
+   */
+  struct Thumbnail {
+    int flag;
+    Mat image;
+    int64_t last_shown;
+  };
+
+  /**
+   * @brief Returns the image of a flag, reading it and dropping the least
+   *        recently shown image if it isn't kept
+   *
+   * @param flag id of the flag
+   * @return image of the flag, empty if its file can't be read, valid
+   *         until the next call
+   */
+  const Mat& getThumbnail(int flag);
+
+  const FlagIndex& index_;
+
+  // Kept reference images, and how many have been shown
+  std::vector<Thumbnail> thumbnails_;
+  int64_t shown_;
+};
@@ -0,0 +1,162 @@
+/*********************************************************************
+ * @file       WorkStealingPool.cpp
+ * @brief      WorkStealingPool is a fixed set of worker threads that each
+ *              have their own task queue and steal from each other when
+ *              their queue runs out.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#include "WorkStealingPool.h"
+
+/**
+ * @brief Constructor starts the worker threads
+ *
+ * @param num_threads number of workers, at least 1
+ */
+WorkStealingPool::WorkStealingPool(int num_threads)
+  : next_queue_(0), queued_(0), unfinished_(0), stop_(false) {
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+
+  for (int i = 0; i < num_threads; ++i) {
+    queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.push_back(std::thread(&WorkStealingPool::workerLoop, this, i));
+  }
+}
+
+/**
+ * @brief Destructor finishes queued tasks and joins the workers
+ */
+WorkStealingPool::~WorkStealingPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+/**
+ * @brief Queues a task to run on one of the workers
+ *
+ * @param task task to run
+ */
+void WorkStealingPool::submit(Task task) {
+  ++unfinished_;
+
+  WorkerQueue& queue = *queues_.at(next_queue_++ % queues_.size());
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+
+  // Count the task under the sleep lock so a worker can't miss it
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    ++queued_;
+  }
+  wake_.notify_one();
+}
+
+/**
+ * @brief Blocks until every submitted task has finished
+ */
+void WorkStealingPool::wait() {
+  std::unique_lock<std::mutex> lock(sleep_mutex_);
+  done_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+/**
+ * @brief Getter for the number of workers
+ *
+ * @return number of worker threads
+ */
+int WorkStealingPool::getThreadCount() const {
+  return (int)threads_.size();
+}
+
+/**
+ * @brief Returns the number of workers to use
+ *
+ * @param num_threads requested number of workers, 0 for one per core
+ * @return number of workers, at least 1
+ */
+int WorkStealingPool::chooseThreadCount(int num_threads) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  int cores = (int)std::thread::hardware_concurrency();
+  return cores > 0 ? cores : 1;
+}
+
+/**
+ * @brief Loop run by each worker until the pool is destroyed
+ *
+ * @param worker number of the worker
+ */
+void WorkStealingPool::workerLoop(int worker) {
+  while (true) {
+    Task task;
+    if (takeTask(worker, task)) {
+      task(worker);
+
+      // Last task of a batch wakes up wait()
+      if (--unfinished_ == 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        done_.notify_all();
+      }
+      continue;
+    }
+
+    // Nothing to take, sleep until a task is queued
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+    if (stop_ && queued_ == 0) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Takes a task from the worker's own queue or steals one
+ *
+ * @param worker number of the worker looking for a task
+ * @param task task that was taken
+ * @return true if a task was taken
+ */
+bool WorkStealingPool::takeTask(int worker, Task& task) {
+  int num_queues = (int)queues_.size();
+
+  // Newest task of its own queue first, then the oldest task of the others
+  for (int i = 0; i < num_queues; ++i) {
+    WorkerQueue& queue = *queues_.at((worker + i) % num_queues);
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+
+    if (i == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    --queued_;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,124 @@
+/*********************************************************************
+ * @file       WorkStealingPool.h
+ * @brief      WorkStealingPool is a fixed set of worker threads that each
+ *              have their own task queue and steal from each other when
+ *              their queue runs out.
+ *
+ * @author Joseph Lan
+ *
+ * @date 2026 October 17
+ *
+ * FLAG IDENTIIFIER
+ * CSS 487 Final Project
+ * Prof. Clark Olson
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool runs submitted tasks on a fixed number of threads.
+ *        Tasks are handed out round robin; a worker takes the newest task
+ *        from its own queue and steals the oldest task from another queue
+ *        when its own is empty. Each task is told which worker runs it so it
+ *        can use that worker's scratch data.
+ */
+class WorkStealingPool {
+  public:
+
+  // A task receives the number of the worker running it, 0 to threads - 1
+  typedef std::function<void(int)> Task;
+
+  /**
+   * @brief Constructor starts the worker threads
+   *
+   * @param num_threads number of workers, at least 1
+   */
+  explicit WorkStealingPool(int num_threads);
+
+  /**
+   * @brief Destructor finishes queued tasks and joins the workers
+   */
+  ~WorkStealingPool();
+
+  /**
+   * @brief Queues a task to run on one of the workers
+   *
+   * @param task task to run
+   */
+  void submit(Task task);
+
+  /**
+   * @brief Blocks until every submitted task has finished
+   */
+  void wait();
+
+  /**
+   * @brief Getter for the number of workers
+   *
+   * @return number of worker threads
+   */
+  int getThreadCount() const;
+
+  /**
+   * @brief Returns the number of workers to use
+   *
+   * @param num_threads requested number of workers, 0 for one per core
+   * @return number of workers, at least 1
+   */
+  static int chooseThreadCount(int num_threads);
+
+  private:
+
+  // Copying would share the worker threads
+  WorkStealingPool(const WorkStealingPool&);
+  WorkStealingPool& operator=(const WorkStealingPool&);
+
+  /**
+   * @brief WorkerQueue is the task queue owned by one worker
+   */
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  /**
+   * @brief Loop run by each worker until the pool is destroyed
+   *
+   * @param worker number of the worker
+   */
+  void workerLoop(int worker);
+
+  /**
+   * @brief Takes a task from the worker's own queue or steals one
+   *
+   * @param worker number of the worker looking for a task
+   * @param task task that was taken
+   * @return true if a task was taken
+   */
+  bool takeTask(int worker, Task& task);
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> threads_;
+
+  // Queue the next submitted task goes to
+  std::atomic<unsigned int> next_queue_;
+
+  // Tasks waiting in a queue and tasks not yet finished
+  std::atomic<int> queued_;
+  std::atomic<int> unfinished_;
+
+  // Workers sleep on wake_ while there is nothing queued, wait() sleeps on
+  // done_ until unfinished_ reaches 0
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  bool stop_;
+};
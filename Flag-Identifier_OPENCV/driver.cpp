@@ -15,11 +15,76 @@
  *                -number of arguments is the number of test images to attempt
  *                -file1, file2, and file3 are the names of jpg images in the
  *                -flag directory
+ *              followed by optional --no-console, --no-windows and
+ *                --json file to choose where results are reported, and
+ *                --knn K to return the K closest flags by feature distance
+ *                or --rank K to return up to K flags ranked by combined
+ *                distance with a confidence each, instead of running the
+ *                filters. Large jpg files are decoded at a reduced scale
+ *                unless --full-decode is given.
  *
  *              The program takes each input image and runs through filters
  *                sequentially until it comes up with the name of the image, OR
  *                it returns a number of images that are the closest.
  *
+ *              Other commands:
+ *                index [--refs dir or manifest] [--threads N]
+ *                      [--colors bgr|lab|hsv]
+ *                                            builds the flag index file from
+ *                                            flags/references.txt or the
+ *                                            given reference flags on N
+ *                                            threads, bucketing colors in
+ *                                            BGR, Lab or HSV. Every other
+ *                                            command uses the colors of the
+ *                                            index file
+ *                index add|replace <name> <image> [group]
+ *                index remove <name>         changes one flag of the index
+ *                                            file, which a running serve
+ *                                            picks up
+ *                batch <dir or manifest> [out] [--threads N]
+ *                      [--metrics file] [--knn K] [--rank K]
+ *                      [--full-decode]
+ *                                            tests images without windows on N
+ *                                            threads and writes out.csv and
+ *                                            out.json
+ *                video <file, sequence or camera> [--change share]
+ *                      [--refresh N] [--json file] [--knn K] [--rank K]
+ *                                            finds the flag in every frame,
+ *                                            searching again only when the
+ *                                            colors change, and prints the
+ *                                            frame rate and skip rate
+ *                locate <image> [--out file] finds the box of a flag in a
+ *                                            larger picture, names the flag
+ *                                            in it and draws the box into
+ *                                            the out file
+ *                plan <dir or manifest>      orders the filters after the
+ *                                            MCC filter by their cost per
+ *                                            flag removed on labeled images
+ *                                            and writes flags/flags.plan
+ *                serve [--socket path] [--batch N] [--max-wait-ms N]
+ *                      [--threads N] [--metrics file] [--knn K]
+ *                      [--rank K] [--full-decode]
+ *                                            answers length prefixed images
+ *                                            from stdin or a socket with one
+ *                                            JSON line each
+ *                memory [image]              prints the memory the index,
+ *                                            the indexes built from it and
+ *                                            the buffers of a query hold
+ *                bench histogram [--colors bgr|lab|hsv]
+ *                                            times the histogram kernel
+ *                bench edges                 times the edge ratio kernel
+ *                bench decode <dir or manifest> [--threads N]
+ *                                            checks reduced jpg decoding
+ *                                            against full size decoding
+ *                bench alloc <image>         counts heap allocations of a
+ *                                            warm query
+ *                bench stages [--save file] [--compare file]
+ *                      [--threshold percent]
+ *                                            times each step and findFlag
+ *                                            over flags/ and wflags/, saves
+ *                                            a baseline or fails on steps
+ *                                            slower than one
+ *
  * @author Joseph Lan
  * @author Andy Tran
  * @author Kevin Xu
@@ -34,492 +99,817 @@
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <list>
-#include <unordered_map>
+#include <memory>
+#include <mutex>
 #include <string>
-
-#include "ColorBucket.h"
-#include "CommonColorFinder.h"
+#include <thread>
+#include <vector>
+
+#include "BatchEvaluator.h"
+#include "Benchmarks.h"
+#include "CascadePlan.h"
+#include "ColorQuantizer.h"
+#include "ConsoleSink.h"
+#include "FlagCatalog.h"
+#include "FlagFinder.h"
+#include "FlagIndex.h"
+#include "FlagLocator.h"
+#include "FlagMetrics.h"
+#include "FlagService.h"
+#include "FrameStream.h"
+#include "ImageDecoder.h"
+#include "JsonSink.h"
+#include "MemoryUsage.h"
+#include "ReferenceList.h"
+#include "WindowSink.h"
+#include "WorkStealingPool.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 using namespace cv;
 
 /**
- * @brief   findClosestFlag method will analyze an input image and determine
- *            similar looking flags based on the most common color present.
+ * @brief Warns about every flag of the reference list that isn't in the
+ *        index and every flag of the index that isn't in the list. They
+ *        differ after index add or remove, so they are not rebuilt.
  *
- * @param   flag_map is the multi-dimensional map containing a list of strings
- *            with state names in their appropriate bucket based on the most
- *            common color present.
- * @param   image_bucket is the color bucket for the input image.
- *
- * @return  a list of similar looking flags based on the input image.
+ * @param index loaded flag metadata
+ * @param reference_source directory or manifest of the reference flags
+ * @param log stream to print the differences to
  */
-std::list<std::string> findClosestFlag(const std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::list<std::string>>>>& flag_map,
-                                       const ColorBucket& image_bucket) {
-
-  // Return the key,value pair found at the bottom of hashmap
-  std::list<std::string> result;
-
-  // Variables for readability
-  int red = image_bucket.getRedBucket();
-  int blue = image_bucket.getBlueBucket();
-  int green = image_bucket.getGreenBucket();
-  const int max_bucket = 7;
+void checkReferences(const FlagIndex& index, const std::string& reference_source, std::ostream& log) {
+  std::vector<ReferenceEntry> references;
+  if (!ReferenceList::load(reference_source, references, log)) {
+    return;
+  }
 
-  //Look for flags in adjacent buckets as the input image
-  for (int r = red - 1; r <= red + 1; ++r) {
-    if (r < 0 || r > max_bucket) {
-      continue;
+  std::vector<bool> listed(index.getSize(), false);
+  int num_missing = 0;
+  for (const ReferenceEntry& reference : references) {
+    int id = index.getId(reference.name);
+    if (id < 0) {
+      log << "Flag not in the index file: " << reference.name << std::endl;
+      ++num_missing;
+    } else {
+      listed[id] = true;
     }
-    for (int b = blue - 1; b <= blue + 1; ++b) {
-      if (b < 0 || b > max_bucket) {
-        continue;
-      }
-      for (int g = green - 1; g <= green + 1; ++g) {
-        if (g < 0 || g > max_bucket) {
-          continue;
-        }
-
-        // Merge all adjacent flag_list buckets
-        try {
-          std::list<std::string> flag_list = flag_map.at(r).at(b).at(g);
-
-          // Merges list<string> of all closest flags in adjacent buckets
-          for (std::string x : flag_list) {
-            result.push_back(x);
-          }
-
-          // If an adjacent bucket combination does not exist
-        } catch (std::exception e2) {
-          continue; // Go to next adjacent bucket
-        }
-      }
+  }
+  int num_unlisted = 0;
+  for (int id = 0; id < index.getSize(); ++id) {
+    if (!listed[id]) {
+      log << "Flag not in \"" << reference_source << "\": " << index.getName(id) << std::endl;
+      ++num_unlisted;
     }
   }
-  
-  return result;
+  if (num_missing > 0 || num_unlisted > 0) {
+    log << "The index file has " << index.getSize() << " flags and \"" << reference_source << "\" lists "
+        << references.size() << " (run with \"index\" to rebuild it from the list)." << std::endl;
+  }
 }
 
 /**
- * @brief filterRatios gets closer to the target flag by filtering out images
- *        based on histogram ratios in aand color bucket information
+ * @brief Loads the flag metadata from the index file. Flags whose image
+ *        changed since the file was written are measured again in place,
+ *        the new stamps of images that were only touched are saved, and
+ *        flags that differ from the reference list are reported. If the
+ *        file is missing or out of date, was saved in another color
+ *        scheme than the one in use, or a changed image can't be read, the
+ *        metadata is built from the flag images instead.
  *
- * @pre   none of the parameters are null
- * @post  list is updated after applying filter
- *
- * @param list is a list of possible flags remaining
- * @param color_buckets is a map of colorbuckets for index images
- * @param image_bucket is the colorbucket for the input image
+ * @param index index to load into
+ * @param reference_source directory or manifest of the reference flags
+ * @param index_path index file to load
+ * @param log stream to print rebuild messages to
+ * @return true if the metadata was loaded or built
  */
-void filterRatios(std::list<std::string>& list,
-                  const std::unordered_map<std::string, ColorBucket>& color_buckets,
-                  const ColorBucket& image_bucket) {
-  if (list.size() <= 1) {
-    return;
-  }
-
-  // Ratio of most common color bucket to all pixels in the image
-  float image_ratio = image_bucket.getCommonColorRatio();
-  const float acceptable_error = 0.006f;
-  float min_ratio = image_ratio - acceptable_error;
-  float max_ratio = image_ratio + acceptable_error;
-  std::cout << "Test image_ratio: " << image_ratio << std::endl;
-  std::cout << "min: " << min_ratio << std::endl;
-  std::cout << "max: " << max_ratio << std::endl;
-
-  std::list<std::string>::iterator it = list.begin();
-  while (it != list.end()) {
-    std::string s = *it;
-
-    // Get ratio of most common color bucket for each flag in list
-    float index_ratio = color_buckets.at(s).getCommonColorRatio();
-    std::cout << "index_ratio: " << index_ratio << std::endl;
-    // Check if ratio is within acceptable range
-    if (index_ratio < min_ratio || index_ratio > max_ratio) {
+bool loadFlagIndex(FlagIndex& index, const std::string& reference_source, const std::string& index_path,
+                   std::ostream& log) {
+  std::vector<std::string> stale;
+  if (index.load(index_path, log) && index.getColorScheme() == ColorQuantizer::getScheme()) {
+    checkReferences(index, reference_source, log);
+    int num_restamped = 0;
+    if (!index.findStaleSources(stale, num_restamped)) {
+
+      // Images that were touched but not changed are saved with their new
+      // stamp, so they aren't read again on every start
+      if (num_restamped > 0 && !index.save(index_path)) {
+        log << "Could not save the stamps of " << num_restamped << " touched flag images to \"" << index_path
+            << "\"." << std::endl;
+      }
+      return true;
+    }
 
-      // Delete if not in acceptable range
-      it = list.erase(it);
-    } else {
-      ++it;
+    // Only the changed flags are measured again
+    bool refreshed = true;
+    for (const std::string& name : stale) {
+      log << "Changed flag image: " << name << std::endl;
+      const FlagRecord& stored = index.getRecord(index.getId(name));
+      ReferenceEntry reference;
+      reference.name = name;
+      reference.path = stored.path;
+      reference.group = stored.group;
+      FlagRecord record;
+      refreshed = refreshed && FlagIndex::extractRecord(reference, record) && index.replaceFlag(record);
+    }
+    if (refreshed) {
+      log << "Measured " << stale.size() << " changed flags again (run with \"index\" to save them)." << std::endl;
+      return true;
     }
   }
-  return;
+
+  log << "Index file \"" << index_path << "\" is missing or out of date, "
+      << "building flag metadata (run with \"index\" to save it)." << std::endl;
+  std::vector<ReferenceEntry> references;
+  return ReferenceList::load(reference_source, references, log) && index.build(references, 0, log);
 }
 
 /**
- * @brief   Returns number of edge pixels in an image through canny edge
- *          detection
- *
- * @pre     img is not null
- * @post    no change to image
+ * @brief Loads the cascade plan kept next to the index file. The fixed
+ *        filter order is used if there is none, or if the index changed
+ *        size since the plan was made.
  *
- * @param   img is the image to count
- * @return  count of edge pixels
+ * @param plan_path plan file to load
+ * @param index flag metadata the plan is used with
+ * @param log stream to print a warning to if the index changed size since
+ *        the plan was made
+ * @return plan from the file, or the fixed order
  */
-int countEdgePixels(const Mat& img) {
-  int count = 0;
-  for (int row = 0; row < img.rows; ++row) {
-    for (int col = 0; col < img.cols; ++col) {
-
-      // If this is an edge, increment count
-      if (img.at<uchar>(row, col) != 0) {
-        ++count;
-      }
-    }
+CascadePlan loadCascadePlan(const std::string& plan_path, const FlagIndex& index, std::ostream& log) {
+  CascadePlan plan;
+  if (plan.load(plan_path) && plan.getNumFlags() != index.getSize()) {
+    log << "Cascade plan \"" << plan_path << "\" was made for " << plan.getNumFlags() << " flags and the index has "
+        << index.getSize() << ", using the fixed filter order (run \"plan\" again)." << std::endl;
+    return CascadePlan();
   }
-  return count;
+  return plan;
 }
 
 /**
- * @brief Filters our flags from list using canny edge count
+ * @brief Runs the index command, which measures every reference flag and
+ *        writes the index file
  *
- * @pre   list not empty, images is filled with flag templates, test_image not null
- * @post  list changed to remove flags not within range of canny edge counts
- *
- * @param list possible flags that match
- * @param images map or images kept as image database
- * @param test_image image being tested
+ * @param reference_source default directory or manifest of the reference
+ *        flags
+ * @param index_path index file to write
+ * @param argc number of arguments
+ * @param argv "index" [--refs directory or manifest] [--threads N]
+ *             [--colors bgr|lab|hsv]. The colors were selected by main.
+ * @return 0 on success
  */
-void filterCannyEdgeCount(std::list<std::string>& list,
-                          const std::unordered_map<std::string, Mat>& images,
-                          const Mat& test_image) {
-
-  // If only one item in list, end
-  if (list.size() <= 1) {
-    return;
-  }
-
-  // Define variables for edge counting
-  const int gaussian_kernel = 7;
-  const double gaussian_deviation = 2.0;
-  const int thresh1 = 20;
-  const int thresh2 = 60;
-
-  // Count test image edge counts
-  Mat test_clone = test_image.clone();
-  cvtColor(test_clone, test_clone, COLOR_BGR2GRAY);
-  GaussianBlur(test_clone, test_clone, Size(gaussian_kernel, gaussian_kernel), gaussian_deviation, gaussian_deviation);
-  Canny(test_clone, test_clone, thresh1, thresh2);
-  int test_edge_counts = countEdgePixels(test_clone);
-
-  // Convert to ratio and set boundaries
-  int num_pix = test_image.rows * test_image.cols;
-  const float acceptable_error = 0.006f;
-  float ratio = (float)test_edge_counts / (float)num_pix;
-  float min_ratio = ratio - acceptable_error;
-  float max_ratio = ratio + acceptable_error;
-
-  std::cout << "Test ratio: " << ratio << std::endl;
-  std::cout << "min: " << min_ratio << std::endl;
-  std::cout << "max: " << max_ratio << std::endl;
-
-  // For each flag in list
-  std::vector<float> possible_ratios;
-  for (std::string x : list) {
-
-    // Convert image into canny edge image
-    Mat edged_image = images.at(x).clone();
-    cvtColor(edged_image, edged_image, COLOR_BGR2GRAY);
-    GaussianBlur(edged_image, edged_image, Size(gaussian_kernel, gaussian_kernel), gaussian_deviation, gaussian_deviation);
-    Canny(edged_image, edged_image, thresh1, thresh2);
-
-    // Count edges
-    int edged_count = countEdgePixels(edged_image);
-    int edged_pix = edged_image.rows * edged_image.cols;
-    float edged_ratio = (float)edged_count / (float)edged_pix;
-    std::cout << "ratio: " << edged_ratio << std::endl;
-    possible_ratios.push_back(edged_ratio);
-  }
-
-  // Compare count ratio in images to count ratio for the test file
-  int num_possible = (int)list.size();
-  for (int i = 0; i < num_possible; ++i) {
-
-    std::string flag = list.front();
-
-    // If head of list ratio is within bounds, add it back in
-    if (possible_ratios.at(i) >= min_ratio &&
-        possible_ratios.at(i) <= max_ratio) {
-      //std::cout << "Keeping this flag" << std::endl;
-      list.push_back(flag);
+int runIndexBuild(const std::string& reference_source, const std::string& index_path, int argc, char* argv[]) {
+  std::string source = reference_source;
+  int num_threads = 0;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--refs" && i + 1 < argc) {
+      source = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+    } else if (arg == "--colors" && i + 1 < argc) {
+      ++i;
     } else {
-      //std::cout << "Removing this flag" << std::endl;
+      std::cout << "Unknown index option \"" << arg << "\"" << std::endl;
+      return 1;
     }
+  }
 
-    // Destroy first element
-    list.pop_front();
+  std::vector<ReferenceEntry> references;
+  if (!ReferenceList::load(source, references, std::cout)) {
+    return 1;
   }
+
+  FlagIndex index;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (!index.build(references, num_threads, std::cout) || !index.save(index_path)) {
+    std::cout << "Could not build index file \"" << index_path << "\"" << std::endl;
+    return 1;
+  }
+  double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Indexed " << index.getSize() << " flags from \"" << source << "\" into \"" << index_path
+            << "\" in " << (int)build_ms << " ms on " << WorkStealingPool::chooseThreadCount(num_threads)
+            << " threads in " << ColorQuantizer::getSchemeName(ColorQuantizer::getScheme()) << " colors" << std::endl;
+  return 0;
 }
 
 /**
- * @brief Builds a 3 tier layered unordered map that stores a map of flags based
- *        on color bucket in RBG order and the string name of a flag
- * 
- * @pre   Pass in non null objects
- * @post  assigns parameter objects to values
- * 
- * @param index_files vector of flag names in directory to create metadata for
- * @param flag_map map of flag string names based on colorbucket
- * @param images map of images to use to populate flag map
- * @param index_color_buckets map of color bucket information
+ * @brief Runs the index add, replace and remove commands, which change one
+ *        flag of the index file without measuring the others again
+ *
+ * @param index_path index file to change
+ * @param argc number of arguments
+ * @param argv "index" add|replace <name> <image> [group] or "index" remove
+ *             <name>. A replaced flag keeps its group unless one is given.
+ * @return 0 on success
  */
-void buildFlagMap(const std::vector<std::string>& index_files,
-                  std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::list<std::string>>>>& flag_map,
-                  const std::unordered_map<std::string, Mat>& images,
-                  std::unordered_map<std::string, ColorBucket>& index_color_buckets) {
-
-  // flag_map maps red bucket in ints to a corresponding map of blue bucket
-  // next layer maps blue bucket int to a corresponding map of green bucket
-  // green bucket maps int bucket to a string
-  for (std::string name : index_files) {
-    // Get ColorBucket object, which holds the bucket for the most common color
-    ColorBucket current_image = CommonColorFinder::getCommonColorBucket(images.at(name));
-
-    //Add the colorbucket to the map of colorbuckets for index images
-    std::pair<std::string, ColorBucket> index_colorbucket(name, current_image);
-    index_color_buckets.insert(index_colorbucket);
-
-    // If hashmap doesn't have an image with this red bucket, add it
-    if (flag_map.find(current_image.getRedBucket()) == flag_map.end()) {
-
-      // Add the colorbucket and its name
-
-      // Create final map with string of flag names
-      std::unordered_map<int, std::list<std::string>> final_map; // map
-      std::list<std::string> flag_names; // Create flag name list
-      flag_names.push_back(name); // Push this state name onto flag_name list
-
-      // Create the green bucket int to flag name and put into map
-      std::pair<int, std::list<std::string>> green_to_flags(current_image.getGreenBucket(), flag_names);
-      final_map.insert(green_to_flags);
-
-      // Create mid map with blue bucket and final_map
-      std::unordered_map<int, std::unordered_map<int, std::list<std::string>>> mid_map;
-
-      // Create pair of blue bucket int to final map and put into map
-      std::pair<int, std::unordered_map<int, std::list<std::string>>> blue_to_green(current_image.getBlueBucket(), final_map);
-      mid_map.insert(blue_to_green);
-
-      // Insert map made into red
-      std::pair<int, std::unordered_map<int, std::unordered_map<int, std::list<std::string>>>> red_to_blue(current_image.getRedBucket(), mid_map);
-      flag_map.insert(red_to_blue);
-
-      // Red bucket exists, check blue
-    } else if (flag_map.at(current_image.getRedBucket()).find(current_image.getBlueBucket()) ==
-              flag_map.at(current_image.getRedBucket()).end()) {
-
-      // Add the colorbucket and its name
-
-      // Create final map with string of flag names
-      std::unordered_map<int, std::list<std::string>> final_map; // map
-      std::list<std::string> flag_names; // Create flag name list
-      flag_names.push_back(name); // Push this state name onto flag_name list
-
-      // Create the green bucket int to flag name and put into map
-      std::pair<int, std::list<std::string>> green_to_flags(current_image.getGreenBucket(), flag_names);
-      final_map.insert(green_to_flags);
+int runIndexUpdate(const std::string& index_path, int argc, char* argv[]) {
+  std::string command = argv[2];
+  std::string name = argv[3];
+
+  FlagIndex index;
+  if (!index.load(index_path, std::cout)) {
+    std::cout << "Could not load index file \"" << index_path << "\" (run \"index\" first)" << std::endl;
+    return 1;
+  }
 
-      // Create mid map with blue bucket and final_map
-      std::unordered_map<int, std::unordered_map<int, std::list<std::string>>> mid_map;
+  bool changed;
+  if (command == "remove") {
+    changed = index.removeFlag(name);
+  } else {
+    ReferenceEntry reference;
+    reference.name = name;
+    reference.path = argv[4];
+    if (argc == 6) {
+      reference.group = argv[5];
+    } else if (command == "replace" && index.getId(name) >= 0) {
+      reference.group = index.getRecord(index.getId(name)).group;
+    }
+    FlagRecord record;
+    if (!FlagIndex::extractRecord(reference, record)) {
+      std::cout << "Could not read flag image \"" << argv[4] << "\"" << std::endl;
+      return 1;
+    }
+    changed = command == "add" ? index.addFlag(record) : index.replaceFlag(record);
+  }
+  if (!changed) {
+    std::cout << "Flag \"" << name << "\" is " << (command == "add" ? "already" : "not") << " in the index" << std::endl;
+    return 1;
+  }
 
-      std::pair<int, std::unordered_map<int, std::list<std::string>>> blue_to_green(current_image.getBlueBucket(), final_map);
-      mid_map.insert(blue_to_green);
+  if (!index.save(index_path)) {
+    std::cout << "Could not write index file \"" << index_path << "\"" << std::endl;
+    return 1;
+  }
+  std::cout << "Index file \"" << index_path << "\" now has " << index.getSize() << " flags" << std::endl;
+  return 0;
+}
 
-      flag_map.at(current_image.getRedBucket()).insert(blue_to_green);
+/**
+ * @brief Runs the plan command, which runs each filter after the MCC filter
+ *        alone on every labeled test image, orders the filters by their
+ *        cost per flag removed and writes the plan file
+ *
+ * @param index flag metadata to search
+ * @param plan_path plan file to write
+ * @param source directory or manifest of labeled test images
+ * @return 0 on success
+ */
+int runPlan(const FlagIndex& index, const std::string& plan_path, const std::string& source) {
+  FlagFinder finder(index);
+  BatchEvaluator evaluator(finder, index);
+  if (!evaluator.loadInputs(source)) {
+    std::cout << "Could not read test images from \"" << source << "\"" << std::endl;
+    return 1;
+  }
 
-      // Red and blue bucket exist, check green
-    } else if (flag_map.at(current_image.getRedBucket()).at(current_image.getBlueBucket()).find(current_image.getGreenBucket()) ==
-              flag_map.at(current_image.getRedBucket()).at(current_image.getBlueBucket()).end()) {
+  // One thread, so the filters are timed without sharing cores
+  std::vector<CascadeSample> samples;
+  FlagScratch scratch;
+  for (const BatchItem& item : evaluator.getItems()) {
+    if (item.label.empty()) {
+      continue;
+    }
+    ImageDecoder::readFile(item.path, scratch.encoded);
+    ImageDecoder::decode(scratch.encoded, true, scratch.test_file);
+    if (scratch.test_file.empty()) {
+      std::cout << "Could not read test image \"" << item.path << "\"" << std::endl;
+      continue;
+    }
 
-      // Add the colorbucket and its name
+    CascadeSample sample;
+    finder.sampleFilters(scratch.test_file, sample, scratch);
+    sample.correct.resize(sample.flags.size());
+    for (size_t i = 0; i < sample.flags.size(); ++i) {
+      sample.correct[i] = evaluator.matchesLabel(sample.flags[i], item.label) ? 1 : 0;
+    }
+    samples.push_back(sample);
+  }
 
-      // Create final map with string of flag names
-      std::unordered_map<int, std::list<std::string>> final_map; // map
-      std::list<std::string> flag_names; // Create flag name list
-      flag_names.push_back(name); // Push this state name onto flag_name list
+  CascadePlan plan;
+  if (!plan.build(samples, index.getSize(), std::cout)) {
+    std::cout << "No labeled test images in \"" << source << "\"" << std::endl;
+    return 1;
+  }
+  if (!plan.save(plan_path)) {
+    std::cout << "Could not write plan file \"" << plan_path << "\"" << std::endl;
+    return 1;
+  }
+  std::cout << "Plan written to " << plan_path << std::endl;
+  return 0;
+}
 
-      // Create the green bucket int to flag name and put into map
-      std::pair<int, std::list<std::string>> green_to_flags(current_image.getGreenBucket(), flag_names);
-      final_map.insert(green_to_flags);
+/**
+ * @brief Runs the batch command, which tests every image in a directory or
+ *        manifest without opening windows and writes the results
+ *
+ * @param index flag metadata to search
+ * @param plan order of the filters after the MCC filter
+ * @param argc number of arguments
+ * @param argv "batch" <directory or manifest> [output prefix] [--threads N]
+ *             [--metrics file] [--knn K] [--rank K] [--full-decode]
+ * @return 0 on success
+ */
+int runBatch(const FlagIndex& index, const CascadePlan& plan, int argc, char* argv[]) {
+  std::string source = argv[2];
+  std::string output = "batch_results";
+  std::string metrics_path;
+  int num_threads = 0;
+  int nearest_k = 0;
+  int rank_k = 0;
+  bool reduced_decode = true;
+
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      num_threads = atoi(argv[++i]);
+    } else if (arg == "--metrics" && i + 1 < argc) {
+      metrics_path = argv[++i];
+    } else if (arg == "--knn" && i + 1 < argc) {
+      nearest_k = atoi(argv[++i]);
+    } else if (arg == "--rank" && i + 1 < argc) {
+      rank_k = atoi(argv[++i]);
+    } else if (arg == "--full-decode") {
+      reduced_decode = false;
+    } else {
+      output = arg;
+    }
+  }
 
-      flag_map.at(current_image.getRedBucket()).at(current_image.getBlueBucket()).insert(green_to_flags);
+  FlagMetrics metrics;
+  FlagFinder finder(index);
+  finder.setMetrics(&metrics);
+  finder.setNearestNeighbors(nearest_k);
+  finder.setRanking(rank_k);
+  finder.setReducedDecode(reduced_decode);
+  finder.setPlan(plan);
+  BatchEvaluator evaluator(finder, index);
+  if (!evaluator.loadInputs(source)) {
+    std::cout << "Could not read test images from \"" << source << "\"" << std::endl;
+    return 1;
+  }
 
-      // The RBG bucket combination exists for a flag
-    } else {
-      flag_map.at(current_image.getRedBucket()).at(current_image.getBlueBucket()).at(current_image.getGreenBucket()).push_back(name);
+  evaluator.run(num_threads);
+  if (!evaluator.writeCsv(output + ".csv") || !evaluator.writeJson(output + ".json")) {
+    std::cout << "Could not write results to \"" << output << "\"" << std::endl;
+    return 1;
+  }
 
+  evaluator.printSummary(std::cout);
+  std::cout << "Results written to " << output << ".csv and " << output << ".json" << std::endl;
+  if (!metrics_path.empty()) {
+    if (!metrics.writeFile(metrics_path)) {
+      std::cout << "Could not write metrics to \"" << metrics_path << "\"" << std::endl;
+      return 1;
     }
+    std::cout << "Metrics written to " << metrics_path << std::endl;
   }
+  return 0;
 }
 
 /**
- * @brief Prints out list of options options in a list of strings
- * 
- * @pre options not null
- * @post no change to objects
- * 
- * @param options list of possible flags
+ * @brief Runs the bench stages command, which times every step over the
+ *        bundled flags/ and wflags/ images and saves the timings as a
+ *        baseline or compares them against one
+ *
+ * @param index flag metadata to search
+ * @param reference_source directory or manifest of the reference flags
+ * @param argc number of arguments
+ * @param argv "bench" "stages" [--save file] [--compare file]
+ *             [--threshold percent]
+ * @return 0 on success, 1 if a step regressed past the threshold
  */
-void print_options(std::list<std::string> options, std::string operation) {
-  int index = 0;
-  std::list<std::string>::iterator it = options.begin();
+int runStageBenchmarks(const FlagIndex& index, const std::string& reference_source, int argc, char* argv[]) {
+  std::string save_path;
+  std::string compare_path;
+  double threshold_percent = 10.0;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--save" && i + 1 < argc) {
+      save_path = argv[++i];
+    } else if (arg == "--compare" && i + 1 < argc) {
+      compare_path = argv[++i];
+    } else if (arg == "--threshold" && i + 1 < argc) {
+      threshold_percent = atof(argv[++i]);
+    } else {
+      std::cout << "Unknown bench stages option \"" << arg << "\"" << std::endl;
+      return 1;
+    }
+  }
 
-  std::cout << "Possible flags after " << operation << ": " << std::endl;
-  while (it != options.end()) {
-    std::cout << "[" << index << "]: " << *(it) << std::endl;
-    ++it;
-    ++index;
+  // Read the baseline first so a missing file fails before the long run
+  std::vector<BenchmarkTiming> baseline;
+  if (!compare_path.empty() && !readBaseline(compare_path, baseline)) {
+    std::cout << "Could not read baseline \"" << compare_path << "\"" << std::endl;
+    return 1;
+  }
+
+  std::vector<BenchmarkTiming> timings;
+  if (!benchmarkStages(index, reference_source, { "flags", "wflags" }, timings, std::cout)) {
+    return 1;
+  }
+  if (!save_path.empty()) {
+    if (!writeBaseline(save_path, timings)) {
+      std::cout << "Could not write baseline \"" << save_path << "\"" << std::endl;
+      return 1;
+    }
+    std::cout << "Baseline written to " << save_path << std::endl;
+  }
+  if (!compare_path.empty()) {
+    std::cout << std::endl;
+    return compareBaseline(baseline, timings, threshold_percent, std::cout) ? 0 : 1;
   }
+  return 0;
 }
 
 /**
- * @brief Find flags goes through sequential algorithm steps to find a flag given
- *        a mapping of existing flags
- *          [1]: Calculates color information for test flag
- *          [2]: Narrows down possible flags based on most common color
- *          [3]: Narrows down possible flags based on MCC ratios
- *          [4]: Calculates edge information for test flags and possible flags
- *          [5]: Narrows down possible flags based on edge information
- *          [6]: Calculates quadrant test flag and possible flag information
- *          [7]: Narrowd down possible flags using quadrant information
- * 
- * @pre   No input objects null
- * @post  No change to objects
- * 
- * @param flag_map      map of flag string names based on colorbucket
- * @param color_buckets map of color bucket information
- * @param images        map of images to use to populate flag map
- * @param filename      name of the input image
- * @return a result string with the name of the determined possible flag
+ * @brief Runs the video command, which finds the flag in every frame of a
+ *        video file, image sequence or camera and prints each change of
+ *        the answer, then the sustained frame rate and the share of frames
+ *        that reused the last search
+ *
+ * @param index flag metadata to search
+ * @param plan order of the filters after the MCC filter
+ * @param argc number of arguments
+ * @param argv "video" <file, sequence or camera> [--change share]
+ *             [--refresh N] [--json file] [--knn K] [--rank K]
+ * @return 0 on success
  */
-std::list<std::string> findFlag(const std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::list<std::string>>>>& flag_map,
-                 const std::unordered_map<std::string, ColorBucket>& color_buckets,
-                 const std::unordered_map<std::string, Mat>& images,
-                 const std::string filename) {
-
-  std::cout << "Testing: " << filename << " in program." << std::endl;
-
-  Mat test_file = imread(filename);
-
-  // Print out test image
-  namedWindow("Test Image", WINDOW_NORMAL);
-  resizeWindow("Test Image", test_file.cols, test_file.rows);
-  imshow("Test Image", test_file);
-  waitKey(0);
-
-  // ColorBucket for the input image (image we're looking for)
-  ColorBucket image_bucket = CommonColorFinder::getCommonColorBucket(test_file);
-  std::cout << "Test flag RBG bucket information: " << image_bucket.getRedBucket() <<
-    ", " << image_bucket.getBlueBucket() << ", " << image_bucket.getGreenBucket() << std::endl;
-  std::cout << std::endl; // Line clear
-
-  // Step 1: findClosestFlag to narrow down colorBuckets
-  std::string operation = "MCC filter";
-  std::cout << "--" << operation << "--" << std::endl;
-  std::list<std::string> possible_flags = findClosestFlag(flag_map, image_bucket);
-
-  // Print out remaining options
-  print_options(possible_flags, operation);
-
-  // Early exit
-  if (possible_flags.size() <= 1) {
-    std::cout << "Result found after " << operation << "." << std::endl;
-    return possible_flags;
+int runVideo(const FlagIndex& index, const CascadePlan& plan, int argc, char* argv[]) {
+  std::string source = argv[2];
+  std::string json_path;
+  double change_threshold = FrameStream::kDefaultChangeThreshold;
+  int refresh_frames = FrameStream::kDefaultRefreshFrames;
+  FlagFinder finder(index);
+  finder.setPlan(plan);
+
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 == argc) {
+      std::cout << "Missing value for video option \"" << arg << "\"" << std::endl;
+      return 1;
+    } else if (arg == "--change") {
+      change_threshold = atof(argv[++i]);
+    } else if (arg == "--refresh") {
+      refresh_frames = atoi(argv[++i]);
+    } else if (arg == "--json") {
+      json_path = argv[++i];
+    } else if (arg == "--knn") {
+      finder.setNearestNeighbors(atoi(argv[++i]));
+    } else if (arg == "--rank") {
+      finder.setRanking(atoi(argv[++i]));
+    } else {
+      std::cout << "Unknown video option \"" << arg << "\"" << std::endl;
+      return 1;
+    }
   }
-  std::cout << std::endl; // Line break
 
-  // Step 2: filterRatios to get closer to flag
-  operation = "MCC Ratio Filter";
-  std::cout << "--" << operation << "--" << std::endl;
-  filterRatios(possible_flags, color_buckets, image_bucket);
-
-  // Print out remaining options
-  print_options(possible_flags, operation);
-
-  // Early exit
-  if (possible_flags.size() <= 1) {
-    std::cout << "Result found after " << operation << "." << std::endl;
-    return possible_flags;
+  FrameStream stream(finder, change_threshold, refresh_frames);
+  if (!stream.open(source)) {
+    std::cout << "Could not open video \"" << source << "\"" << std::endl;
+    return 1;
+  }
+  std::ofstream json_file;
+  std::unique_ptr<JsonSink> json;
+  if (!json_path.empty()) {
+    json_file.open(json_path, std::ios::trunc);
+    json.reset(new JsonSink(index, json_file));
   }
-  std::cout << std::endl; // Line break
-
-  // Resize for img dims
-  float change = (float)test_file.rows / 240;
-  float width = (float)test_file.cols / change;
-  Size resizing((int)width, 240);
-  resize(test_file, test_file, resizing, INTER_LINEAR);
-
-  // Step 3: filterCannyEdge count to get closer to flag
-  //std::cout << "Filter with canny edge detection" << std::endl;
-  operation = "Canny Edge Filter";
-  std::cout << "--" << operation << "--" << std::endl;
-  filterCannyEdgeCount(possible_flags, images, test_file);
 
-  // Print out remaining options
-  print_options(possible_flags, operation);
+  // Time of the searched and reused frames, decoding included
+  double searched_ms = 0.0;
+  double reused_ms = 0.0;
+  std::vector<int> shown_flags;
+  bool shown = false;
+  FlagResult result;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point frame_start = start;
+  while (stream.next(result)) {
+    std::chrono::steady_clock::time_point frame_end = std::chrono::steady_clock::now();
+    double frame_ms = std::chrono::duration<double, std::milli>(frame_end - frame_start).count();
+    frame_start = frame_end;
+    bool reused = result.deciding_stage == kStageFrameReuse;
+    (reused ? reused_ms : searched_ms) += frame_ms;
+
+    int64_t frame = stream.getFrameCount() - 1;
+    if (json) {
+      json->write("frame " + std::to_string(frame), stream.getFrame(), result);
+      json->flush();
+    }
+    if (!shown || result.flags != shown_flags) {
+      std::cout << "Frame " << frame << ":";
+      if (result.flags.empty()) {
+        std::cout << " no match";
+      }
+      for (int flag : result.flags) {
+        std::cout << " " << index.getName(flag);
+      }
+      std::cout << " (" << getStageName(result.deciding_stage) << ")" << std::endl;
+      shown_flags = result.flags;
+      shown = true;
+    }
+  }
+  double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  int64_t frames = stream.getFrameCount();
+  int64_t searches = stream.getSearchCount();
+  int64_t reuses = frames - searches;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Frames: " << frames << ", searched " << searches << ", reused " << reuses << std::endl;
+  if (frames > 0) {
+    std::cout << "Skip rate: " << 100.0 * reuses / frames << "%" << std::endl;
+    std::cout << "Sustained: " << frames * 1000.0 / std::max(total_ms, 1e-9) << " frames per second" << std::endl;
+  }
+  if (searches > 0) {
+    std::cout << "Searched frame: " << searched_ms / searches << " ms" << std::endl;
+  }
+  if (reuses > 0) {
+    std::cout << "Reused frame: " << reused_ms / reuses << " ms" << std::endl;
+  }
+  return 0;
+}
 
-  // Early exit
-  if (possible_flags.size() <= 1) {
-    std::cout << "Result found after " << operation << "." << std::endl;
-    return possible_flags;
+/**
+ * @brief Runs the locate command, which finds where a flag is in a larger
+ *        picture, prints the box, then runs the filters on the box alone
+ *
+ * @param index flag metadata to search
+ * @param plan order of the filters after the MCC filter
+ * @param argc number of arguments
+ * @param argv "locate" <image> [--out file]
+ * @return 0 on success
+ */
+int runLocate(const FlagIndex& index, const CascadePlan& plan, int argc, char* argv[]) {
+  std::string filename = argv[2];
+  std::string out_path;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cout << "Unknown locate option \"" << arg << "\"" << std::endl;
+      return 1;
+    }
   }
-  std::cout << std::endl; // Line break
 
-  // Step 4: Repeat steps 1 thru 3 with the upper-left quadrant of the image
-  operation = "Upper Left Quadrant modular filter";
-  std::cout << "--" << operation << "--" << std::endl;
+  Mat image = imread(filename, IMREAD_COLOR);
+  if (image.empty()) {
+    std::cout << "Could not read \"" << filename << "\"" << std::endl;
+    return 1;
+  }
 
-  // Upper left image
-  Mat ul_quadrant = test_file(Range(0, test_file.rows / 2), Range(0, test_file.cols / 2));
+  FlagLocator locator(index);
+  FlagLocation location;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool found = locator.locate(image, location);
+  double locate_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!found) {
+    std::cout << "No flag found in \"" << filename << "\"" << std::endl;
+    return 1;
+  }
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Box: " << location.box.x << "," << location.box.y << " " << location.box.width << "x"
+    << location.box.height << " of " << image.cols << "x" << image.rows << std::endl;
+  std::cout << "Colors: " << index.getName(location.flag) << " (score " << location.score << ")" << std::endl;
+  std::cout << "Located in " << locate_ms << " ms" << std::endl;
+
+  // The filters decide the flag from the box, where the colors and edges
+  // are the flag's own
+  FlagFinder finder(index);
+  finder.setPlan(plan);
+  FlagResult result;
+  finder.findFlag(image(location.box), result);
+  std::cout << "Flag:";
+  if (result.flags.empty()) {
+    std::cout << " no match";
+  }
+  for (int flag : result.flags) {
+    std::cout << " " << index.getName(flag);
+  }
+  std::cout << " (" << getStageName(result.deciding_stage) << ")" << std::endl;
 
-  // Upper left color bucket
-  ColorBucket ul_bucket = CommonColorFinder::getCommonColorBucket(ul_quadrant);
+  if (!out_path.empty()) {
+    rectangle(image, location.box, Scalar(0, 255, 0), std::max(2, image.cols / 400));
+    if (!imwrite(out_path, image)) {
+      std::cout << "Could not write \"" << out_path << "\"" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
 
-  // New maps for upper left quadrants
-  std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::list<std::string>>>> ul_flag_map;
-  std::unordered_map<std::string, ColorBucket> ul_index_color_buckets;
-  std::unordered_map<std::string, Mat> ul_images;
-  std::vector<std::string> poss_flags;
+/**
+ * @brief Runs the memory command, which prints the memory every resident
+ *        part of the program holds, next to what keeping every decoded
+ *        reference image would take
+ *
+ * @param index flag metadata to search
+ * @param argc number of arguments
+ * @param argv "memory" [image]. With an image, it is searched once so the
+ *             buffers of a warm query are counted too.
+ * @return 0 on success
+ */
+int runMemoryReport(const FlagIndex& index, int argc, char* argv[]) {
+
+  // The nearest neighbor tree and ranking features are only built when
+  // asked for, so both are built here to count them
+  FlagFinder finder(index);
+  finder.setNearestNeighbors(1);
+  finder.setRanking(1);
+  finder.setNearestNeighbors(0);
+  finder.setRanking(0);
+
+  std::vector<MemoryUsage> usage;
+  index.getMemoryUsage(usage);
+  finder.getMemoryUsage(usage);
+  if (argc == 3) {
+    FlagScratch scratch;
+    FlagResult result;
+    finder.findFlag(argv[2], result, scratch);
+    if (!result.decoded) {
+      std::cout << "Could not read \"" << argv[2] << "\"" << std::endl;
+      return 1;
+    }
+    usage.push_back({ "query buffers (per thread)", scratch.getMemoryBytes() });
+  }
 
-  // Create upper left metadata
-  for (std::string s : possible_flags) {
-    poss_flags.push_back(s);
-    Mat image = images.at(s);
-    Mat ul_image = image(Range(0, image.rows / 2), Range(0, image.cols / 2));
-    std::pair<std::string, Mat> ul_image_pair(s, ul_image);
-    ul_images.insert(ul_image_pair);
+  size_t total = 0;
+  std::cout << std::fixed << std::setprecision(1);
+  for (const MemoryUsage& line : usage) {
+    std::cout << std::left << std::setw(32) << line.component << std::right << std::setw(12)
+              << line.bytes / 1024.0 << " KB" << std::endl;
+    total += line.bytes;
   }
+  std::cout << std::left << std::setw(32) << "total" << std::right << std::setw(12) << total / 1024.0 << " KB" << std::endl;
 
-  // Build map with metadata
-  buildFlagMap(poss_flags, ul_flag_map, ul_images, ul_index_color_buckets);
+  // Reference pixels are never kept to search, only for showing results
+  size_t thumbnail_bytes = (size_t)WindowSink::kMaxThumbnails * WindowSink::kThumbnailSize * WindowSink::kThumbnailSize * 3;
+  size_t pixel_bytes = 0;
+  for (int id = 0; id < index.getSize(); ++id) {
+    pixel_bytes += (size_t)index.getRecord(id).rows * index.getRecord(id).cols * 3;
+  }
+  std::cout << std::left << std::setw(32) << "window thumbnails (at most)" << std::right << std::setw(12)
+            << thumbnail_bytes / 1024.0 << " KB" << std::endl;
+  std::cout << std::left << std::setw(32) << "decoded references (not kept)" << std::right << std::setw(12)
+            << pixel_bytes / 1024.0 << " KB" << std::endl;
+  return 0;
+}
 
-  // Filtered search through upper left quadrant
-  possible_flags = findClosestFlag(ul_flag_map, ul_bucket);
-  std::cout << "Size of possible flags after MCC: " << possible_flags.size() << std::endl;
+/**
+ * @brief Runs the serve command, which keeps the index loaded and answers
+ *        framed images from stdin or a Unix domain socket with JSON lines.
+ *        Messages go to stderr so stdout only holds responses. Saves of the
+ *        index file are picked up while serving.
+ *
+ * @param index flag metadata to search first, published and then cleared
+ *        so serve doesn't hold the index file open
+ * @param plan order of the filters after the MCC filter
+ * @param index_path index file to watch for changes
+ * @param argc number of arguments
+ * @param argv "serve" [--socket path] [--batch N] [--max-wait-ms N] [--threads N]
+ *             [--metrics file] [--knn K] [--rank K] [--full-decode]
+ * @return 0 on success
+ */
+int runServe(FlagIndex& index, const CascadePlan& plan, const std::string& index_path, int argc, char* argv[]) {
+  std::string socket_path;
+  std::string metrics_path;
+  int batch_size = 8;
+  int max_wait_ms = 5;
+  int num_threads = 0;
+  int nearest_k = 0;
+  int rank_k = 0;
+  bool reduced_decode = true;
+
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--full-decode") {
+      reduced_decode = false;
+    } else if (i + 1 == argc) {
+      std::cerr << "Missing value for serve option \"" << arg << "\"" << std::endl;
+      return 1;
+    } else if (arg == "--socket") {
+      socket_path = argv[++i];
+    } else if (arg == "--batch") {
+      batch_size = atoi(argv[++i]);
+    } else if (arg == "--max-wait-ms") {
+      max_wait_ms = atoi(argv[++i]);
+    } else if (arg == "--threads") {
+      num_threads = atoi(argv[++i]);
+    } else if (arg == "--metrics") {
+      metrics_path = argv[++i];
+    } else if (arg == "--knn") {
+      nearest_k = atoi(argv[++i]);
+    } else if (arg == "--rank") {
+      rank_k = atoi(argv[++i]);
+    } else {
+      std::cerr << "Unknown serve option \"" << arg << "\"" << std::endl;
+      return 1;
+    }
+  }
 
-  // Early exit if possiblity found
-  if (possible_flags.size() == 1) {
-    std::cout << "Result found after " << operation << "." << std::endl;
-    return possible_flags;
-  }
-  
-  //Filter out the flags based on the correct color ratio
-  filterRatios(possible_flags, ul_index_color_buckets, ul_bucket);
-  std::cout << "Size of possible flags after MCC ratio: " << possible_flags.size() << std::endl;
+  // Every snapshot's finder gets the same settings. The plan is checked
+  // against each snapshot, since a reloaded index can have a different
+  // number of flags than the one the plan was made for.
+  FlagMetrics metrics;
+  FlagCatalog catalog([&metrics, &plan, nearest_k, rank_k, reduced_decode](const FlagIndex& snapshot_index,
+                                                                            FlagFinder& finder) {
+    finder.setMetrics(&metrics);
+    finder.setNearestNeighbors(nearest_k);
+    finder.setRanking(rank_k);
+    finder.setReducedDecode(reduced_decode);
+    finder.setPlan(plan.getNumFlags() == snapshot_index.getSize() ? plan : CascadePlan());
+  });
+  catalog.publish(index);
+  catalog.watchFile(index_path);
+  index.clear();
+
+  // Check the index file once a second. Queries keep running on the old
+  // snapshot while a changed file is loaded.
+  std::mutex watch_mutex;
+  std::condition_variable watch_stop;
+  bool serving = true;
+  std::thread watcher([&] {
+    std::unique_lock<std::mutex> lock(watch_mutex);
+    while (!watch_stop.wait_for(lock, std::chrono::seconds(1), [&serving] { return !serving; })) {
+      if (catalog.reloadIfChanged(std::cerr)) {
+        int num_flags = catalog.acquire()->index.getSize();
+        std::cerr << "Reloaded " << num_flags << " flags from \"" << index_path << "\"" << std::endl;
+        if (plan.getNumFlags() > 0 && plan.getNumFlags() != num_flags) {
+          std::cerr << "Cascade plan was made for " << plan.getNumFlags() << " flags, using the fixed filter order "
+                    << "(run \"plan\" again)." << std::endl;
+        }
+      }
+    }
+  });
 
-  // Early exit
-  if (possible_flags.size() == 1) {
-    std::cout << "Result found after " << operation << "." << std::endl;
-    return possible_flags;
+  int status = 0;
+  {
+    FlagService service(catalog, num_threads, batch_size, max_wait_ms);
+    if (!metrics_path.empty()) {
+      service.setMetricsFile(&metrics, metrics_path);
+    }
+    if (!socket_path.empty()) {
+      std::cerr << "Serving " << catalog.acquire()->index.getSize() << " flags on \"" << socket_path << "\"" << std::endl;
+      status = service.serveSocket(socket_path) ? 0 : 1;
+    } else {
+#ifdef _WIN32
+      // Frames are binary, stop Windows from translating line endings
+      _setmode(_fileno(stdin), _O_BINARY);
+#endif
+      std::cerr << "Serving " << catalog.acquire()->index.getSize() << " flags on stdin" << std::endl;
+      int64_t answered = service.serveStream(std::cin, std::cout);
+      std::cerr << "Answered " << answered << " requests" << std::endl;
+    }
   }
 
-  //Filter out possible flags based on the canny edge algorithm
-  filterCannyEdgeCount(possible_flags, ul_images, ul_quadrant);
-  std::cout << "Size of possible flags after Edge Ratio: " << possible_flags.size() << std::endl;
-  std::cout << "Result found after " << operation << "." << std::endl;
+  {
+    std::lock_guard<std::mutex> lock(watch_mutex);
+    serving = false;
+  }
+  watch_stop.notify_all();
+  watcher.join();
+  return status;
+}
 
-  return possible_flags;
+/**
+ * @brief Chooses the color scheme histograms are counted in for the whole
+ *        run: the one given with --colors to the index build or bench
+ *        histogram, BGR for an index build without it, or else the one the
+ *        index file was saved in
+ *
+ * @param index_path index file to read the scheme of
+ * @param argc number of arguments
+ * @param argv arguments of the program
+ * @param scheme scheme to fill
+ * @return false if --colors names no scheme
+ */
+bool chooseColorScheme(const std::string& index_path, int argc, char* argv[], ColorScheme& scheme) {
+  std::string command = argc >= 2 ? argv[1] : "";
+  std::string subcommand = argc >= 3 ? argv[2] : "";
+  bool index_build = command == "index" && subcommand != "add" && subcommand != "replace" && subcommand != "remove";
+  bool bench_histogram = command == "bench" && subcommand == "histogram";
+
+  // A missing index keeps BGR, and is built in it
+  scheme = kColorBgr;
+  if (!index_build) {
+    FlagIndex::readColorScheme(index_path, scheme);
+  }
+  if (!index_build && !bench_histogram) {
+    return true;
+  }
+  for (int i = 2; i + 1 < argc; ++i) {
+    if (std::string(argv[i]) == "--colors" && !ColorQuantizer::parseScheme(argv[++i], scheme)) {
+      std::cout << "Unknown color scheme \"" << argv[i] << "\" (bgr, lab or hsv)" << std::endl;
+      return false;
+    }
+  }
+  return true;
 }
 
 /**
@@ -540,53 +930,158 @@ std::list<std::string> findFlag(const std::unordered_map<int, std::unordered_map
  * @return
  */
 int main(int argc, char* argv[]) {
-  if (argc < 3) {
-    std::cout << "Minimum number of arguments: 3" << std::endl;
-    std::cout << "<number of files N to test> <file 1> <file 2> ... <file N>" << std::endl;
-    return 0;
+
+  // Reference flags to index, one line per flag image in flags/
+  const std::string reference_source = "flags/references.txt";
+
+  // Index file with the metadata of the reference flags
+  const std::string index_path = "flags/flags.idx";
+
+  // Order of the filters after the MCC filter, made by the plan command
+  const std::string plan_path = "flags/flags.plan";
+
+  // Histograms are counted in one color scheme for the whole run, chosen
+  // here before any search or worker thread starts
+  ColorScheme scheme;
+  if (!chooseColorScheme(index_path, argc, argv, scheme)) {
+    return 1;
+  }
+  ColorQuantizer::select(scheme);
+
+  // "index add", "index replace" and "index remove" change one flag
+  if (argc >= 4 && std::string(argv[1]) == "index") {
+    std::string command = argv[2];
+    if (((command == "add" || command == "replace") && (argc == 5 || argc == 6)) ||
+        (command == "remove" && argc == 4)) {
+      return runIndexUpdate(index_path, argc, argv);
+    }
   }
 
-  // file names
-  std::vector<std::string> index_filenames = {
-    "Alaska", "Alabama", "Arkansas", "Arizona", "California",
-    "Colorado", "Connecticut", "Delaware", "Florida", "Georgia",
-    "Hawaii", "Iowa", "Idaho", "Illinois", "Indiana",
-    "Kansas", "Kentucky", "Louisiana", "Massachusetts", "Maryland",
-    "Maine", "Michigan", "Minnesota", "Missouri", "Mississippi",
-    "Montana", "North Carolina", "North Dakota", "Nebraska", "New Hampshire",
-    "New Jersey", "New Mexico", "Nevada", "New York", "Ohio",
-    "Oklahoma", "Oregon", "Pennsylvania", "Rhode Island", "South Carolina",
-    "South Dakota", "Tennessee", "Texas", "Utah", "Virginia",
-    "Vermont", "Washington", "Wisconsin", "West Virginia", "Wyoming"
-  };
+  // "index" command builds the index file once and exits
+  if (argc >= 2 && std::string(argv[1]) == "index") {
+    return runIndexBuild(reference_source, index_path, argc, argv);
+  }
+
+  // "bench histogram" times the histogram against the per pixel version
+  if (argc >= 3 && std::string(argv[1]) == "bench" && std::string(argv[2]) == "histogram") {
+    return benchmarkHistogram(std::cout) ? 0 : 1;
+  }
 
-  // Map of file names to images for creating image metadata
-  std::unordered_map<std::string, Mat> images;
+  // "bench edges" times the fused edge ratio against the OpenCV chain
+  if (argc == 3 && std::string(argv[1]) == "bench" && std::string(argv[2]) == "edges") {
+    return benchmarkEdges(std::cout) ? 0 : 1;
+  }
 
-  // Read 50 flag images and store map
-  for (std::string x : index_filenames) {
-    Mat index_file = imread("flags/" + x + ".jpg");
-    std::pair<std::string, Mat> index_entry(x, index_file);
-    images.insert(index_entry);
+  // "bench decode" checks reduced jpg decoding against full size decoding
+  if (argc >= 4 && std::string(argv[1]) == "bench" && std::string(argv[2]) == "decode") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    int num_threads = argc >= 6 && std::string(argv[4]) == "--threads" ? atoi(argv[5]) : 0;
+    return benchmarkDecode(index, argv[3], num_threads, std::cout) ? 0 : 1;
   }
 
-  // 3 Layered Map structure Stores flag names
-  std::unordered_map<int, std::unordered_map<int, std::unordered_map<int, std::list<std::string>>>> flag_map;
+  // "bench alloc" checks a warm query doesn't allocate
+  if (argc == 4 && std::string(argv[1]) == "bench" && std::string(argv[2]) == "alloc") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return benchmarkAllocations(index, argv[3], std::cout) ? 0 : 1;
+  }
+
+  if (argc >= 3 && std::string(argv[1]) == "bench" && std::string(argv[2]) == "stages") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return runStageBenchmarks(index, reference_source, argc, argv);
+  }
 
-  // Histograms of 50 flag images for image metadata
-  std::unordered_map<std::string, Mat> histograms;
-  for (std::string s : index_filenames) {
-    std::pair<std::string, Mat> histogram_entry(s, CommonColorFinder::populateHistogram(images.at(s)));
-    histograms.insert(histogram_entry);
+  // "batch" command tests a directory or manifest of images without windows
+  if (argc >= 3 && std::string(argv[1]) == "batch") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return runBatch(index, loadCascadePlan(plan_path, index, std::cout), argc, argv);
   }
 
-  // Map of color buckets created for flag metadata
-  std::unordered_map<std::string, ColorBucket> index_color_buckets;
+  // "video" command follows the flag through a stream of frames
+  if (argc >= 3 && std::string(argv[1]) == "video") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return runVideo(index, loadCascadePlan(plan_path, index, std::cout), argc, argv);
+  }
 
-  // flag_map maps red bucket in ints to a corresponding map of blue bucket
-  // next layer maps blue bucket int to a corresponding map of green bucket
-  // green bucket maps int bucket to a string
-  buildFlagMap(index_filenames, flag_map, images, index_color_buckets);
+  // "memory" command reports what each part of the program holds
+  if ((argc == 2 || argc == 3) && std::string(argv[1]) == "memory") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return runMemoryReport(index, argc, argv);
+  }
+
+  // "locate" command finds the box of a flag in a larger picture
+  if (argc >= 3 && std::string(argv[1]) == "locate") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return runLocate(index, loadCascadePlan(plan_path, index, std::cout), argc, argv);
+  }
+
+  // "plan" command orders the filters from labeled test images
+  if (argc == 3 && std::string(argv[1]) == "plan") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+      return 1;
+    }
+    return runPlan(index, plan_path, argv[2]);
+  }
+
+  // "serve" command answers a stream of images until the input ends
+  if (argc >= 2 && std::string(argv[1]) == "serve") {
+    FlagIndex index;
+    if (!loadFlagIndex(index, reference_source, index_path, std::cerr)) {
+      return 1;
+    }
+    return runServe(index, loadCascadePlan(plan_path, index, std::cerr), index_path, argc, argv);
+  }
+
+  if (argc < 3) {
+    std::cout << "Minimum number of arguments: 3" << std::endl;
+    std::cout << "<number of files N to test> <file 1> <file 2> ... <file N> [--no-console] [--no-windows] [--json file] [--knn K] [--rank K] [--full-decode]" << std::endl;
+    std::cout << "or: index [--refs <directory or manifest>] [--threads N] [--colors bgr|lab|hsv]   (build " << index_path << " from the flag images)" << std::endl;
+    std::cout << "or: index add <name> <image> [group] | index replace <name> <image> [group] | index remove <name>" << std::endl;
+    std::cout << "or: batch <directory or manifest> [output prefix] [--threads N] [--metrics file] [--knn K] [--rank K] [--full-decode]" << std::endl;
+    std::cout << "or: video <file, sequence or camera> [--change share] [--refresh N] [--json file] [--knn K] [--rank K]" << std::endl;
+    std::cout << "or: locate <image> [--out file]   (find the box of a flag in a larger picture)" << std::endl;
+    std::cout << "or: plan <directory or manifest>   (order the filters from labeled images into " << plan_path << ")" << std::endl;
+    std::cout << "or: serve [--socket path] [--batch N] [--max-wait-ms N] [--threads N] [--metrics file] [--knn K] [--rank K] [--full-decode]" << std::endl;
+    std::cout << "or: memory [image]   (print the memory each part holds)" << std::endl;
+    std::cout << "or: bench histogram [--colors bgr|lab|hsv]" << std::endl;
+    std::cout << "or: bench edges" << std::endl;
+    std::cout << "or: bench decode <directory or manifest> [--threads N]" << std::endl;
+    std::cout << "or: bench alloc <image>" << std::endl;
+    std::cout << "or: bench stages [--save file] [--compare file] [--threshold percent]" << std::endl;
+    return 0;
+  }
+
+  // Load flag metadata from the index file
+  FlagIndex index;
+  if (!loadFlagIndex(index, reference_source, index_path, std::cout)) {
+    return 1;
+  }
+
+  // Filters keep every step so the console can list them
+  FlagFinder finder(index);
+  finder.setTrace(true);
+  finder.setPlan(loadCascadePlan(plan_path, index, std::cout));
 
   //Check to see if we have valid input, else throw an error
   unsigned int num_args = -1;
@@ -605,7 +1100,47 @@ int main(int argc, char* argv[]) {
     test_file_names.push_back(val);
   };
 
+  // Options after the file names choose where results are reported, the
+  // console and windows unless turned off
+  bool console_output = true;
+  bool window_output = true;
+  std::string json_path;
+  for (int i = num_args + 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--no-console") {
+      console_output = false;
+    } else if (arg == "--no-windows") {
+      window_output = false;
+    } else if (arg == "--json" && i + 1 < argc) {
+      json_path = argv[++i];
+    } else if (arg == "--knn" && i + 1 < argc) {
+      finder.setNearestNeighbors(atoi(argv[++i]));
+    } else if (arg == "--rank" && i + 1 < argc) {
+      finder.setRanking(atoi(argv[++i]));
+    } else if (arg == "--full-decode") {
+      finder.setReducedDecode(false);
+    }
+  }
+
+  ConsoleSink console(index, std::cout);
+  WindowSink windows(index);
+  std::ofstream json_file;
+  std::unique_ptr<JsonSink> json;
+  std::vector<ResultSink*> sinks;
+  if (console_output) {
+    sinks.push_back(&console);
+  }
+  if (!json_path.empty()) {
+    json_file.open(json_path, std::ios::trunc);
+    json.reset(new JsonSink(index, json_file));
+    sinks.push_back(json.get());
+  }
+  if (window_output) {
+    sinks.push_back(&windows);
+  }
+
   // Loop findFlag num_args times
+  FlagScratch scratch;
   for (unsigned int i = 0; i < num_args; ++i) {
 
     // test file name
@@ -614,27 +1149,15 @@ int main(int argc, char* argv[]) {
     filename = "flags/" + x + ".jpg";
 
     // Algorithmic runner
-    std::list<std::string> flag_result = findFlag(flag_map, index_color_buckets, images, filename);
-
-    // No matches found
-    if (flag_result.size() == 0) {
-      std::cout << "No matches found for \"" << filename << "\"" << std::endl;
-      waitKey(0);
-      continue;
-    }
-
-    for (std::string flag_name : flag_result) {
-      // Result printer
-      std::string result = "Result: " + flag_name;
-      std::cout << "The flag in the image is from: " << flag_name << std::endl;
+    FlagResult result;
+    finder.findFlag(filename, result, scratch);
 
-      // Show result flag
-      namedWindow(result, WINDOW_NORMAL);
-      resizeWindow(result, images.at(flag_name).cols, images.at(flag_name).rows);
-      imshow(result, images.at(flag_name));
-      waitKey(0);
+    // Report once the search is done, text before the windows wait for keys
+    for (ResultSink* sink : sinks) {
+      sink->write(filename, scratch.test_file, result);
+      sink->flush();
     }
   }
 
   return 0;
-}
\ No newline at end of file
+}